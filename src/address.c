@@ -0,0 +1,116 @@
+/**
+ * @file address.c
+ * @brief Implementation of Ethereum address decoding.
+ * @defgroup address Wallet Addresses
+ * @{
+ */
+
+#include "address.h"
+#include "simd_parse.h"
+
+/**
+ * @def KECCAK_RATE
+ * @brief Bytes absorbed per Keccak-256 permutation.
+ */
+#define KECCAK_RATE 136
+
+static const uint64_t keccak_round_constants[24] = {
+    0x0000000000000001ull, 0x0000000000008082ull, 0x800000000000808Aull, 0x8000000080008000ull,
+    0x000000000000808Bull, 0x0000000080000001ull, 0x8000000080008081ull, 0x8000000000008009ull,
+    0x000000000000008Aull, 0x0000000000000088ull, 0x0000000080008009ull, 0x000000008000000Aull,
+    0x000000008000808Bull, 0x800000000000008Bull, 0x8000000000008089ull, 0x8000000000008003ull,
+    0x8000000000008002ull, 0x8000000000000080ull, 0x000000000000800Aull, 0x800000008000000Aull,
+    0x8000000080008081ull, 0x8000000000008080ull, 0x0000000080000001ull, 0x8000000080008008ull,
+};
+
+static const unsigned keccak_rotations[24] = {
+    1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44,
+};
+
+static const unsigned keccak_lanes[24] = {
+    10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1,
+};
+
+/**
+ * @brief Rotates a lane left.
+ */
+static inline uint64_t rotl64(uint64_t x, unsigned n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+/**
+ * @brief Applies the Keccak-f[1600] permutation.
+ * @param st The state, 25 lanes.
+ */
+static void keccak_f1600(uint64_t st[25]) {
+    uint64_t bc[5];
+    for (int round = 0; round < 24; round++) {
+        // Theta
+        for (int i = 0; i < 5; i++) bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+        for (int i = 0; i < 5; i++) {
+            uint64_t t = bc[(i + 4) % 5] ^ rotl64(bc[(i + 1) % 5], 1);
+            for (int j = 0; j < 25; j += 5) st[j + i] ^= t;
+        }
+        // Rho and pi
+        uint64_t t = st[1];
+        for (int i = 0; i < 24; i++) {
+            unsigned j = keccak_lanes[i];
+            uint64_t next = st[j];
+            st[j] = rotl64(t, keccak_rotations[i]);
+            t = next;
+        }
+        // Chi
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; i++) bc[i] = st[j + i];
+            for (int i = 0; i < 5; i++) st[j + i] ^= ~bc[(i + 1) % 5] & bc[(i + 2) % 5];
+        }
+        // Iota
+        st[0] ^= keccak_round_constants[round];
+    }
+}
+
+/**
+ * @brief Decodes the text form of an address.
+ * @param s The first character of the address.
+ * @param len The number of characters in the address.
+ * @param out Receives the decoded address.
+ * @return 0 on success, -1 if the text is not a valid address.
+ */
+int address_parse(const char *s, size_t len, address_t *out) {
+    if (len != ADDRESS_HEX_LEN || s[0] != '0' || (s[1] != 'x' && s[1] != 'X')) return -1;
+
+    return simd_hex40_decode(s + 2, out->bytes);
+}
+
+/**
+ * @brief Writes the EIP-55 checksummed text form of an address.
+ * @param address The address.
+ * @param out Where to write ADDRESS_HEX_LEN characters; no NUL is added.
+ * @return out + ADDRESS_HEX_LEN.
+ */
+char *address_format(const address_t *address, char *out) {
+    static const char hex[] = "0123456789abcdef";
+    char *digits = out + 2;
+    for (int i = 0; i < ADDRESS_BYTES; i++) {
+        digits[2 * i] = hex[address->bytes[i] >> 4];
+        digits[2 * i + 1] = hex[address->bytes[i] & 0xF];
+    }
+
+    // Keccak-256 of the 40 lowercase digits: a single block, padded with 0x01 ... 0x80.
+    uint64_t st[25] = {0};
+    for (int i = 0; i < 2 * ADDRESS_BYTES; i++) st[i / 8] ^= (uint64_t)(uint8_t)digits[i] << (8 * (i % 8));
+    st[2 * ADDRESS_BYTES / 8] ^= (uint64_t)0x01 << (8 * (2 * ADDRESS_BYTES % 8));
+    st[(KECCAK_RATE - 1) / 8] ^= (uint64_t)0x80 << (8 * ((KECCAK_RATE - 1) % 8));
+    keccak_f1600(st);
+
+    for (int i = 0; i < 2 * ADDRESS_BYTES; i++) {
+        uint8_t byte = (uint8_t)(st[i / 16] >> (8 * (i / 2 % 8)));
+        uint8_t nibble = i % 2 ? byte & 0xF : byte >> 4;
+        if (digits[i] >= 'a' && nibble >= 8) digits[i] = (char)(digits[i] - 'a' + 'A');
+    }
+    out[0] = '0';
+    out[1] = 'x';
+    return out + ADDRESS_HEX_LEN;
+}
+
+ /** @} */
@@ -0,0 +1,83 @@
+/**
+ * @file address.h
+ * @brief Defines the binary representation of Ethereum wallet addresses.
+ *
+ * Addresses are decoded once, at parse time, from their 42-character `0x`-hex
+ * text form into 20 raw bytes. Every later comparison and hash works on that
+ * fixed-width key, so no strlen or byte-by-byte string hashing is needed.
+ */
+
+#ifndef D3A8E2F1_6C4B_4A97_B15E_0F72C9D4A8B3
+#define D3A8E2F1_6C4B_4A97_B15E_0F72C9D4A8B3
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @def ADDRESS_BYTES
+ * @brief The size of a binary Ethereum address.
+ */
+#define ADDRESS_BYTES 20
+
+/**
+ * @def ADDRESS_HEX_LEN
+ * @brief The length of the text form of an address: "0x" followed by 40 hex digits.
+ */
+#define ADDRESS_HEX_LEN 42
+
+/**
+ * @struct address_t
+ * @brief A 20-byte binary Ethereum address.
+ */
+typedef struct {
+    uint8_t bytes[ADDRESS_BYTES]; /**< The address bytes, most significant first. */
+} address_t;
+
+/**
+ * @brief Decodes the text form of an address.
+ *
+ * Accepts "0x" or "0X" followed by exactly 40 hexadecimal digits in any case,
+ * so checksummed and lowercase spellings of a wallet map to the same key.
+ *
+ * @param s The first character of the address. It does not need to be NUL-terminated.
+ * @param len The number of characters in the address.
+ * @param out Receives the decoded address.
+ * @return 0 on success, -1 if the text is not a valid address.
+ */
+int address_parse(const char *s, size_t len, address_t *out);
+
+/**
+ * @brief Writes the EIP-55 checksummed text form of an address.
+ *
+ * The hex digits are lowercase, except that a letter is uppercased when the
+ * matching nibble of the Keccak-256 hash of the lowercase digits is 8 or more.
+ *
+ * @param address The address.
+ * @param out Where to write ADDRESS_HEX_LEN characters; no NUL is added.
+ * @return out + ADDRESS_HEX_LEN.
+ */
+char *address_format(const address_t *address, char *out);
+
+/**
+ * @brief Hashes a binary address.
+ *
+ * Addresses are the tail of a Keccak hash, so their bytes are already well
+ * distributed. Three fixed-size loads and a multiply-fold are enough, with no
+ * loop or length-dependent branch.
+ *
+ * @param key Pointer to ADDRESS_BYTES bytes.
+ * @return A 32-bit hash value.
+ */
+static inline uint32_t address_hash(const void *key) {
+    uint64_t a, b;
+    uint32_t c;
+    memcpy(&a, (const uint8_t *)key, 8);
+    memcpy(&b, (const uint8_t *)key + 8, 8);
+    memcpy(&c, (const uint8_t *)key + 16, 4);
+
+    uint64_t h = (a ^ (b * 0x9E3779B97F4A7C15ull) ^ c) * 0xBF58476D1CE4E5B9ull;
+    return (uint32_t)(h >> 32) ^ (uint32_t)h;
+}
+
+#endif /* D3A8E2F1_6C4B_4A97_B15E_0F72C9D4A8B3 */
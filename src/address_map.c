@@ -0,0 +1,180 @@
+/**
+ * @file address_map.c
+ * @brief Implementation of the open-addressing address map.
+ * @defgroup address_map Address Map
+ * @{
+ */
+
+#include "address_map.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @def ADDRESS_MAP_MIN_CAPACITY
+ * @brief Smallest slot array ever allocated.
+ */
+#define ADDRESS_MAP_MIN_CAPACITY 1024
+
+/**
+ * @brief Allocates a slot array with every slot marked empty.
+ * @param capacity The number of slots.
+ * @return The slot array, or NULL on allocation failure.
+ */
+static address_map_slot_t *alloc_slots(size_t capacity) {
+    address_map_slot_t *slots = malloc(capacity * sizeof(address_map_slot_t));
+    if (!slots) return NULL;
+    for (size_t i = 0; i < capacity; i++) {
+        slots[i].index = ADDRESS_MAP_EMPTY;
+    }
+    return slots;
+}
+
+/**
+ * @brief Returns the slot holding key, or the empty slot where it would be inserted.
+ * @param slots The slot array.
+ * @param mask capacity - 1.
+ * @param key The wallet address.
+ * @return The matching or first empty slot.
+ */
+static inline address_map_slot_t *probe(address_map_slot_t *slots, size_t mask, const address_t *key) {
+    size_t i = address_hash(key->bytes) & mask;
+    for (;;) {
+        address_map_slot_t *slot = &slots[i];
+        if (slot->index == ADDRESS_MAP_EMPTY || memcmp(slot->key.bytes, key->bytes, ADDRESS_BYTES) == 0) {
+            return slot;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+/**
+ * @brief Moves every entry into a slot array twice as large.
+ * @param map The map.
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int grow(address_map_t *map) {
+    size_t capacity = map->capacity * 2;
+    address_map_slot_t *slots = alloc_slots(capacity);
+    if (!slots) return -1;
+
+    for (size_t i = 0; i < map->capacity; i++) {
+        const address_map_slot_t *old = &map->slots[i];
+        if (old->index != ADDRESS_MAP_EMPTY) {
+            *probe(slots, capacity - 1, &old->key) = *old;
+        }
+    }
+    free(map->slots);
+    map->slots = slots;
+    map->capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Creates a map sized to hold expected keys without growing.
+ * @param expected Estimated number of distinct wallets; 0 picks a small default.
+ * @return A pointer to the map, or NULL on allocation failure.
+ */
+address_map_t *address_map_create(size_t expected) {
+    address_map_t *map = malloc(sizeof(address_map_t));
+    if (!map) return NULL;
+
+    size_t capacity = ADDRESS_MAP_MIN_CAPACITY;
+    while (capacity * ADDRESS_MAP_MAX_LOAD / 100 < expected) capacity *= 2;
+
+    map->slots = alloc_slots(capacity);
+    if (!map->slots) {
+        free(map);
+        return NULL;
+    }
+    map->capacity = capacity;
+    map->count = 0;
+    return map;
+}
+
+/**
+ * @brief Frees the map and its slot array.
+ * @param map The map to be freed.
+ */
+void address_map_free(address_map_t *map) {
+    if (!map) return;
+    free(map->slots);
+    free(map);
+}
+
+/**
+ * @brief Returns the index of a key, adding it with the next free index if absent.
+ * @param map The map.
+ * @param key The wallet address.
+ * @param inserted If not NULL, set to 1 when the key was added and 0 when it already existed.
+ * @return The index of the key, or ADDRESS_MAP_EMPTY if the table could not grow.
+ */
+uint32_t address_map_intern(address_map_t *map, const address_t *key, int *inserted) {
+    address_map_slot_t *slot = probe(map->slots, map->capacity - 1, key);
+    if (slot->index != ADDRESS_MAP_EMPTY) {
+        if (inserted) *inserted = 0;
+        return slot->index;
+    }
+
+    if ((map->count + 1) * 100 > map->capacity * ADDRESS_MAP_MAX_LOAD) {
+        if (grow(map) != 0) return ADDRESS_MAP_EMPTY;
+        slot = probe(map->slots, map->capacity - 1, key);
+    }
+
+    slot->key = *key;
+    slot->index = (uint32_t)map->count++;
+    if (inserted) *inserted = 1;
+    return slot->index;
+}
+
+/**
+ * @brief Looks up a key.
+ * @param map The map.
+ * @param key The wallet address.
+ * @return The index of the key, or ADDRESS_MAP_EMPTY if it is not in the map.
+ */
+uint32_t address_map_find(const address_map_t *map, const address_t *key) {
+    return probe(map->slots, map->capacity - 1, key)->index;
+}
+
+/**
+ * @brief Builds a read-only index of an address table.
+ * @param keys The address table. Its addresses must be distinct.
+ * @param count The number of addresses.
+ * @param capacity Receives the number of slots.
+ * @return The index, or NULL on allocation failure.
+ */
+uint32_t *address_index_build(const address_t *keys, size_t count, size_t *capacity) {
+    size_t slots = ADDRESS_MAP_MIN_CAPACITY;
+    while (slots < 2 * count) slots *= 2;
+    uint32_t *index = calloc(slots, sizeof(uint32_t));
+    if (!index) return NULL;
+
+    size_t mask = slots - 1;
+    for (size_t k = 0; k < count; k++) {
+        size_t i = address_hash(keys[k].bytes) & mask;
+        while (index[i] != 0) i = (i + 1) & mask;
+        index[i] = (uint32_t)(k + 1);
+    }
+    *capacity = slots;
+    return index;
+}
+
+/**
+ * @brief Looks up a key in an index built by address_index_build().
+ * @param index The index.
+ * @param capacity The number of slots of the index.
+ * @param keys The address table the index was built from.
+ * @param key The wallet address.
+ * @return The position of the key in keys, or ADDRESS_MAP_EMPTY if it is not there.
+ */
+uint32_t address_index_find(const uint32_t *index, size_t capacity, const address_t *keys, const address_t *key) {
+    size_t mask = capacity - 1;
+    for (size_t i = address_hash(key->bytes) & mask;; i = (i + 1) & mask) {
+        uint32_t position = index[i];
+        if (position == 0) return ADDRESS_MAP_EMPTY;
+        if (memcmp(keys[position - 1].bytes, key->bytes, ADDRESS_BYTES) == 0) return position - 1;
+    }
+}
+
+ /** @} */
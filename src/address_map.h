@@ -0,0 +1,112 @@
+/**
+ * @file address_map.h
+ * @brief Defines a flat open-addressing hash map from wallet addresses to vertex indices.
+ *
+ * All entries live inline in one power-of-two slot array probed linearly, so an
+ * insertion costs no allocation and a lookup touches one or two cache lines.
+ * The table can be pre-sized from an estimate of the number of wallets and is
+ * rehashed into a twice larger array when it gets too full.
+ *
+ * A frozen address table can instead get a read-only index (address_index_*),
+ * a bare slot array that is stored next to the table in a snapshot and probed
+ * straight from the mapping. Its layout depends on address_hash(), which is
+ * therefore part of the snapshot format.
+ */
+
+#ifndef F1C07B2E_94A3_4D6F_8E25_3B6A0D9C7E41
+#define F1C07B2E_94A3_4D6F_8E25_3B6A0D9C7E41
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "address.h"
+
+/**
+ * @def ADDRESS_MAP_EMPTY
+ * @brief Value stored in unused slots. It is never a valid index.
+ */
+#define ADDRESS_MAP_EMPTY UINT32_MAX
+
+/**
+ * @def ADDRESS_MAP_MAX_LOAD
+ * @brief Maximum fill ratio, in percent, before the table grows.
+ */
+#define ADDRESS_MAP_MAX_LOAD 70
+
+/**
+ * @struct address_map_slot_t
+ * @brief One slot of the table: a key and the index it maps to.
+ */
+typedef struct {
+    address_t key;   /**< The wallet address. */
+    uint32_t index;  /**< The index of the wallet, or ADDRESS_MAP_EMPTY. */
+} address_map_slot_t;
+
+/**
+ * @struct address_map_t
+ * @brief An open-addressing table with linear probing.
+ */
+typedef struct {
+    address_map_slot_t *slots; /**< The slot array. */
+    size_t capacity;           /**< Number of slots, always a power of two. */
+    size_t count;              /**< Number of keys stored. */
+} address_map_t;
+
+/**
+ * @brief Creates a map sized to hold expected keys without growing.
+ * @param expected Estimated number of distinct wallets; 0 picks a small default.
+ * @return A pointer to the map, or NULL on allocation failure.
+ */
+address_map_t *address_map_create(size_t expected);
+
+/**
+ * @brief Frees the map and its slot array.
+ * @param map The map to be freed.
+ */
+void address_map_free(address_map_t *map);
+
+/**
+ * @brief Returns the index of a key, adding it with the next free index if absent.
+ *
+ * New keys get index map->count, so indices are dense and follow insertion order.
+ *
+ * @param map The map.
+ * @param key The wallet address.
+ * @param inserted If not NULL, set to 1 when the key was added and 0 when it already existed.
+ * @return The index of the key, or ADDRESS_MAP_EMPTY if the table could not grow.
+ */
+uint32_t address_map_intern(address_map_t *map, const address_t *key, int *inserted);
+
+/**
+ * @brief Looks up a key.
+ * @param map The map.
+ * @param key The wallet address.
+ * @return The index of the key, or ADDRESS_MAP_EMPTY if it is not in the map.
+ */
+uint32_t address_map_find(const address_map_t *map, const address_t *key);
+
+/**
+ * @brief Builds a read-only index of an address table.
+ *
+ * The index is an open-addressing array of positions in the table, stored as
+ * position + 1 with 0 for an empty slot; it holds no keys and resolves them in
+ * the table it was built from.
+ *
+ * @param keys The address table. Its addresses must be distinct.
+ * @param count The number of addresses.
+ * @param capacity Receives the number of slots, a power of two at least twice count.
+ * @return The index, or NULL on allocation failure.
+ */
+uint32_t *address_index_build(const address_t *keys, size_t count, size_t *capacity);
+
+/**
+ * @brief Looks up a key in an index built by address_index_build().
+ * @param index The index.
+ * @param capacity The number of slots of the index.
+ * @param keys The address table the index was built from.
+ * @param key The wallet address.
+ * @return The position of the key in keys, or ADDRESS_MAP_EMPTY if it is not there.
+ */
+uint32_t address_index_find(const uint32_t *index, size_t capacity, const address_t *keys, const address_t *key);
+
+#endif /* F1C07B2E_94A3_4D6F_8E25_3B6A0D9C7E41 */
@@ -0,0 +1,192 @@
+/**
+ * @file block_queue.c
+ * @brief Implementation of the MPSC block queue.
+ * @defgroup block_queue Block Queue
+ * @{
+ */
+
+#include "block_queue.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdlib.h>
+
+/**
+ * @struct block_queue_t
+ * @brief The internal structure of the queue.
+ *
+ * The queued blocks form a singly linked list from head to tail that always
+ * starts with a node the consumer already took (initially the stub). A
+ * producer swaps itself in as the tail and then links the old tail to it, so
+ * for a moment the list can be cut between those two steps; the consumer then
+ * waits for the link.
+ */
+struct block_queue_t {
+    queue_block_t *tail;         /**< The last pushed node; accessed atomically. */
+    queue_block_t *head;         /**< The node before the next one to pop. Consumer only. */
+    queue_block_t stub;          /**< Placeholder node that keeps the list non-empty. */
+    sem_t filled;                /**< Counts pushed blocks, plus one once closed. */
+    sem_t room;                  /**< Counts the blocks that may still leave the pool. */
+    int closed;                  /**< Set by block_queue_close(); accessed atomically. */
+    pthread_mutex_t pool_lock;   /**< Guards pool. */
+    queue_block_t *pool;         /**< Released blocks of block_size, ready for reuse. */
+    size_t block_size;           /**< The capacity of a pooled block. */
+};
+
+/**
+ * @brief Creates a queue.
+ * @param block_size The capacity of a pooled block.
+ * @param max_blocks The most blocks out of the pool at once.
+ * @return The queue, or NULL on allocation failure.
+ */
+block_queue_t *block_queue_create(size_t block_size, size_t max_blocks) {
+    block_queue_t *queue = calloc(1, sizeof(block_queue_t));
+    if (!queue) return NULL;
+    queue->tail = &queue->stub;
+    queue->head = &queue->stub;
+    queue->block_size = block_size;
+    sem_init(&queue->filled, 0, 0);
+    sem_init(&queue->room, 0, (unsigned)max_blocks);
+    pthread_mutex_init(&queue->pool_lock, NULL);
+    return queue;
+}
+
+/**
+ * @brief Takes an empty block, waiting while max_blocks are out of the pool.
+ * @param queue The queue.
+ * @param min_capacity The least capacity needed.
+ * @return The block, with size 0, or NULL on allocation failure.
+ */
+queue_block_t *block_queue_acquire(block_queue_t *queue, size_t min_capacity) {
+    while (sem_wait(&queue->room) != 0) {} // Retry if interrupted by a signal.
+
+    queue_block_t *block = NULL;
+    size_t capacity = min_capacity > queue->block_size ? min_capacity : queue->block_size;
+    if (capacity == queue->block_size) {
+        pthread_mutex_lock(&queue->pool_lock);
+        block = queue->pool;
+        if (block) queue->pool = block->next;
+        pthread_mutex_unlock(&queue->pool_lock);
+    }
+    if (!block) {
+        block = malloc(sizeof(queue_block_t) + capacity);
+        if (!block) {
+            sem_post(&queue->room);
+            return NULL;
+        }
+        block->capacity = capacity;
+    }
+    block->next = NULL;
+    block->size = 0;
+    return block;
+}
+
+/**
+ * @brief Links a node at the tail of the list.
+ * @param queue The queue.
+ * @param node The node.
+ */
+static void link_node(block_queue_t *queue, queue_block_t *node) {
+    __atomic_store_n(&node->next, NULL, __ATOMIC_RELAXED);
+    queue_block_t *prev = __atomic_exchange_n(&queue->tail, node, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Hands a filled block to the consumer.
+ * @param queue The queue.
+ * @param block A block from block_queue_acquire().
+ */
+void block_queue_push(block_queue_t *queue, queue_block_t *block) {
+    link_node(queue, block);
+    sem_post(&queue->filled);
+}
+
+/**
+ * @brief Unlinks the next block if it is fully linked.
+ * @param queue The queue.
+ * @return The block, or NULL if there is none or its producer has not linked it yet.
+ */
+static queue_block_t *try_pop(block_queue_t *queue) {
+    queue_block_t *head = queue->head;
+    queue_block_t *next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    if (head == &queue->stub) { // Skip the stub.
+        if (!next) return NULL;
+        queue->head = head = next;
+        next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    }
+    if (next) {
+        queue->head = next;
+        return head;
+    }
+    if (head != __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE)) return NULL; // A push is half done.
+    link_node(queue, &queue->stub); // head is the last block: put the stub behind it to unlink it.
+    next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    if (!next) return NULL;
+    queue->head = next;
+    return head;
+}
+
+/**
+ * @brief Takes the next block, in push order, waiting for one.
+ * @param queue The queue.
+ * @return The block, or NULL once the queue is closed and empty.
+ */
+queue_block_t *block_queue_pop(block_queue_t *queue) {
+    while (sem_wait(&queue->filled) != 0) {}
+    for (;;) {
+        queue_block_t *block = try_pop(queue);
+        if (block) return block;
+        // Every push has returned before close, so a closed queue that looks empty is.
+        if (__atomic_load_n(&queue->closed, __ATOMIC_ACQUIRE)) return NULL;
+        sched_yield(); // The producer that was counted is still linking its block.
+    }
+}
+
+/**
+ * @brief Returns a block taken from the queue to the pool.
+ * @param queue The queue.
+ * @param block The block.
+ */
+void block_queue_release(block_queue_t *queue, queue_block_t *block) {
+    if (block->capacity == queue->block_size) {
+        pthread_mutex_lock(&queue->pool_lock);
+        block->next = queue->pool;
+        queue->pool = block;
+        pthread_mutex_unlock(&queue->pool_lock);
+    } else {
+        free(block);
+    }
+    sem_post(&queue->room);
+}
+
+/**
+ * @brief Tells the consumer that no block will be pushed any more.
+ * @param queue The queue.
+ */
+void block_queue_close(block_queue_t *queue) {
+    __atomic_store_n(&queue->closed, 1, __ATOMIC_RELEASE);
+    sem_post(&queue->filled);
+}
+
+/**
+ * @brief Frees a queue, its pool and any block still queued.
+ * @param queue The queue to be freed, or NULL.
+ */
+void block_queue_free(block_queue_t *queue) {
+    if (!queue) return;
+    __atomic_store_n(&queue->closed, 1, __ATOMIC_RELEASE);
+    for (queue_block_t *block; (block = try_pop(queue)) != NULL;) free(block);
+    while (queue->pool) {
+        queue_block_t *next = queue->pool->next;
+        free(queue->pool);
+        queue->pool = next;
+    }
+    sem_destroy(&queue->filled);
+    sem_destroy(&queue->room);
+    pthread_mutex_destroy(&queue->pool_lock);
+    free(queue);
+}
+
+ /** @} */
@@ -0,0 +1,91 @@
+/**
+ * @file block_queue.h
+ * @brief Defines a bounded queue of byte blocks from several producers to one consumer.
+ *
+ * Producers fill a block on their own and hand it over whole, so the queue is
+ * touched once per block rather than once per record. Handing a block over is
+ * lock-free (an intrusive MPSC list: one atomic exchange and one store), and a
+ * semaphore wakes the consumer. Empty blocks come from a pool that holds at
+ * most a fixed number of blocks; a producer that runs ahead of the consumer
+ * waits for a block to come back, which bounds the memory in flight.
+ */
+
+#ifndef A94E6D21_7C0B_4F38_B5D2_E18F3A6C0B97
+#define A94E6D21_7C0B_4F38_B5D2_E18F3A6C0B97
+
+#include <stddef.h>
+
+/**
+ * @struct queue_block_t
+ * @brief A block of bytes passed from a producer to the consumer.
+ */
+typedef struct queue_block_t {
+    struct queue_block_t *next;  /**< Link in the queue or the pool. Internal. */
+    size_t size;                 /**< Bytes of data in use. */
+    size_t capacity;             /**< Bytes of data allocated. */
+    char data[];                 /**< The payload. */
+} queue_block_t;
+
+/**
+ * @struct block_queue_t
+ * @brief An opaque type for the queue.
+ */
+typedef struct block_queue_t block_queue_t;
+
+/**
+ * @brief Creates a queue.
+ * @param block_size The capacity of a pooled block.
+ * @param max_blocks The most blocks out of the pool at once; more than the number of producers.
+ * @return The queue, or NULL on allocation failure.
+ */
+block_queue_t *block_queue_create(size_t block_size, size_t max_blocks);
+
+/**
+ * @brief Takes an empty block, waiting while max_blocks are out of the pool.
+ *
+ * A block larger than block_size is allocated on its own and freed when it is
+ * released, but counts against max_blocks like the others.
+ *
+ * @param queue The queue.
+ * @param min_capacity The least capacity needed.
+ * @return The block, with size 0, or NULL on allocation failure.
+ */
+queue_block_t *block_queue_acquire(block_queue_t *queue, size_t min_capacity);
+
+/**
+ * @brief Hands a filled block to the consumer. Lock-free; any number of threads may push.
+ * @param queue The queue.
+ * @param block A block from block_queue_acquire().
+ */
+void block_queue_push(block_queue_t *queue, queue_block_t *block);
+
+/**
+ * @brief Takes the next block, in push order, waiting for one. Only one thread may pop.
+ * @param queue The queue.
+ * @return The block, or NULL once the queue is closed and empty.
+ */
+queue_block_t *block_queue_pop(block_queue_t *queue);
+
+/**
+ * @brief Returns a block taken from the queue to the pool.
+ * @param queue The queue.
+ * @param block The block.
+ */
+void block_queue_release(block_queue_t *queue, queue_block_t *block);
+
+/**
+ * @brief Tells the consumer that no block will be pushed any more.
+ *
+ * Must be called after every push has returned.
+ *
+ * @param queue The queue.
+ */
+void block_queue_close(block_queue_t *queue);
+
+/**
+ * @brief Frees a queue, its pool and any block still queued.
+ * @param queue The queue to be freed, or NULL.
+ */
+void block_queue_free(block_queue_t *queue);
+
+#endif /* A94E6D21_7C0B_4F38_B5D2_E18F3A6C0B97 */
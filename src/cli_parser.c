@@ -7,7 +7,9 @@
  */    
 
 #include "cli_parser.h"
+#include "cycle_stats.h"
 
+#include <errno.h>
 #include <getopt.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -27,6 +29,21 @@ static const char* make_unique_filename(const char* prefix, const char* filetype
 void parse_cli_args(int argc, char **argv, CLIOptions *opts) {
     // Default values
     opts->output_file = NULL;
+    opts->algorithm = ALGORITHM_DFS;
+    opts->max_cycle_length = 0;
+    opts->threads = 0;
+    opts->cycle_stats = CYCLE_STAT_MAX;
+    opts->temporal = false;
+    opts->collapse_parallel = false;
+    opts->keep_duplicates = false;
+    opts->output_format = OUTPUT_TEXT;
+    opts->decode = false;
+    opts->print_addresses = false;
+    opts->save_snapshot = NULL;
+    opts->load_snapshot = NULL;
+    opts->append_snapshot = NULL;
+    opts->verify_snapshot = false;
+    opts->time_window = 0;
     opts->verbose = false;
     opts->show_help = false;
     opts->short_help = false;
@@ -35,17 +52,121 @@ void parse_cli_args(int argc, char **argv, CLIOptions *opts) {
     opts->positionals = NULL;
 
     static struct option long_options[] = {
+        {"addresses", no_argument,     NULL, 'A'},
+        {"algorithm", required_argument, NULL, 'a'},
+        {"append",  required_argument, NULL, 'P'},
+        {"collapse-parallel", no_argument, NULL, 'c'},
+        {"decode",  no_argument,       NULL, 'D'},
+        {"format",  required_argument, NULL, 'f'},
         {"help",    no_argument,       NULL, 'h'},
+        {"keep-duplicates", no_argument, NULL, 'd'},
+        {"load-snapshot", required_argument, NULL, 'L'},
+        {"max-cycle-length", required_argument, NULL, 'k'},
         {"output",  required_argument, NULL, 'o'},
+        {"save-snapshot", required_argument, NULL, 'S'},
+        {"stats",   required_argument, NULL, 's'},
+        {"threads", required_argument, NULL, 't'},
+        {"time-window", required_argument, NULL, 'w'},
         {"verbose", no_argument,       NULL, 'v'},
         {"usage",   no_argument,       NULL, 'u'},
+        {"verify-snapshot", no_argument, NULL, 'V'},
         {0, 0, 0, 0}
     };
-    const char *optstring = "uho:v";
+    const char *optstring = "Aa:cdf:uhk:o:s:t:vw:";
 
     int opt;
     while ((opt = getopt_long(argc, argv, optstring, long_options, NULL)) != -1) {
         switch (opt) {
+            case 'A':
+                opts->print_addresses = true;
+                break;
+            case 'a':
+                if (strcmp(optarg, "dfs") == 0) {
+                    opts->algorithm = ALGORITHM_DFS;
+                } else if (strcmp(optarg, "johnson") == 0) {
+                    opts->algorithm = ALGORITHM_JOHNSON;
+                } else {
+                    fprintf(stderr, "Unknown algorithm '%s'.\n\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'P':
+                opts->append_snapshot = optarg;
+                break;
+            case 'c':
+                opts->collapse_parallel = true;
+                break;
+            case 'd':
+                opts->keep_duplicates = true;
+                break;
+            case 'D':
+                opts->decode = true;
+                break;
+            case 'f':
+                if (strcmp(optarg, "text") == 0) {
+                    opts->output_format = OUTPUT_TEXT;
+                } else if (strcmp(optarg, "bin") == 0) {
+                    opts->output_format = OUTPUT_BINARY;
+                } else {
+                    fprintf(stderr, "Unknown output format '%s'.\n\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'L':
+                opts->load_snapshot = optarg;
+                break;
+            case 'S':
+                opts->save_snapshot = optarg;
+                break;
+            case 'V':
+                opts->verify_snapshot = true;
+                break;
+            case 'k': {
+                char *end;
+                errno = 0;
+                unsigned long long length = strtoull(optarg, &end, 10);
+                if (errno || end == optarg || *end != '\0' || length == 0 || optarg[0] == '-') {
+                    fprintf(stderr, "Invalid maximum cycle length '%s'.\n\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                opts->max_cycle_length = (size_t)length;
+                break;
+            }
+            case 's':
+                if (cycle_stats_parse(optarg, &opts->cycle_stats) != 0) {
+                    fprintf(stderr, "Invalid cycle statistics '%s'.\n\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 't': {
+                char *end;
+                errno = 0;
+                unsigned long long threads = strtoull(optarg, &end, 10);
+                if (errno || end == optarg || *end != '\0' || threads == 0 || optarg[0] == '-') {
+                    fprintf(stderr, "Invalid thread count '%s'.\n\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                opts->threads = (size_t)threads;
+                break;
+            }
+            case 'w': {
+                char *end;
+                errno = 0;
+                unsigned long long window = strtoull(optarg, &end, 10);
+                if (errno || end == optarg || *end != '\0' || optarg[0] == '-') {
+                    fprintf(stderr, "Invalid time window '%s'.\n\n", optarg);
+                    print_usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                opts->temporal = true;
+                opts->time_window = (uint64_t)window;
+                break;
+            }
             case 'u':
                 opts->short_help = true;
                 break;
@@ -87,10 +208,43 @@ void print_short_help(const char *progname){
 void print_usage(const char *progname) {
     printf("Usage: %s [OPTIONS] [FILES...]\n", progname);
     puts("Options:");
-    puts("  -u, --usage          Display short usage message and exit");
-    puts("  -h, --help           Display this help and exit");
-    puts("  -o, --output <file>  Defines output file");
-    puts("  -v, --verbose        Enables verbose mode");
+    puts("  -A, --addresses         Write cycles as checksummed wallet addresses instead of vertex");
+    puts("                          ids (text output; binary files keep the ids)");
+    puts("  -a, --algorithm <name>  Cycle search: 'dfs' (default, one cycle per DFS back edge)");
+    puts("                          or 'johnson' (every elementary cycle)");
+    puts("      --append <file>     Add the input to a snapshot saved with --save-snapshot and report");
+    puts("                          only the cycles its transactions close; the snapshot is updated");
+    puts("  -c, --collapse-parallel Merge repeated transactions between the same two wallets (and,");
+    puts("                          with timestamps, the same time) into one edge");
+    puts("  -d, --keep-duplicates   Report a cycle again each time parallel transactions close it");
+    puts("                          (by default, each sequence of wallets is reported once)");
+    puts("      --decode            Convert the binary cycle file given as input to text");
+    puts("  -f, --format <name>     Output format: 'text' (default) or 'bin' (compact, with an");
+    puts("                          index to seek to any cycle; convert it back with --decode)");
+    puts("  -u, --usage             Display short usage message and exit");
+    puts("  -h, --help              Display this help and exit");
+    puts("  -k, --max-cycle-length <n>");
+    puts("                          Report every elementary cycle of at most n transactions");
+    puts("                          (whichever algorithm is selected)");
+    puts("      --load-snapshot <file>");
+    puts("                          Reopen a graph saved with --save-snapshot instead of parsing");
+    puts("                          an input file");
+    puts("  -o, --output <file>     Defines output file");
+    puts("  -s, --stats <list>      Values reported per cycle, comma-separated: max (largest");
+    puts("                          transaction, default), min (bottleneck), sum (total volume),");
+    puts("                          count (length), e.g. -s min,max,sum,count");
+    puts("      --save-snapshot <file>");
+    puts("                          Save the loaded graph (after -c, if given) for instant reloading");
+    puts("  -t, --threads <n>       Threads for loading and for the cycle search");
+    puts("                          (default: one per online CPU)");
+    puts("  -v, --verbose           Enables verbose mode");
+    puts("      --verify-snapshot   Check the checksums of the whole snapshot when loading it");
+    puts("  -w, --time-window <n>   Report every time-respecting cycle (non-decreasing timestamps)");
+    puts("                          spanning at most n; needs a 4th input column with the block");
+    puts("                          number or timestamp (block_number in a CSV). Combines with -k");
+    puts("Input: lines of 'sender receiver value [timestamp]', or an ethereum-etl transactions.csv,");
+    puts("recognised by its header; zero-value, self and contract-creation rows of a CSV are skipped.");
+    puts("Either may be gzip-compressed; it is decompressed on the fly.");
     // TODO: explain in detailed form how to use the program
 }
 
@@ -128,7 +282,7 @@ const char *make_output_filename(const CLIOptions *opts) {
     if (opts->user_specified_output) {
         return opts->output_file;
     }
-    return make_unique_filename("output", "txt");
+    return make_unique_filename("output", opts->output_format == OUTPUT_BINARY && !opts->decode ? "bin" : "txt");
 }
 
  /** @} */ 
\ No newline at end of file
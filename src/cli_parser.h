@@ -7,6 +7,26 @@
 #define B0EF9175_7456_442B_BD53_7B1A58C47678
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @enum cycle_algorithm_t
+ * @brief The cycle search selected with --algorithm.
+ */
+typedef enum {
+    ALGORITHM_DFS,               /**< One cycle per DFS back edge (default). */
+    ALGORITHM_JOHNSON            /**< Every elementary cycle, with Johnson's algorithm. */
+} cycle_algorithm_t;
+
+/**
+ * @enum output_format_t
+ * @brief The format of the output file, selected with --format.
+ */
+typedef enum {
+    OUTPUT_TEXT,                 /**< One line per cycle and per aggregate (default). */
+    OUTPUT_BINARY                /**< The indexed binary format of cycle_file.h. */
+} output_format_t;
 
 /**
  * @struct CLIOptions
@@ -16,6 +36,51 @@ typedef struct {
     /** @var output_file Path to the output file specified with --output or -o. */
     const char *output_file;
 
+    /** @var algorithm The cycle search, chosen with --algorithm or -a. */
+    cycle_algorithm_t algorithm;
+
+    /** @var max_cycle_length Longest cycle to report, set with --max-cycle-length or -k; 0 means no limit. */
+    size_t max_cycle_length;
+
+    /** @var temporal True if --time-window or -w was given: only time-respecting cycles are reported. */
+    bool temporal;
+
+    /** @var time_window Largest time span of a temporal cycle, in the unit of the input timestamps. */
+    uint64_t time_window;
+
+    /** @var threads Number of worker threads, set with --threads or -t; 0 means one per online CPU. */
+    size_t threads;
+
+    /** @var cycle_stats Aggregates reported per cycle (CYCLE_STAT_* flags), set with --stats or -s. */
+    unsigned cycle_stats;
+
+    /** @var keep_duplicates Report a vertex cycle again when parallel edges close it, set with --keep-duplicates or -d. */
+    bool keep_duplicates;
+
+    /** @var output_format Format of the output file, set with --format or -f. */
+    output_format_t output_format;
+
+    /** @var print_addresses Write wallet addresses (EIP-55 checksummed) instead of vertex ids, set with --addresses or -A. */
+    bool print_addresses;
+
+    /** @var decode True if --decode was given: the input is a binary cycle file to convert to text. */
+    bool decode;
+
+    /** @var save_snapshot File to write the loaded graph to, set with --save-snapshot; NULL for none. */
+    const char *save_snapshot;
+
+    /** @var load_snapshot Snapshot to reopen instead of parsing an input file, set with --load-snapshot. */
+    const char *load_snapshot;
+
+    /** @var append_snapshot Snapshot to append the input to, searching only the cycles it closes, set with --append. */
+    const char *append_snapshot;
+
+    /** @var verify_snapshot Check every section checksum of the snapshot when loading it, set with --verify-snapshot. */
+    bool verify_snapshot;
+
+    /** @var collapse_parallel Merge repeated transactions between the same pair, set with --collapse-parallel or -c. */
+    bool collapse_parallel;
+
     /** @var verbose Flag for verbose mode, enabled with --verbose or -v. */
     bool verbose;
 
@@ -59,7 +124,8 @@ void print_short_help(const char *progname);
  * @brief Determines the output filename.
  *
  * If the user specified an output file, it returns that name. Otherwise, it
- * generates a unique filename based on the current timestamp.
+ * generates a unique filename based on the current timestamp, with the "bin"
+ * extension for binary output.
  *
  * @param opts A pointer to the populated CLIOptions struct.
  * @return A constant character pointer to the determined output filename.
@@ -0,0 +1,476 @@
+/**
+ * @file cycle_file.c
+ * @brief Implementation of the cycle output formats and of the binary reader.
+ * @defgroup cycle_file Cycle File
+ * @{
+ */
+
+#include "cycle_file.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "input_reader.h"
+
+/**
+ * @def CYCLE_FILE_MAGIC
+ * @brief The first bytes of a binary cycle file.
+ */
+#define CYCLE_FILE_MAGIC "ETHCYCLE"
+
+/**
+ * @def CYCLE_FILE_INDEX_MAGIC
+ * @brief The last bytes of a binary cycle file, after a complete index.
+ */
+#define CYCLE_FILE_INDEX_MAGIC "ETHCYIDX"
+
+/**
+ * @def VARINT_MAX_SIZE
+ * @brief Bytes of the longest LEB128 encoding of a 64-bit value.
+ */
+#define VARINT_MAX_SIZE 10
+
+/**
+ * @struct cycle_reader_t
+ * @brief The internal structure of the reader.
+ */
+struct cycle_reader_t {
+    FILE *file;                  /**< The open file, kept for the mapping. */
+    input_reader_t *input;       /**< The mapping. */
+    const unsigned char *data;   /**< The first byte of the file. */
+    size_t index_offset;         /**< Where the index starts, which ends the records. */
+    size_t count;                /**< The number of cycles. */
+    size_t stride;               /**< Records between two index entries. */
+    unsigned stats;              /**< The aggregates stored in each record. */
+    size_t pos;                  /**< The offset of the next record. */
+    size_t next;                 /**< The number of the next record, from 0. */
+    int *vertices;               /**< The vertices of the last record read. */
+    size_t capacity;             /**< The allocated size of vertices. */
+};
+
+/**
+ * @brief Writes the decimal digits of a vertex.
+ * @param q Where to write.
+ * @param v The vertex, not negative.
+ * @return The end of the digits.
+ */
+static inline char *format_vertex(char *q, int v) {
+    char digits[10];
+    int n = 0;
+    unsigned x = (unsigned)v;
+    do {
+        digits[n++] = (char)('0' + x % 10);
+        x /= 10;
+    } while (x);
+    while (n > 0) *q++ = digits[--n];
+    return q;
+}
+
+/**
+ * @brief Returns an upper bound of the text of a cycle.
+ * @param length The number of vertices of the cycle.
+ * @return The size in bytes.
+ */
+size_t cycle_text_size(size_t length) {
+    // A vertex takes at most an address, plus " -> "; a value line stays below UINT320_DEC_SIZE + 32.
+    return (length + 1) * (ADDRESS_HEX_LEN + 4) + 48 + CYCLE_STAT_KINDS * (UINT320_DEC_SIZE + 32);
+}
+
+/**
+ * @brief Writes a cycle in the text format.
+ * @param q Where to write; at least cycle_text_size(length) bytes.
+ * @param number The number of the cycle.
+ * @param vertices The vertices of the cycle, without repeating the first one.
+ * @param length The number of vertices.
+ * @param stats The aggregates of the cycle.
+ * @param mask The aggregates to write.
+ * @param addresses The wallet of each vertex id, to write checksummed addresses; NULL to write the ids.
+ * @return The end of the text.
+ */
+char *cycle_text_format(char *q, size_t number, const int *vertices, size_t length, const cycle_stats_t *stats,
+                        unsigned mask, const address_t *addresses) {
+    char value[UINT320_DEC_SIZE];
+    q += sprintf(q, "Cycle #%zu: ", number);
+    for (size_t i = 0; i <= length; i++) {
+        int v = vertices[i < length ? i : 0];
+        q = addresses ? address_format(&addresses[v], q) : format_vertex(q, v);
+        if (i == length) break;
+        memcpy(q, " -> ", 4);
+        q += 4;
+    }
+    *q++ = '\n';
+    for (int k = 0; k < CYCLE_STAT_KINDS; k++) {
+        if (!(mask & cycle_stat_info[k].flag)) continue;
+        cycle_stat_to_dec(stats, cycle_stat_info[k].flag, value);
+        q += sprintf(q, cycle_stat_info[k].file_format, value);
+    }
+    return q;
+}
+
+/**
+ * @brief Writes an unsigned LEB128 varint.
+ * @param q Where to write; at least VARINT_MAX_SIZE bytes.
+ * @param x The value.
+ * @return The end of the varint.
+ */
+static inline char *put_varint(char *q, uint64_t x) {
+    while (x >= 0x80) {
+        *q++ = (char)(x | 0x80);
+        x >>= 7;
+    }
+    *q++ = (char)x;
+    return q;
+}
+
+/**
+ * @brief Reads an unsigned LEB128 varint.
+ * @param p The position; advanced past the varint.
+ * @param end The end of the readable bytes.
+ * @param x Receives the value.
+ * @return 0 on success, -1 if the varint is cut or too long.
+ */
+static inline int get_varint(const unsigned char **p, const unsigned char *end, uint64_t *x) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64 && *p < end; shift += 7) {
+        unsigned char byte = *(*p)++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *x = value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Writes a little-endian 32-bit integer.
+ * @param q Where to write.
+ * @param x The value.
+ * @return q + 4.
+ */
+static char *put_u32(char *q, uint32_t x) {
+    for (int i = 0; i < 4; i++) q[i] = (char)(x >> (8 * i));
+    return q + 4;
+}
+
+/**
+ * @brief Writes a little-endian 64-bit integer, e.g. an index entry.
+ * @param q Where to write; at least 8 bytes.
+ * @param x The value.
+ * @return q + 8.
+ */
+char *cycle_file_put_u64(char *q, uint64_t x) {
+    for (int i = 0; i < 8; i++) q[i] = (char)(x >> (8 * i));
+    return q + 8;
+}
+
+/**
+ * @brief Reads a little-endian 32-bit integer.
+ * @param p The bytes.
+ * @return The value.
+ */
+static uint32_t get_u32(const unsigned char *p) {
+    uint32_t x = 0;
+    for (int i = 0; i < 4; i++) x |= (uint32_t)p[i] << (8 * i);
+    return x;
+}
+
+/**
+ * @brief Reads a little-endian 64-bit integer.
+ * @param p The bytes.
+ * @return The value.
+ */
+static uint64_t get_u64(const unsigned char *p) {
+    uint64_t x = 0;
+    for (int i = 0; i < 8; i++) x |= (uint64_t)p[i] << (8 * i);
+    return x;
+}
+
+/**
+ * @brief Writes the header of a binary cycle file.
+ * @param q Where to write; at least CYCLE_FILE_HEADER_SIZE bytes.
+ * @param mask The aggregates stored in the records.
+ * @return The end of the header.
+ */
+char *cycle_file_put_header(char *q, unsigned mask) {
+    memcpy(q, CYCLE_FILE_MAGIC, 8);
+    q = put_u32(q + 8, CYCLE_FILE_VERSION);
+    return put_u32(q, mask);
+}
+
+/**
+ * @brief Returns an upper bound of the binary record of a cycle.
+ * @param length The number of vertices of the cycle.
+ * @return The size in bytes.
+ */
+size_t cycle_file_record_size(size_t length) {
+    return (length + 1) * VARINT_MAX_SIZE + 2 * sizeof(uint256_t) + sizeof(uint320_t);
+}
+
+/**
+ * @brief Writes the limbs of a wide integer, least significant first.
+ * @param q Where to write.
+ * @param limbs The limbs.
+ * @param n The number of limbs.
+ * @return The end of the integer.
+ */
+static char *put_limbs(char *q, const uint64_t *limbs, int n) {
+    for (int i = 0; i < n; i++) q = cycle_file_put_u64(q, limbs[i]);
+    return q;
+}
+
+/**
+ * @brief Reads the limbs of a wide integer, least significant first.
+ * @param p The bytes.
+ * @param limbs Receives the limbs.
+ * @param n The number of limbs.
+ * @return The end of the integer.
+ */
+static const unsigned char *get_limbs(const unsigned char *p, uint64_t *limbs, int n) {
+    for (int i = 0; i < n; i++, p += 8) limbs[i] = get_u64(p);
+    return p;
+}
+
+/**
+ * @brief Writes the binary record of a cycle.
+ * @param q Where to write; at least cycle_file_record_size(length) bytes.
+ * @param vertices The vertices of the cycle, without repeating the first one.
+ * @param length The number of vertices.
+ * @param stats The aggregates of the cycle.
+ * @param mask The aggregates stored, as written in the header.
+ * @return The end of the record.
+ */
+char *cycle_file_put_record(char *q, const int *vertices, size_t length, const cycle_stats_t *stats,
+                            unsigned mask) {
+    q = put_varint(q, length);
+    for (size_t i = 0; i < length; i++) q = put_varint(q, (uint32_t)vertices[i]);
+    if (mask & CYCLE_STAT_MAX) q = put_limbs(q, stats->max.limb, UINT256_LIMBS);
+    if (mask & CYCLE_STAT_MIN) q = put_limbs(q, stats->min.limb, UINT256_LIMBS);
+    if (mask & CYCLE_STAT_SUM) q = put_limbs(q, stats->sum.limb, UINT320_LIMBS);
+    return q;
+}
+
+/**
+ * @brief Writes the trailer of a binary cycle file.
+ * @param q Where to write; at least CYCLE_FILE_TRAILER_SIZE bytes.
+ * @param index_offset The file offset of the index.
+ * @param count The number of cycles.
+ * @return The end of the trailer.
+ */
+char *cycle_file_put_trailer(char *q, uint64_t index_offset, uint64_t count) {
+    q = cycle_file_put_u64(q, index_offset);
+    q = cycle_file_put_u64(q, count);
+    q = put_u32(q, CYCLE_FILE_INDEX_STRIDE);
+    q = put_u32(q, 0);
+    memcpy(q, CYCLE_FILE_INDEX_MAGIC, 8);
+    return q + 8;
+}
+
+/**
+ * @brief Maps a binary cycle file and checks its header, trailer and index.
+ * @param path The file name.
+ * @return The reader, positioned at the first cycle, or NULL on failure (already reported).
+ */
+cycle_reader_t *cycle_reader_open(const char *path) {
+    cycle_reader_t *reader = calloc(1, sizeof(cycle_reader_t));
+    if (!reader) {
+        fprintf(stderr, "ERROR: bad alloc for cycle reader\n");
+        return NULL;
+    }
+    reader->file = fopen(path, "rb");
+    if (!reader->file) {
+        perror("ERROR: opening cycle file");
+        free(reader);
+        return NULL;
+    }
+    reader->input = input_reader_open(fileno(reader->file));
+    size_t size = 0;
+    const char *data = reader->input ? input_reader_data(reader->input, &size) : NULL;
+    if (!data) {
+        fprintf(stderr, "ERROR: %s is not a regular file that can be mapped\n", path);
+        goto fail;
+    }
+    reader->data = (const unsigned char *)data;
+
+    if (size < CYCLE_FILE_HEADER_SIZE + CYCLE_FILE_TRAILER_SIZE
+        || memcmp(reader->data, CYCLE_FILE_MAGIC, 8) != 0) {
+        fprintf(stderr, "ERROR: %s is not a binary cycle file\n", path);
+        goto fail;
+    }
+    uint32_t version = get_u32(reader->data + 8);
+    if (version != CYCLE_FILE_VERSION) {
+        fprintf(stderr, "ERROR: %s has format version %u, expected %u\n", path, version, CYCLE_FILE_VERSION);
+        goto fail;
+    }
+    reader->stats = get_u32(reader->data + 12);
+
+    // The trailer is written last: without it the search did not finish.
+    const unsigned char *trailer = reader->data + size - CYCLE_FILE_TRAILER_SIZE;
+    uint64_t index_offset = get_u64(trailer);
+    uint64_t count = get_u64(trailer + 8);
+    uint32_t stride = get_u32(trailer + 16);
+    if (memcmp(trailer + 24, CYCLE_FILE_INDEX_MAGIC, 8) != 0 || stride == 0
+        || index_offset < CYCLE_FILE_HEADER_SIZE || index_offset > size - CYCLE_FILE_TRAILER_SIZE
+        || (size - CYCLE_FILE_TRAILER_SIZE - index_offset) / 8 != (count + stride - 1) / stride
+        || (size - CYCLE_FILE_TRAILER_SIZE - index_offset) % 8 != 0) {
+        fprintf(stderr, "ERROR: %s is truncated or its index is corrupt\n", path);
+        goto fail;
+    }
+    reader->index_offset = (size_t)index_offset;
+    reader->count = (size_t)count;
+    reader->stride = stride;
+    reader->pos = CYCLE_FILE_HEADER_SIZE;
+    return reader;
+
+fail:
+    cycle_reader_close(reader);
+    return NULL;
+}
+
+/**
+ * @brief Returns the number of cycles in the file.
+ * @param reader The reader.
+ * @return The number of cycles.
+ */
+size_t cycle_reader_count(const cycle_reader_t *reader) {
+    return reader->count;
+}
+
+/**
+ * @brief Returns the aggregates stored in the file.
+ * @param reader The reader.
+ * @return A set of CYCLE_STAT_* flags.
+ */
+unsigned cycle_reader_stats(const cycle_reader_t *reader) {
+    return reader->stats;
+}
+
+/**
+ * @brief Positions the reader on a cycle through the index.
+ * @param reader The reader.
+ * @param number The number of the cycle, from 1.
+ * @return 0 on success, -1 if there is no such cycle or the file is corrupt.
+ */
+int cycle_reader_seek(cycle_reader_t *reader, size_t number) {
+    if (number == 0 || number > reader->count) return -1;
+    size_t entry = (number - 1) / reader->stride;
+    uint64_t pos = get_u64(reader->data + reader->index_offset + entry * 8);
+    if (pos < CYCLE_FILE_HEADER_SIZE || pos > reader->index_offset) return -1;
+    reader->pos = (size_t)pos;
+    reader->next = entry * reader->stride;
+
+    const int *vertices;
+    size_t length;
+    cycle_stats_t stats;
+    while (reader->next < number - 1) {
+        if (cycle_reader_next(reader, &vertices, &length, &stats) != 1) return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads the next cycle.
+ * @param reader The reader.
+ * @param vertices Receives the vertices of the cycle, valid until the next call.
+ * @param length Receives the number of vertices.
+ * @param stats Receives the stored aggregates; the count is always set.
+ * @return 1 if a cycle was read, 0 after the last one, -1 if the file is corrupt.
+ */
+int cycle_reader_next(cycle_reader_t *reader, const int **vertices, size_t *length, cycle_stats_t *stats) {
+    if (reader->next >= reader->count) return 0;
+    const unsigned char *p = reader->data + reader->pos;
+    const unsigned char *end = reader->data + reader->index_offset;
+
+    uint64_t n;
+    if (get_varint(&p, end, &n) != 0 || n == 0 || n > (size_t)(end - p)) return -1;
+    if (n > reader->capacity) {
+        int *grown = realloc(reader->vertices, n * sizeof(int));
+        if (!grown) return -1;
+        reader->vertices = grown;
+        reader->capacity = n;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t v;
+        if (get_varint(&p, end, &v) != 0 || v > INT32_MAX) return -1;
+        reader->vertices[i] = (int)v;
+    }
+
+    size_t fixed = 0;
+    if (reader->stats & CYCLE_STAT_MAX) fixed += sizeof(uint256_t);
+    if (reader->stats & CYCLE_STAT_MIN) fixed += sizeof(uint256_t);
+    if (reader->stats & CYCLE_STAT_SUM) fixed += sizeof(uint320_t);
+    if (fixed > (size_t)(end - p)) return -1;
+    if (reader->stats & CYCLE_STAT_MAX) p = get_limbs(p, stats->max.limb, UINT256_LIMBS);
+    if (reader->stats & CYCLE_STAT_MIN) p = get_limbs(p, stats->min.limb, UINT256_LIMBS);
+    if (reader->stats & CYCLE_STAT_SUM) p = get_limbs(p, stats->sum.limb, UINT320_LIMBS);
+    stats->count = (size_t)n;
+
+    *vertices = reader->vertices;
+    *length = (size_t)n;
+    reader->pos = (size_t)(p - reader->data);
+    reader->next++;
+    return 1;
+}
+
+/**
+ * @brief Unmaps the file and frees the reader.
+ * @param reader The reader, or NULL.
+ */
+void cycle_reader_close(cycle_reader_t *reader) {
+    if (!reader) return;
+    if (reader->input) input_reader_close(reader->input);
+    if (reader->file) fclose(reader->file);
+    free(reader->vertices);
+    free(reader);
+}
+
+/**
+ * @brief Converts a binary cycle file to the text format.
+ * @param path The binary file.
+ * @param out The text output.
+ * @return The number of cycles written, or -1 on failure (already reported).
+ */
+long long cycle_file_decode(const char *path, FILE *out) {
+    cycle_reader_t *reader = cycle_reader_open(path);
+    if (!reader) return -1;
+
+    size_t capacity = cycle_text_size(64);
+    char *text = malloc(capacity);
+    if (!text) {
+        fprintf(stderr, "ERROR: bad alloc for cycle text\n");
+        cycle_reader_close(reader);
+        return -1;
+    }
+
+    long long written = 0;
+    const int *vertices;
+    size_t length;
+    cycle_stats_t stats;
+    int status;
+    while ((status = cycle_reader_next(reader, &vertices, &length, &stats)) == 1) {
+        if (cycle_text_size(length) > capacity) {
+            capacity = cycle_text_size(length);
+            char *grown = realloc(text, capacity);
+            if (!grown) {
+                fprintf(stderr, "ERROR: bad alloc for cycle text\n");
+                status = -2;
+                break;
+            }
+            text = grown;
+        }
+        char *end = cycle_text_format(text, (size_t)written + 1, vertices, length, &stats, reader->stats, NULL);
+        if (fwrite(text, 1, (size_t)(end - text), out) != (size_t)(end - text)) {
+            perror("ERROR: writing output file");
+            status = -2;
+            break;
+        }
+        written++;
+    }
+    if (status == -1) fprintf(stderr, "ERROR: %s: cycle #%lld is corrupt\n", path, written + 1);
+
+    free(text);
+    cycle_reader_close(reader);
+    return status == 0 ? written : -1;
+}
+
+ /** @} */
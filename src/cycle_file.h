@@ -0,0 +1,184 @@
+/**
+ * @file cycle_file.h
+ * @brief Defines the text and binary formats of the cycle output, and a reader for the binary one.
+ *
+ * The text format is one "Cycle #n: a -> b -> a" line per cycle, followed by
+ * one line per reported aggregate. The binary format stores the same cycles in
+ * a fraction of the space and can be read without parsing text:
+ *
+ * - a header: the magic "ETHCYCLE", the version (uint32) and the set of
+ *   aggregates stored (uint32, CYCLE_STAT_* flags);
+ * - one record per cycle, in output order: the number of vertices and then
+ *   each vertex id as unsigned LEB128 varints, followed by the aggregates in
+ *   cycle_stat_info order at fixed width: max and min as 32-byte integers, sum
+ *   as a 40-byte integer (count is the number of vertices and is not stored);
+ * - an index: the file offset (uint64) of every CYCLE_FILE_INDEX_STRIDE-th
+ *   record, starting with the first;
+ * - a trailer: the offset of the index (uint64), the number of cycles
+ *   (uint64), the index stride (uint32), a zero word (uint32) and the magic
+ *   "ETHCYIDX".
+ *
+ * All integers are little-endian. Cycle n (numbered from 1, as in the text
+ * format) is found by reading the trailer, jumping to index entry
+ * (n - 1) / stride and skipping at most stride - 1 records.
+ */
+
+#ifndef B2F5D8C3_46E1_4A7B_9C08_D3E7A19F6B24
+#define B2F5D8C3_46E1_4A7B_9C08_D3E7A19F6B24
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "address.h"
+#include "cycle_stats.h"
+
+/**
+ * @def CYCLE_FILE_VERSION
+ * @brief The version of the binary format written.
+ */
+#define CYCLE_FILE_VERSION 1
+
+/**
+ * @def CYCLE_FILE_HEADER_SIZE
+ * @brief Size of the header of a binary cycle file.
+ */
+#define CYCLE_FILE_HEADER_SIZE 16
+
+/**
+ * @def CYCLE_FILE_TRAILER_SIZE
+ * @brief Size of the trailer of a binary cycle file.
+ */
+#define CYCLE_FILE_TRAILER_SIZE 32
+
+/**
+ * @def CYCLE_FILE_INDEX_STRIDE
+ * @brief Records between two index entries, written in the trailer.
+ */
+#define CYCLE_FILE_INDEX_STRIDE 16
+
+/**
+ * @brief Returns an upper bound of the text of a cycle.
+ * @param length The number of vertices of the cycle.
+ * @return The size in bytes.
+ */
+size_t cycle_text_size(size_t length);
+
+/**
+ * @brief Writes a cycle in the text format.
+ * @param q Where to write; at least cycle_text_size(length) bytes.
+ * @param number The number of the cycle.
+ * @param vertices The vertices of the cycle, without repeating the first one.
+ * @param length The number of vertices.
+ * @param stats The aggregates of the cycle.
+ * @param mask The aggregates to write.
+ * @param addresses The wallet of each vertex id, to write checksummed addresses; NULL to write the ids.
+ * @return The end of the text.
+ */
+char *cycle_text_format(char *q, size_t number, const int *vertices, size_t length, const cycle_stats_t *stats,
+                        unsigned mask, const address_t *addresses);
+
+/**
+ * @brief Writes the header of a binary cycle file.
+ * @param q Where to write; at least CYCLE_FILE_HEADER_SIZE bytes.
+ * @param mask The aggregates stored in the records.
+ * @return The end of the header.
+ */
+char *cycle_file_put_header(char *q, unsigned mask);
+
+/**
+ * @brief Returns an upper bound of the binary record of a cycle.
+ * @param length The number of vertices of the cycle.
+ * @return The size in bytes.
+ */
+size_t cycle_file_record_size(size_t length);
+
+/**
+ * @brief Writes the binary record of a cycle.
+ * @param q Where to write; at least cycle_file_record_size(length) bytes.
+ * @param vertices The vertices of the cycle, without repeating the first one.
+ * @param length The number of vertices.
+ * @param stats The aggregates of the cycle.
+ * @param mask The aggregates stored, as written in the header.
+ * @return The end of the record.
+ */
+char *cycle_file_put_record(char *q, const int *vertices, size_t length, const cycle_stats_t *stats,
+                            unsigned mask);
+
+/**
+ * @brief Writes a little-endian 64-bit integer, e.g. an index entry.
+ * @param q Where to write; at least 8 bytes.
+ * @param x The value.
+ * @return q + 8.
+ */
+char *cycle_file_put_u64(char *q, uint64_t x);
+
+/**
+ * @brief Writes the trailer of a binary cycle file.
+ * @param q Where to write; at least CYCLE_FILE_TRAILER_SIZE bytes.
+ * @param index_offset The file offset of the index.
+ * @param count The number of cycles.
+ * @return The end of the trailer.
+ */
+char *cycle_file_put_trailer(char *q, uint64_t index_offset, uint64_t count);
+
+/**
+ * @struct cycle_reader_t
+ * @brief An opaque type for a reader of binary cycle files.
+ */
+typedef struct cycle_reader_t cycle_reader_t;
+
+/**
+ * @brief Maps a binary cycle file and checks its header, trailer and index.
+ * @param path The file name.
+ * @return The reader, positioned at the first cycle, or NULL on failure (already reported).
+ */
+cycle_reader_t *cycle_reader_open(const char *path);
+
+/**
+ * @brief Returns the number of cycles in the file.
+ * @param reader The reader.
+ * @return The number of cycles.
+ */
+size_t cycle_reader_count(const cycle_reader_t *reader);
+
+/**
+ * @brief Returns the aggregates stored in the file.
+ * @param reader The reader.
+ * @return A set of CYCLE_STAT_* flags.
+ */
+unsigned cycle_reader_stats(const cycle_reader_t *reader);
+
+/**
+ * @brief Positions the reader on a cycle through the index.
+ * @param reader The reader.
+ * @param number The number of the cycle, from 1.
+ * @return 0 on success, -1 if there is no such cycle or the file is corrupt.
+ */
+int cycle_reader_seek(cycle_reader_t *reader, size_t number);
+
+/**
+ * @brief Reads the next cycle.
+ * @param reader The reader.
+ * @param vertices Receives the vertices of the cycle, valid until the next call.
+ * @param length Receives the number of vertices.
+ * @param stats Receives the stored aggregates; the count is always set.
+ * @return 1 if a cycle was read, 0 after the last one, -1 if the file is corrupt.
+ */
+int cycle_reader_next(cycle_reader_t *reader, const int **vertices, size_t *length, cycle_stats_t *stats);
+
+/**
+ * @brief Unmaps the file and frees the reader.
+ * @param reader The reader, or NULL.
+ */
+void cycle_reader_close(cycle_reader_t *reader);
+
+/**
+ * @brief Converts a binary cycle file to the text format.
+ * @param path The binary file.
+ * @param out The text output.
+ * @return The number of cycles written, or -1 on failure (already reported).
+ */
+long long cycle_file_decode(const char *path, FILE *out);
+
+#endif /* B2F5D8C3_46E1_4A7B_9C08_D3E7A19F6B24 */
@@ -0,0 +1,202 @@
+/**
+ * @file cycle_set.c
+ * @brief Implementation of the sharded cycle set.
+ * @defgroup cycle_set Cycle Set
+ * @{
+ */
+
+#include "cycle_set.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @def CYCLE_SET_SHARD_BITS
+ * @brief log2 of the number of shards; the top bits of a hash pick its shard.
+ */
+#define CYCLE_SET_SHARD_BITS 6
+
+/**
+ * @def CYCLE_SET_SHARDS
+ * @brief Number of independently locked shards.
+ */
+#define CYCLE_SET_SHARDS (1u << CYCLE_SET_SHARD_BITS)
+
+/**
+ * @def CYCLE_SET_MAX_LOAD
+ * @brief Maximum fill ratio of a shard's table, in percent, before it grows.
+ */
+#define CYCLE_SET_MAX_LOAD 70
+
+/**
+ * @def CYCLE_SET_MIN_CAPACITY
+ * @brief Slots of a shard's table when its first cycle arrives.
+ */
+#define CYCLE_SET_MIN_CAPACITY 64
+
+/**
+ * @struct cycle_set_slot_t
+ * @brief One slot of a shard's table: a canonical cycle stored in the shard's arena.
+ */
+typedef struct {
+    uint64_t hash;               /**< The hash of the canonical rotation. */
+    size_t offset;               /**< Where the canonical rotation starts in the arena. */
+    size_t length;               /**< The number of vertices, or 0 for an empty slot. */
+} cycle_set_slot_t;
+
+/**
+ * @struct cycle_set_shard_t
+ * @brief An open-addressing table with linear probing and the arena of its cycles.
+ */
+typedef struct {
+    pthread_mutex_t lock;        /**< Serializes the threads that hash to this shard. */
+    cycle_set_slot_t *slots;     /**< The slot array, or NULL while the shard is empty. */
+    size_t capacity;             /**< Number of slots, always a power of two. */
+    size_t count;                /**< Number of cycles stored. */
+    int *arena;                  /**< The canonical rotations, back to back. */
+    size_t arena_size;           /**< Vertices in use in the arena. */
+    size_t arena_capacity;       /**< The allocated size of the arena. */
+} cycle_set_shard_t;
+
+/**
+ * @struct cycle_set_t
+ * @brief The internal structure of the set.
+ */
+struct cycle_set_t {
+    cycle_set_shard_t shards[CYCLE_SET_SHARDS]; /**< The shards. */
+};
+
+/**
+ * @brief Hashes a cycle read from its smallest vertex.
+ * @param vertices The cycle.
+ * @param length The number of vertices.
+ * @param first The position of the smallest vertex.
+ * @return The hash.
+ */
+static uint64_t hash_rotation(const int *vertices, size_t length, size_t first) {
+    uint64_t h = length * 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0, j = first; i < length; i++, j = j + 1 == length ? 0 : j + 1) {
+        h = (h ^ (uint32_t)vertices[j]) * 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 31;
+    }
+    return h ^ (h >> 29);
+}
+
+/**
+ * @brief Checks whether a stored canonical rotation equals a cycle read from its smallest vertex.
+ * @param stored The stored rotation.
+ * @param vertices The cycle.
+ * @param length The number of vertices of both.
+ * @param first The position of the smallest vertex of the cycle.
+ * @return Non-zero if they are equal.
+ */
+static int same_rotation(const int *stored, const int *vertices, size_t length, size_t first) {
+    size_t tail = length - first;
+    return memcmp(stored, vertices + first, tail * sizeof(int)) == 0
+           && memcmp(stored + tail, vertices, first * sizeof(int)) == 0;
+}
+
+/**
+ * @brief Moves every slot of a shard into a table of the given size.
+ * @param shard The shard.
+ * @param capacity The new number of slots, a power of two.
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int resize(cycle_set_shard_t *shard, size_t capacity) {
+    cycle_set_slot_t *slots = calloc(capacity, sizeof(cycle_set_slot_t));
+    if (!slots) return -1;
+    for (size_t i = 0; i < shard->capacity; i++) {
+        const cycle_set_slot_t *old = &shard->slots[i];
+        if (old->length == 0) continue;
+        size_t j = old->hash & (capacity - 1);
+        while (slots[j].length != 0) j = (j + 1) & (capacity - 1);
+        slots[j] = *old;
+    }
+    free(shard->slots);
+    shard->slots = slots;
+    shard->capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Creates an empty set.
+ * @return The set, or NULL on allocation failure.
+ */
+cycle_set_t *cycle_set_create(void) {
+    cycle_set_t *set = calloc(1, sizeof(cycle_set_t));
+    if (!set) return NULL;
+    for (size_t s = 0; s < CYCLE_SET_SHARDS; s++) pthread_mutex_init(&set->shards[s].lock, NULL);
+    return set;
+}
+
+/**
+ * @brief Adds a cycle unless one of its rotations is already in the set.
+ * @param set The set.
+ * @param vertices The distinct vertices of the cycle in order.
+ * @param length The number of vertices, at least 1.
+ * @return 1 if the cycle was added, 0 if it was already in the set, -1 on allocation failure.
+ */
+int cycle_set_insert(cycle_set_t *set, const int *vertices, size_t length) {
+    size_t first = 0;
+    for (size_t i = 1; i < length; i++) {
+        if (vertices[i] < vertices[first]) first = i;
+    }
+    uint64_t hash = hash_rotation(vertices, length, first);
+    cycle_set_shard_t *shard = &set->shards[hash >> (64 - CYCLE_SET_SHARD_BITS)];
+
+    int status = -1;
+    pthread_mutex_lock(&shard->lock);
+    if ((shard->count + 1) * 100 > shard->capacity * CYCLE_SET_MAX_LOAD
+        && resize(shard, shard->capacity ? shard->capacity * 2 : CYCLE_SET_MIN_CAPACITY) != 0) {
+        goto done;
+    }
+
+    size_t mask = shard->capacity - 1;
+    size_t i = hash & mask;
+    for (; shard->slots[i].length != 0; i = (i + 1) & mask) {
+        const cycle_set_slot_t *slot = &shard->slots[i];
+        if (slot->hash == hash && slot->length == length
+            && same_rotation(shard->arena + slot->offset, vertices, length, first)) {
+            status = 0;
+            goto done;
+        }
+    }
+
+    if (shard->arena_capacity - shard->arena_size < length) {
+        size_t capacity = shard->arena_capacity ? shard->arena_capacity : 256;
+        while (capacity - shard->arena_size < length) capacity *= 2;
+        int *arena = realloc(shard->arena, capacity * sizeof(int));
+        if (!arena) goto done;
+        shard->arena = arena;
+        shard->arena_capacity = capacity;
+    }
+    int *stored = shard->arena + shard->arena_size;
+    memcpy(stored, vertices + first, (length - first) * sizeof(int));
+    memcpy(stored + (length - first), vertices, first * sizeof(int));
+    shard->slots[i] = (cycle_set_slot_t){hash, shard->arena_size, length};
+    shard->arena_size += length;
+    shard->count++;
+    status = 1;
+
+done:
+    pthread_mutex_unlock(&shard->lock);
+    return status;
+}
+
+/**
+ * @brief Frees a set.
+ * @param set The set to be freed, or NULL.
+ */
+void cycle_set_free(cycle_set_t *set) {
+    if (!set) return;
+    for (size_t s = 0; s < CYCLE_SET_SHARDS; s++) {
+        pthread_mutex_destroy(&set->shards[s].lock);
+        free(set->shards[s].slots);
+        free(set->shards[s].arena);
+    }
+    free(set);
+}
+
+ /** @} */
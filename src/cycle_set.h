@@ -0,0 +1,46 @@
+/**
+ * @file cycle_set.h
+ * @brief Defines a concurrent set of cycles, used to report each cycle once.
+ *
+ * A cycle is a sequence of vertices read around the loop, so the same cycle
+ * can be found starting from any of its vertices. The set canonicalizes each
+ * cycle by rotating it to start at its smallest vertex, hashes that rotation,
+ * and keeps the canonical sequence so that equal hashes are confirmed exactly.
+ * The table is split into independently locked shards chosen by hash, so
+ * search threads rarely wait for each other.
+ */
+
+#ifndef E82B4C17_5F3A_4D90_9B6E_2A7D1C0F54E8
+#define E82B4C17_5F3A_4D90_9B6E_2A7D1C0F54E8
+
+#include <stddef.h>
+
+/**
+ * @struct cycle_set_t
+ * @brief An opaque type for the set.
+ */
+typedef struct cycle_set_t cycle_set_t;
+
+/**
+ * @brief Creates an empty set.
+ * @return The set, or NULL on allocation failure.
+ */
+cycle_set_t *cycle_set_create(void);
+
+/**
+ * @brief Adds a cycle unless one of its rotations is already in the set. Thread-safe.
+ * @param set The set.
+ * @param vertices The vertices of the cycle in order, without repeating the first one at the end.
+ *                 They must be distinct, as in an elementary cycle.
+ * @param length The number of vertices, at least 1.
+ * @return 1 if the cycle was added, 0 if it was already in the set, -1 on allocation failure.
+ */
+int cycle_set_insert(cycle_set_t *set, const int *vertices, size_t length);
+
+/**
+ * @brief Frees a set.
+ * @param set The set to be freed, or NULL.
+ */
+void cycle_set_free(cycle_set_t *set);
+
+#endif /* E82B4C17_5F3A_4D90_9B6E_2A7D1C0F54E8 */
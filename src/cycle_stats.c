@@ -0,0 +1,207 @@
+/**
+ * @file cycle_stats.c
+ * @brief Implementation of the per-cycle aggregates.
+ * @defgroup cycle_stats Cycle Statistics
+ * @{
+ */
+
+#include "cycle_stats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const cycle_stat_info_t cycle_stat_info[CYCLE_STAT_KINDS] = {
+    {CYCLE_STAT_MAX, "max", "Max Flow: %s WEI\n", "Max Flow in Cycle: %s\n"},
+    {CYCLE_STAT_MIN, "min", "Bottleneck Flow: %s WEI\n", "Bottleneck Flow in Cycle: %s\n"},
+    {CYCLE_STAT_SUM, "sum", "Total Volume: %s WEI\n", "Total Volume in Cycle: %s\n"},
+    {CYCLE_STAT_COUNT, "count", "Length: %s\n", "Cycle Length: %s\n"},
+};
+
+/**
+ * @brief Allocates the arrays of a monotonic stack.
+ * @param m The stack.
+ * @param n The capacity.
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int path_mono_init(path_mono_t *m, size_t n) {
+    m->size = 0;
+    m->items = calloc(n, sizeof(int));
+    m->saved_pos = malloc(n * sizeof(int));
+    m->saved_item = malloc(n * sizeof(int));
+    m->saved_size = malloc(n * sizeof(int));
+    return m->items && m->saved_pos && m->saved_item && m->saved_size ? 0 : -1;
+}
+
+/**
+ * @brief Frees the arrays of a monotonic stack.
+ * @param m The stack.
+ */
+static void path_mono_destroy(path_mono_t *m) {
+    free(m->items);
+    free(m->saved_pos);
+    free(m->saved_item);
+    free(m->saved_size);
+    memset(m, 0, sizeof(*m));
+}
+
+/**
+ * @brief Allocates the arrays of an empty path.
+ * @param ps The path.
+ * @param capacity The most edges the path will hold.
+ * @param stats The aggregates to maintain.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int path_stats_init(path_stats_t *ps, size_t capacity, unsigned stats) {
+    memset(ps, 0, sizeof(*ps));
+    ps->stats = stats;
+    size_t n = capacity ? capacity : 1;
+    int status = 0;
+    if (stats & (CYCLE_STAT_MAX | CYCLE_STAT_MIN)) {
+        ps->values = malloc(n * sizeof(uint256_t));
+        if (!ps->values) status = -1;
+    }
+    if (stats & CYCLE_STAT_SUM) {
+        ps->prefix_sum = malloc((n + 1) * sizeof(uint320_t));
+        if (ps->prefix_sum) {
+            memset(&ps->prefix_sum[0], 0, sizeof(uint320_t));
+        } else {
+            status = -1;
+        }
+    }
+    if ((stats & CYCLE_STAT_MAX) && path_mono_init(&ps->max, n) != 0) status = -1;
+    if ((stats & CYCLE_STAT_MIN) && path_mono_init(&ps->min, n) != 0) status = -1;
+    if (status != 0) path_stats_destroy(ps);
+    return status;
+}
+
+/**
+ * @brief Frees the arrays of a path.
+ * @param ps The path.
+ */
+void path_stats_destroy(path_stats_t *ps) {
+    free(ps->values);
+    free(ps->prefix_sum);
+    path_mono_destroy(&ps->max);
+    path_mono_destroy(&ps->min);
+    ps->values = NULL;
+    ps->prefix_sum = NULL;
+    ps->length = 0;
+}
+
+/**
+ * @brief Parses a comma-separated list of aggregate names.
+ * @param list The list.
+ * @param stats Receives the set of CYCLE_STAT_* flags.
+ * @return 0 on success, -1 on an unknown or empty name.
+ */
+int cycle_stats_parse(const char *list, unsigned *stats) {
+    unsigned mask = 0;
+    const char *p = list;
+    for (;;) {
+        size_t len = strcspn(p, ",");
+        int found = 0;
+        for (int k = 0; k < CYCLE_STAT_KINDS; k++) {
+            if (strlen(cycle_stat_info[k].name) == len && strncmp(p, cycle_stat_info[k].name, len) == 0) {
+                mask |= cycle_stat_info[k].flag;
+                found = 1;
+            }
+        }
+        if (!found) return -1;
+        if (p[len] == '\0') break;
+        p += len + 1;
+    }
+    *stats = mask;
+    return 0;
+}
+
+/**
+ * @brief Returns the size of the aggregates packed by cycle_stats_pack().
+ * @param mask The aggregates packed.
+ * @return The size in bytes.
+ */
+size_t cycle_stats_packed_size(unsigned mask) {
+    size_t size = 0;
+    if (mask & CYCLE_STAT_MAX) size += sizeof(uint256_t);
+    if (mask & CYCLE_STAT_MIN) size += sizeof(uint256_t);
+    if (mask & CYCLE_STAT_SUM) size += sizeof(uint320_t);
+    if (mask & CYCLE_STAT_COUNT) size += sizeof(size_t);
+    return size;
+}
+
+/**
+ * @brief Copies the requested aggregates to a byte buffer.
+ * @param stats The aggregates.
+ * @param mask The aggregates to copy.
+ * @param out A buffer of at least cycle_stats_packed_size(mask) bytes.
+ * @return The end of what was written.
+ */
+char *cycle_stats_pack(const cycle_stats_t *stats, unsigned mask, char *out) {
+    if (mask & CYCLE_STAT_MAX) {
+        memcpy(out, &stats->max, sizeof(uint256_t));
+        out += sizeof(uint256_t);
+    }
+    if (mask & CYCLE_STAT_MIN) {
+        memcpy(out, &stats->min, sizeof(uint256_t));
+        out += sizeof(uint256_t);
+    }
+    if (mask & CYCLE_STAT_SUM) {
+        memcpy(out, &stats->sum, sizeof(uint320_t));
+        out += sizeof(uint320_t);
+    }
+    if (mask & CYCLE_STAT_COUNT) {
+        memcpy(out, &stats->count, sizeof(size_t));
+        out += sizeof(size_t);
+    }
+    return out;
+}
+
+/**
+ * @brief Reads back aggregates written by cycle_stats_pack().
+ * @param stats Receives the aggregates in mask.
+ * @param mask The aggregates that were packed.
+ * @param in The packed aggregates.
+ * @return The end of what was read.
+ */
+const char *cycle_stats_unpack(cycle_stats_t *stats, unsigned mask, const char *in) {
+    if (mask & CYCLE_STAT_MAX) {
+        memcpy(&stats->max, in, sizeof(uint256_t));
+        in += sizeof(uint256_t);
+    }
+    if (mask & CYCLE_STAT_MIN) {
+        memcpy(&stats->min, in, sizeof(uint256_t));
+        in += sizeof(uint256_t);
+    }
+    if (mask & CYCLE_STAT_SUM) {
+        memcpy(&stats->sum, in, sizeof(uint320_t));
+        in += sizeof(uint320_t);
+    }
+    if (mask & CYCLE_STAT_COUNT) {
+        memcpy(&stats->count, in, sizeof(size_t));
+        in += sizeof(size_t);
+    }
+    return in;
+}
+
+/**
+ * @brief Writes one aggregate in decimal.
+ * @param stats The aggregates.
+ * @param flag The CYCLE_STAT_* flag of the aggregate.
+ * @param buf A buffer of at least UINT320_DEC_SIZE bytes.
+ * @return buf.
+ */
+char *cycle_stat_to_dec(const cycle_stats_t *stats, unsigned flag, char *buf) {
+    switch (flag) {
+        case CYCLE_STAT_MAX:
+            return uint256_to_dec(&stats->max, buf);
+        case CYCLE_STAT_MIN:
+            return uint256_to_dec(&stats->min, buf);
+        case CYCLE_STAT_SUM:
+            return uint320_to_dec(&stats->sum, buf);
+        default:
+            sprintf(buf, "%zu", stats->count);
+            return buf;
+    }
+}
+
+ /** @} */
@@ -0,0 +1,265 @@
+/**
+ * @file cycle_stats.h
+ * @brief Defines the per-cycle aggregates and the path structure that maintains them.
+ *
+ * Every cycle the searches report is a suffix of the current DFS path plus
+ * one closing edge. Rescanning that suffix for each cycle costs its length
+ * again; instead, the path keeps running aggregates as edges are pushed and
+ * popped, and the aggregates of any suffix are read off in O(log n):
+ *
+ * - the sum from prefix sums (320 bits wide, so it never overflows),
+ * - the maximum and the minimum from monotonic stacks of suffix extremes.
+ *   Pushing an edge writes one slot of a stack and truncates it there. That
+ *   push records what the slot held, so popping the edge restores the stack
+ *   exactly, which lets the stacks follow a DFS that backtracks.
+ */
+
+#ifndef D63A9F0E_2B7C_4E15_8A4D_C1E05B97F382
+#define D63A9F0E_2B7C_4E15_8A4D_C1E05B97F382
+
+#include <stddef.h>
+
+#include "uint256.h"
+
+/** @def CYCLE_STAT_MAX
+ *  @brief The largest edge value of a cycle.
+ */
+#define CYCLE_STAT_MAX (1u << 0)
+
+/** @def CYCLE_STAT_MIN
+ *  @brief The smallest edge value of a cycle: the amount that can actually go around it.
+ */
+#define CYCLE_STAT_MIN (1u << 1)
+
+/** @def CYCLE_STAT_SUM
+ *  @brief The total value moved along a cycle.
+ */
+#define CYCLE_STAT_SUM (1u << 2)
+
+/** @def CYCLE_STAT_COUNT
+ *  @brief The number of edges of a cycle.
+ */
+#define CYCLE_STAT_COUNT (1u << 3)
+
+/** @def CYCLE_STAT_KINDS
+ *  @brief The number of aggregates.
+ */
+#define CYCLE_STAT_KINDS 4
+
+/**
+ * @struct cycle_stats_t
+ * @brief The aggregates of one cycle; only the requested ones are filled.
+ */
+typedef struct {
+    uint256_t max;               /**< The largest edge value. */
+    uint256_t min;               /**< The smallest edge value. */
+    uint320_t sum;               /**< The sum of the edge volumes. */
+    size_t count;                /**< The number of edges. */
+} cycle_stats_t;
+
+/**
+ * @struct cycle_stat_info_t
+ * @brief The name and output labels of one aggregate.
+ */
+typedef struct {
+    unsigned flag;               /**< The CYCLE_STAT_* flag. */
+    const char *name;            /**< The name used on the command line. */
+    const char *file_format;     /**< printf format of its line in the output file, taking the value as a string. */
+    const char *log_format;      /**< printf format of its line in the verbose log. */
+} cycle_stat_info_t;
+
+/** @brief The aggregates, in output order. */
+extern const cycle_stat_info_t cycle_stat_info[CYCLE_STAT_KINDS];
+
+/**
+ * @struct path_mono_t
+ * @brief An undoable monotonic stack of the path edges that are the extreme of some suffix.
+ *
+ * From bottom to top, edges are in path order and strictly decreasing in the
+ * stack's order (greater for the maximum, smaller for the minimum), so the
+ * extreme of the suffix starting at edge i is the lowest entry at or after i.
+ */
+typedef struct {
+    int *items;                  /**< The path indices of the entries. */
+    int size;                    /**< The number of entries. */
+    int *saved_pos;              /**< Per path index: the position its push wrote. */
+    int *saved_item;             /**< Per path index: what its push overwrote, live or not. */
+    int *saved_size;             /**< Per path index: the size before its push. */
+} path_mono_t;
+
+/**
+ * @struct path_stats_t
+ * @brief The running aggregates of the edges on a DFS path.
+ */
+typedef struct {
+    unsigned stats;              /**< The aggregates maintained, a set of CYCLE_STAT_* flags. */
+    int length;                  /**< The number of edges on the path. */
+    uint256_t *values;           /**< The value of each edge on the path (for MAX and MIN). */
+    uint320_t *prefix_sum;       /**< prefix_sum[i] is the volume of edges 0 .. i - 1 (for SUM). */
+    path_mono_t max;             /**< Suffix maxima (for MAX). */
+    path_mono_t min;             /**< Suffix minima (for MIN). */
+} path_stats_t;
+
+/**
+ * @brief Allocates the arrays of an empty path.
+ * @param ps The path.
+ * @param capacity The most edges the path will hold.
+ * @param stats The aggregates to maintain.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int path_stats_init(path_stats_t *ps, size_t capacity, unsigned stats);
+
+/**
+ * @brief Frees the arrays of a path. Safe on a zeroed path.
+ * @param ps The path.
+ */
+void path_stats_destroy(path_stats_t *ps);
+
+/**
+ * @brief Pushes index i onto a monotonic stack, dropping the entries it dominates.
+ * @param m The stack.
+ * @param values The edge values of the path.
+ * @param i The path index, the new last edge.
+ * @param dir 1 for a stack of maxima, -1 for a stack of minima.
+ */
+static inline void path_mono_push(path_mono_t *m, const uint256_t *values, int i, int dir) {
+    int lo = 0, hi = m->size;
+    if (hi > 0 && dir * uint256_cmp(&values[m->items[hi - 1]], &values[i]) > 0) {
+        lo = hi; // The usual case: nothing is dominated.
+    }
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (dir * uint256_cmp(&values[m->items[mid]], &values[i]) > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    m->saved_pos[i] = lo;
+    m->saved_item[i] = m->items[lo]; // Even past size: an outer pop may bring it back to life.
+    m->saved_size[i] = m->size;
+    m->items[lo] = i;
+    m->size = lo + 1;
+}
+
+/**
+ * @brief Undoes the push of index i, which must be the last one not undone.
+ * @param m The stack.
+ * @param i The path index.
+ */
+static inline void path_mono_pop(path_mono_t *m, int i) {
+    m->items[m->saved_pos[i]] = m->saved_item[i];
+    m->size = m->saved_size[i];
+}
+
+/**
+ * @brief Finds the extreme edge of the path suffix starting at index start.
+ * @param m The stack.
+ * @param start The first path index of the suffix.
+ * @return The path index of the extreme, or -1 if the suffix is empty.
+ */
+static inline int path_mono_query(const path_mono_t *m, int start) {
+    int lo = 0, hi = m->size;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (m->items[mid] < start) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < m->size ? m->items[lo] : -1;
+}
+
+/**
+ * @brief Appends an edge to the path.
+ * @param ps The path.
+ * @param value The value of the edge (used by MAX and MIN).
+ * @param volume The volume of the edge (used by SUM).
+ */
+static inline void path_stats_push(path_stats_t *ps, const uint256_t *value, const uint256_t *volume) {
+    int i = ps->length++;
+    if (ps->stats & CYCLE_STAT_SUM) uint320_add_u256(&ps->prefix_sum[i + 1], &ps->prefix_sum[i], volume);
+    if (ps->stats & (CYCLE_STAT_MAX | CYCLE_STAT_MIN)) ps->values[i] = *value;
+    if (ps->stats & CYCLE_STAT_MAX) path_mono_push(&ps->max, ps->values, i, 1);
+    if (ps->stats & CYCLE_STAT_MIN) path_mono_push(&ps->min, ps->values, i, -1);
+}
+
+/**
+ * @brief Removes the last edge of the path.
+ * @param ps The path.
+ */
+static inline void path_stats_pop(path_stats_t *ps) {
+    int i = --ps->length;
+    if (ps->stats & CYCLE_STAT_MAX) path_mono_pop(&ps->max, i);
+    if (ps->stats & CYCLE_STAT_MIN) path_mono_pop(&ps->min, i);
+}
+
+/**
+ * @brief Computes the aggregates of the cycle made of the path edges from start on, plus a closing edge.
+ * @param ps The path.
+ * @param start The first path index of the cycle.
+ * @param value The value of the closing edge.
+ * @param volume The volume of the closing edge.
+ * @param out Receives the aggregates maintained by the path.
+ */
+static inline void path_stats_cycle(const path_stats_t *ps, int start, const uint256_t *value,
+                                    const uint256_t *volume, cycle_stats_t *out) {
+    out->count = (size_t)(ps->length - start) + 1;
+    if (ps->stats & CYCLE_STAT_MAX) {
+        int i = path_mono_query(&ps->max, start);
+        out->max = i < 0 ? *value : *uint256_max(&ps->values[i], value);
+    }
+    if (ps->stats & CYCLE_STAT_MIN) {
+        int i = path_mono_query(&ps->min, start);
+        out->min = i < 0 ? *value : *uint256_min(&ps->values[i], value);
+    }
+    if (ps->stats & CYCLE_STAT_SUM) {
+        uint320_sub(&out->sum, &ps->prefix_sum[ps->length], &ps->prefix_sum[start]);
+        uint320_add_u256(&out->sum, &out->sum, volume);
+    }
+}
+
+/**
+ * @brief Parses a comma-separated list of aggregate names, e.g. "min,sum".
+ * @param list The list.
+ * @param stats Receives the set of CYCLE_STAT_* flags.
+ * @return 0 on success, -1 on an unknown or empty name.
+ */
+int cycle_stats_parse(const char *list, unsigned *stats);
+
+/**
+ * @brief Returns the size of the aggregates packed by cycle_stats_pack().
+ * @param mask The aggregates packed.
+ * @return The size in bytes.
+ */
+size_t cycle_stats_packed_size(unsigned mask);
+
+/**
+ * @brief Copies the requested aggregates, raw and unaligned, to a byte buffer.
+ * @param stats The aggregates.
+ * @param mask The aggregates to copy.
+ * @param out A buffer of at least cycle_stats_packed_size(mask) bytes.
+ * @return The end of what was written.
+ */
+char *cycle_stats_pack(const cycle_stats_t *stats, unsigned mask, char *out);
+
+/**
+ * @brief Reads back aggregates written by cycle_stats_pack().
+ * @param stats Receives the aggregates in mask; the others are left alone.
+ * @param mask The aggregates that were packed.
+ * @param in The packed aggregates.
+ * @return The end of what was read.
+ */
+const char *cycle_stats_unpack(cycle_stats_t *stats, unsigned mask, const char *in);
+
+/**
+ * @brief Writes one aggregate in decimal.
+ * @param stats The aggregates.
+ * @param flag The CYCLE_STAT_* flag of the aggregate.
+ * @param buf A buffer of at least UINT320_DEC_SIZE bytes.
+ * @return buf.
+ */
+char *cycle_stat_to_dec(const cycle_stats_t *stats, unsigned flag, char *buf);
+
+#endif /* D63A9F0E_2B7C_4E15_8A4D_C1E05B97F382 */
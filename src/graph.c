@@ -8,166 +8,929 @@
     
 
 #include "graph.h"
+#include "block_queue.h"
+#include "cycle_file.h"
+#include "cycle_set.h"
+#include "cycle_stats.h"
+#include "scc.h"
+#include "simd_parse.h"
+#include "work_pool.h"
 
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <time.h>
 
-// --- GLOBAL DEFINITION ---
+// --- FORWARD DECLARATIONS FOR STATIC HELPERS ---
 
 /**
- * @brief Global pointer to the head of the vertex hash map.
+ * @struct DFSFrame
+ * @brief One level of the explicit DFS stack: a vertex and where its edge scan resumes.
  */
-VertexMap *vertex_map = NULL;
+typedef struct {
+    vertex v;                    /**< The vertex on the current path. */
+    size_t nextEdge;             /**< CSR index of the next out-edge of v to explore. */
+} DFSFrame;
 
-// --- FORWARD DECLARATIONS FOR STATIC HELPERS ---
+/**
+ * @struct CycleOutput
+ * @brief The output of a search, shared by the search threads and the writer thread.
+ *
+ * Search threads pack the cycles they find into blocks of binary records and
+ * queue the blocks; the writer thread numbers, formats and writes them, so
+ * formatting and write calls stay out of the search loops. The writer emits
+ * either text or the binary format of cycle_file.h.
+ */
+typedef struct {
+    FILE *file;                  /**< The output file. */
+    log_function_t log;          /**< The logging function. */
+    unsigned stats;              /**< The aggregates reported per cycle, a set of CYCLE_STAT_* flags. */
+    bool binary;                 /**< Write the binary format instead of text. */
+    const address_t *addresses;  /**< The wallet of each vertex, to write addresses instead of ids, or NULL. */
+    const vertex *globalIds;     /**< The id each vertex is written with, for a region (GraphDS.globalIds), or NULL. */
+    cycle_set_t *seen;           /**< The vertex cycles reported so far, or NULL if duplicates are not dropped. */
+    block_queue_t *queue;        /**< Blocks of records on their way to the writer. */
+    pthread_t writer;            /**< The writer thread. */
+    char *text;                  /**< Formatted output not written yet. Writer only. */
+    size_t textSize;             /**< The number of bytes in use in text. */
+    size_t textCapacity;         /**< The allocated size of text. */
+    uint64_t written;            /**< Bytes of output handed to the file so far. Writer only. */
+    bool writeFailed;            /**< Set once a write to the file failed. Writer only. */
+    size_t cycles;               /**< The number of cycles written so far; numbers the next one. Writer only. */
+    vertex *vertices;            /**< The vertices of the record being formatted. Writer only. */
+    size_t vertexCapacity;       /**< The allocated size of vertices. */
+    uint64_t *index;             /**< The offset of every CYCLE_FILE_INDEX_STRIDE-th record, in binary mode. */
+    size_t indexSize;            /**< The number of entries in index. */
+    size_t indexCapacity;        /**< The allocated size of index. */
+} CycleOutput;
+
+/**
+ * @struct CycleBuffer
+ * @brief The cycles found by one thread and not queued yet.
+ *
+ * Each record is the number of vertices (uint32_t), the vertices of the cycle
+ * from the one it was entered at, and the requested aggregates as packed by
+ * cycle_stats_pack(). Records are numbered only by the writer, so threads
+ * never contend for the counter while searching.
+ */
+typedef struct {
+    CycleOutput *out;            /**< Where the records are queued to. */
+    queue_block_t *block;        /**< The block being filled, or NULL. */
+    vertex *cycle;               /**< Scratch copy of the vertices of a cycle, for the duplicate check. */
+    size_t cycleCapacity;        /**< The allocated size of cycle. */
+    size_t duplicates;           /**< Cycles dropped because they were already reported. */
+} CycleBuffer;
 
-static void addToHash(const char *name, size_t *current_index);
-static Graph hashToGraph(FILE *file, Graph G, size_t totalTransactions, parse_wei_ctx_t *ctx);
-static void recursiveDFS(Graph G, int *visited, int *recStack, int *path, mpz_t *valuesPath, int *depth, vertex v, FILE *p, log_function_t log_func, size_t *cycle_count);
+/**
+ * @struct DFSState
+ * @brief The working arrays of one thread of the cycle search.
+ *
+ * The per-vertex arrays are shared by all threads; each thread only touches
+ * the vertices of the SCC it is exploring. The path arrays are private and
+ * sized by the largest SCC.
+ */
+typedef struct {
+    unsigned char *visited;      /**< Non-zero once a vertex has been entered. Shared. */
+    int *stackPos;               /**< Depth of each vertex on the current path, or -1 if it is not on it. */
+    DFSFrame *frames;            /**< The current path, root first. */
+    path_stats_t path;           /**< The running aggregates of the edges on the current path. */
+    const int *component;        /**< SCC id of each vertex; the search stays inside one SCC. */
+    CycleBuffer *output;         /**< The cycles found by this thread. */
+} DFSState;
 
-// --- HASHMAP FUNCTIONS ---
+/**
+ * @struct BlockEntry
+ * @brief An entry of a Johnson B-list: vertex v waits on the owner of the list through edge `edge`.
+ */
+typedef struct {
+    vertex v;                    /**< The blocked vertex to release. */
+    size_t edge;                 /**< The CSR edge from v to the owner of the list. */
+} BlockEntry;
 
 /**
- * @brief Adds a new vertex to the hash map if it doesn't already exist.
- * @param name The vertex name (wallet address).
- * @param current_index A pointer to the next available index, which is incremented if a new vertex is added.
+ * @struct BlockList
+ * @brief The vertices to unblock when a vertex is unblocked (Johnson's B(v)).
  */
-static void addToHash(const char *name, size_t *current_index) {
-    VertexMap *v;
-    HASH_FIND_STR(vertex_map, name, v);
-    if (v == NULL) {
-        v = malloc(sizeof(VertexMap));
-        if (!v) {
-            fprintf(stderr, "Fatal: malloc failed in addToHash.\n");
-            exit(EXIT_FAILURE);
+typedef struct {
+    BlockEntry *items;           /**< The entries. */
+    size_t count;                /**< The number of entries in use. */
+    size_t capacity;             /**< The allocated size of items. */
+} BlockList;
+
+/**
+ * @struct JohnsonState
+ * @brief The working arrays of one thread of Johnson's algorithm.
+ *
+ * Subproblems are disjoint vertex sets, so the per-vertex and per-edge arrays
+ * are shared by all threads. The path arrays are private and sized by the
+ * largest SCC.
+ */
+typedef struct {
+    unsigned char *blocked;      /**< Per vertex: non-zero while it cannot lead back to the start. Shared. */
+    BlockList *blockLists;       /**< Per vertex: its B-list. Shared. */
+    unsigned char *inBlockList;  /**< Per edge: non-zero while its source is in the B-list of its destination. Shared. */
+    DFSFrame *frames;            /**< The current path, start vertex first. */
+    unsigned char *found;        /**< Per depth: non-zero once a cycle was found below that frame. */
+    path_stats_t path;           /**< The running aggregates of the edges on the current path. */
+    vertex *unblockStack;        /**< Worklist of unblock(). */
+    int *label;                  /**< Subproblem label of each vertex; the search stays inside one label. Shared. */
+    scc_workspace_t *ws;         /**< Tarjan scratch arrays for splitting subproblems. */
+    vertex *children;            /**< Receives the members of the child subproblems. */
+    size_t *childOffsets;        /**< Receives the boundaries of the child subproblems. */
+    CycleBuffer *output;         /**< The cycles found by this thread. */
+} JohnsonState;
+
+static void reserveVertices(Graph G, size_t V);
+static void iterativeDFS(Graph G, vertex root, DFSState *state, log_function_t log_func);
+
+// --- GRAPH LOADER FUNCTIONS ---
+
+/**
+ * @struct PendingEdge
+ * @brief An edge parsed by a loader thread, waiting for its endpoints' final indices.
+ *
+ * Endpoints are provisional ids: the shard number in the upper 32 bits and the
+ * index inside that shard's address map in the lower 32 bits.
+ */
+typedef struct {
+    uint64_t from;               /**< Provisional id of the sender. */
+    uint64_t to;                 /**< Provisional id of the receiver. */
+    uint256_t value;             /**< The parsed transaction value. */
+    uint64_t timestamp;          /**< The parsed timestamp, or 0. */
+} PendingEdge;
+
+/**
+ * @struct VertexShard
+ * @brief One lock-protected slice of the address map shared by the loader threads.
+ */
+typedef struct {
+    pthread_mutex_t lock;        /**< Serializes access to the fields below. */
+    address_map_t *map;          /**< Wallets of this shard, indexed by order of insertion. */
+    size_t *firstSeen;           /**< Smallest input offset each wallet was seen at. */
+    size_t firstSeenCapacity;    /**< Allocated size of firstSeen. */
+    uint32_t *finalIndex;        /**< Vertex index of each wallet, filled after parsing. */
+} VertexShard;
+
+/**
+ * @def CSV_MAX_FIELDS
+ * @brief Most CSV columns the loader looks at, in the header and in each row.
+ */
+#define CSV_MAX_FIELDS 64
+
+/**
+ * @def CSV_NO_COLUMN
+ * @brief Column index of an optional CSV column missing from the header.
+ */
+#define CSV_NO_COLUMN SIZE_MAX
+
+/**
+ * @struct InputFormat
+ * @brief How the lines of the input are laid out.
+ *
+ * Either the whitespace-separated `sender receiver value [timestamp]` text,
+ * or an ethereum-etl transactions.csv, recognised by its header, whose
+ * columns are found by name.
+ */
+typedef struct {
+    bool csv;                    /**< True for an ethereum-etl CSV; its header line is not a transaction. */
+    size_t from;                 /**< Column of from_address. */
+    size_t to;                   /**< Column of to_address. */
+    size_t value;                /**< Column of value. */
+    size_t block;                /**< Column of block_number, or CSV_NO_COLUMN. */
+    size_t fields;               /**< Columns to split per row: one past the last one read. */
+    size_t header;               /**< Bytes of the header line, newline included, when the input is mapped. */
+    size_t filtered;             /**< CSV rows dropped: zero value, self-transfer or no receiver (contract creation). */
+} InputFormat;
+
+/**
+ * @struct LoadWorker
+ * @brief State owned by one loader thread: its input chunk and its local edge buffer.
+ */
+typedef struct {
+    input_reader_t *reader;      /**< Reader over this worker's chunk. */
+    const char *base;            /**< First byte of the whole input, to compute offsets. */
+    VertexShard *shards;         /**< The shared, sharded address map. */
+    PendingEdge *edges;          /**< Edges parsed from the chunk, in input order. */
+    size_t edgeCount;            /**< Number of edges in the buffer. */
+    size_t edgeCapacity;         /**< Allocated size of the buffer. */
+    bool hasTimestamps;          /**< True once a line of the chunk had a timestamp. */
+    const InputFormat *format;   /**< The layout of the lines. */
+    size_t filtered;             /**< CSV rows of the chunk dropped by the filters. */
+} LoadWorker;
+
+/**
+ * @struct FirstSeenEntry
+ * @brief Sort record used to number the wallets found by the parallel loader.
+ */
+typedef struct {
+    size_t offset;               /**< Input offset of the first occurrence. */
+    uint64_t id;                 /**< Provisional id of the wallet. */
+} FirstSeenEntry;
+
+/**
+ * @brief Returns a monotonic wall-clock timestamp in seconds.
+ *
+ * clock() adds up the CPU time of every thread, which is misleading once the
+ * loader runs in parallel.
+ */
+static double wallSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Parses a decimal block number or timestamp.
+ * @param s The digits.
+ * @param len The number of digits.
+ * @param out Receives the value.
+ * @return 0 on success, -1 if the token is not a decimal number below 2^64.
+ */
+static int parseTimestamp(const char *s, size_t len, uint64_t *out) {
+    if (len == 0) return -1;
+    uint64_t value = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned digit = (unsigned char)s[i] - '0';
+        if (digit > 9 || value > (UINT64_MAX - digit) / 10) return -1;
+        value = value * 10 + digit;
+    }
+    *out = value;
+    return 0;
+}
+
+/**
+ * @brief Splits one input line into its tokens, decodes both addresses and parses the value.
+ * @param line The line to parse.
+ * @param tokens Receives the sender, receiver, value and optional timestamp tokens.
+ * @param from Receives the sender address.
+ * @param to Receives the receiver address.
+ * @param ctx The Wei parser context.
+ * @param value Receives the parsed value.
+ * @param timestamp Receives the parsed timestamp, or 0 if the line has none.
+ * @return 1 on success, 2 on success with a timestamp, 0 for a blank line, -1 for a malformed line,
+ *         -2 for an invalid value, -3 for a value that does not fit in 256 bits, -4 for an invalid timestamp.
+ */
+static int parseTransaction(input_token_t line, input_token_t tokens[4], address_t *from, address_t *to,
+                            parse_wei_ctx_t *ctx, uint256_t *value, uint64_t *timestamp) {
+    size_t count = input_split_tokens(line, tokens, 4);
+    if (count == 0) return 0;
+    if (count != 3 && count != 4) return -1;
+    if (address_parse(tokens[0].ptr, tokens[0].len, from) != 0) return -1;
+    if (address_parse(tokens[1].ptr, tokens[1].len, to) != 0) return -1;
+    int status = parse_wei_u256(ctx, tokens[2].ptr, tokens[2].len, value);
+    if (status != 0) return status == -3 ? -3 : -2;
+    *timestamp = 0;
+    if (count == 3) return 1;
+    if (parseTimestamp(tokens[3].ptr, tokens[3].len, timestamp) != 0) return -4;
+    return 2;
+}
+
+/**
+ * @brief Recognises the header of an ethereum-etl transactions.csv and finds the columns to read.
+ * @param line The first line of the input.
+ * @param format Receives the columns; csv is set on success.
+ * @return 0 if the line is such a header, -1 otherwise.
+ */
+static int parseCsvHeader(input_token_t line, InputFormat *format) {
+    input_token_t fields[CSV_MAX_FIELDS];
+    size_t count = input_split_csv(line, fields, CSV_MAX_FIELDS);
+    size_t from = CSV_NO_COLUMN, to = CSV_NO_COLUMN, value = CSV_NO_COLUMN, block = CSV_NO_COLUMN;
+    for (size_t i = 0; i < count; i++) {
+        input_token_t name = fields[i];
+        if (name.len >= 2 && name.ptr[0] == '"' && name.ptr[name.len - 1] == '"') {
+            name.ptr++;
+            name.len -= 2;
         }
-        strcpy(v->key, name);
-        v->index = (*current_index)++;
-        HASH_ADD_STR(vertex_map, key, v);
+        size_t *column = NULL;
+        if (name.len == 12 && memcmp(name.ptr, "from_address", 12) == 0) column = &from;
+        else if (name.len == 10 && memcmp(name.ptr, "to_address", 10) == 0) column = &to;
+        else if (name.len == 5 && memcmp(name.ptr, "value", 5) == 0) column = &value;
+        else if (name.len == 12 && memcmp(name.ptr, "block_number", 12) == 0) column = &block;
+        if (column && *column == CSV_NO_COLUMN) *column = i;
     }
+    if (from == CSV_NO_COLUMN || to == CSV_NO_COLUMN || value == CSV_NO_COLUMN) return -1;
+
+    format->csv = true;
+    format->from = from;
+    format->to = to;
+    format->value = value;
+    format->block = block;
+    size_t last = from > to ? from : to;
+    if (value > last) last = value;
+    if (block != CSV_NO_COLUMN && block > last) last = block;
+    format->fields = last + 1;
+    return 0;
 }
 
 /**
- * @brief Fills the hash map with all unique vertices from a file.
- * @param file Pointer to the input file containing transactions.
- * @return The total number of unique vertices found.
+ * @brief Parses one row of an ethereum-etl CSV, applying the filters of the former awk pre-processing step.
+ * @param line The row.
+ * @param format The columns to read.
+ * @param tokens Receives the sender, receiver, value and block number fields, in that order.
+ * @param from Receives the sender address.
+ * @param to Receives the receiver address.
+ * @param ctx The Wei parser context.
+ * @param value Receives the parsed value.
+ * @param timestamp Receives the block number, or 0 if the CSV has none.
+ * @return The codes of parseTransaction(), plus 3 for a row dropped because its value is zero, it is a
+ *         self-transfer or it has no receiver.
  */
-size_t addAllVertexToHashmap(FILE *file) {
-    char from_ad[43], to_ad[43], value_str[100];
-    size_t index = 0;
+static int parseCsvTransaction(input_token_t line, const InputFormat *format, input_token_t tokens[4],
+                               address_t *from, address_t *to, parse_wei_ctx_t *ctx, uint256_t *value,
+                               uint64_t *timestamp) {
+    if (line.len == 0) return 0;
+    input_token_t fields[CSV_MAX_FIELDS];
+    if (input_split_csv(line, fields, format->fields) != format->fields) return -1;
+    tokens[0] = fields[format->from];
+    tokens[1] = fields[format->to];
+    tokens[2] = fields[format->value];
+    if (format->block != CSV_NO_COLUMN) tokens[3] = fields[format->block];
+
+    if (tokens[1].len == 0) return 3; // Contract creation.
+    if (address_parse(tokens[0].ptr, tokens[0].len, from) != 0) return -1;
+    if (address_parse(tokens[1].ptr, tokens[1].len, to) != 0) return -1;
+    if (memcmp(from, to, sizeof(address_t)) == 0) return 3;
+    int status = parse_wei_u256(ctx, tokens[2].ptr, tokens[2].len, value);
+    if (status != 0) return status == -3 ? -3 : -2;
+    if (uint256_is_zero(value)) return 3;
+    *timestamp = 0;
+    if (format->block == CSV_NO_COLUMN) return 1;
+    if (parseTimestamp(tokens[3].ptr, tokens[3].len, timestamp) != 0) return -4;
+    return 2;
+}
 
-    while (fscanf(file, "%42s %42s %99s", from_ad, to_ad, value_str) == 3) {
-        addToHash(from_ad, &index);
-        addToHash(to_ad, &index);
+/**
+ * @brief Adds a wallet to the address map if it doesn't already exist.
+ * @param map The address map.
+ * @param key The binary wallet address.
+ * @return The index of the wallet, either the existing one or the newly assigned one.
+ */
+static size_t internVertex(address_map_t *map, const address_t *key) {
+    uint32_t index = address_map_intern(map, key, NULL);
+    if (index == ADDRESS_MAP_EMPTY) {
+        fprintf(stderr, "Fatal: could not grow the address map.\n");
+        exit(EXIT_FAILURE);
     }
     return index;
 }
 
 /**
- * @brief Retrieves the integer index for a given vertex name.
- * @param name The wallet address to look up.
- * @return The index of the vertex. Returns 0 if not found (assuming valid indices are > 0 or checks are done).
- * @note This function assumes the vertex exists. A robust implementation might handle misses.
+ * @brief Reads lines up to the next transaction, warning about the ones skipped.
+ *
+ * A CSV header on the first line sets the format; filtered CSV rows are counted.
+ *
+ * @param reader The input reader.
+ * @param format The layout of the lines.
+ * @param ctx The Wei parser context.
+ * @param lineNumber The number of lines read so far; advanced past the transaction.
+ * @param from Receives the sender address.
+ * @param to Receives the receiver address.
+ * @param value Receives the parsed value.
+ * @param timestamp Receives the parsed timestamp, or 0 if the line has none.
+ * @return 1 for a transaction, 2 for one with a timestamp, 0 at end of input, -1 on read error.
  */
-size_t getVertexIndex(const char *name) {
-    VertexMap *v;
-    HASH_FIND_STR(vertex_map, name, v);
-    // This assumes v will not be NULL. The caller must ensure 'name' is in the map.
-    return v->index;
+static int nextTransaction(input_reader_t *reader, InputFormat *format, parse_wei_ctx_t *ctx, size_t *lineNumber,
+                           address_t *from, address_t *to, uint256_t *value, uint64_t *timestamp) {
+    input_token_t line, tokens[4];
+    int status;
+    while ((status = input_reader_next_line(reader, &line)) == 1) {
+        (*lineNumber)++;
+        if (*lineNumber == 1 && parseCsvHeader(line, format) == 0) continue;
+        int parsed = format->csv ? parseCsvTransaction(line, format, tokens, from, to, ctx, value, timestamp)
+                                 : parseTransaction(line, tokens, from, to, ctx, value, timestamp);
+        if (parsed == 3) {
+            format->filtered++;
+            continue;
+        }
+        if (parsed == -1) {
+            fprintf(stderr, "Warning: Malformed line %zu. Skipping.\n", *lineNumber);
+        } else if (parsed == -2) {
+            fprintf(stderr, "Warning: Failure parsing the value '%.*s' at line %zu. Skipping transaction.\n",
+                    (int)tokens[2].len, tokens[2].ptr, *lineNumber);
+        } else if (parsed == -3) {
+            fprintf(stderr, "Warning: Value '%.*s' at line %zu exceeds 256 bits. Skipping transaction.\n",
+                    (int)tokens[2].len, tokens[2].ptr, *lineNumber);
+        } else if (parsed == -4) {
+            fprintf(stderr, "Warning: Failure parsing the timestamp '%.*s' at line %zu. Skipping transaction.\n",
+                    (int)tokens[3].len, tokens[3].ptr, *lineNumber);
+        }
+        if (parsed > 0) return parsed;
+    }
+    return status;
 }
 
 /**
- * @brief Frees all memory allocated for the vertex hash map.
+ * @brief Loads the graph from a streamed input, one line at a time.
+ * @param reader The input reader.
+ * @param expectedWallets Estimated number of wallets, used to pre-size the address map.
+ * @param format The layout of the lines; detected from the first line when it is a CSV header.
+ * @return The populated graph.
  */
-void freeVertexMap() {
-    VertexMap *current, *tmp;
-    HASH_ITER(hh, vertex_map, current, tmp) {
-        HASH_DEL(vertex_map, current);
-        free(current);
+static Graph loadSequential(input_reader_t *reader, size_t expectedWallets, InputFormat *format) {
+    parse_wei_ctx_t *ctx = parse_wei_ctx_create();
+    address_map_t *map = address_map_create(expectedWallets);
+    if (!ctx || !map) {
+        fprintf(stderr, "Fatal error: unable to create the loader state.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    address_t from, to;
+    size_t lineNumber = 0;
+    int status;
+
+    uint256_t parsed_value;
+    uint64_t timestamp;
+
+    Graph graph = initGraph(0);
+    size_t addressCapacity = 0;
+
+    while ((status = nextTransaction(reader, format, ctx, &lineNumber, &from, &to, &parsed_value, &timestamp)) > 0) {
+        if (status == 2) graph->hasTimestamps = true;
+
+        size_t from_index = internVertex(map, &from);
+        size_t to_index = internVertex(map, &to);
+        if (map->count > addressCapacity) {
+            addressCapacity = addressCapacity ? addressCapacity * 2 : 1024;
+            graph->addresses = realloc(graph->addresses, addressCapacity * sizeof(address_t));
+            if (!graph->addresses) {
+                fprintf(stderr, "Fatal: could not grow the address table.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        graph->addresses[from_index] = from;
+        graph->addresses[to_index] = to;
+        reserveVertices(graph, map->count);
+
+        insertEdge(graph, from_index, to_index, &parsed_value, timestamp);
+    }
+
+    if (status < 0) {
+        perror("Warning: error reading input, graph may be incomplete");
     }
+
+    address_map_free(map);
+    parse_wei_ctx_free(ctx);
+    return graph;
 }
 
-// --- GRAPH LOADER FUNCTIONS ---
+/**
+ * @brief Finds or adds a wallet in the sharded address map.
+ *
+ * Final indices are not assigned here. Instead each wallet remembers the smallest
+ * input offset it was seen at, so the final numbering can reproduce the order of
+ * a sequential load regardless of how the threads interleaved.
+ *
+ * @param shards The sharded address map.
+ * @param key The binary wallet address.
+ * @param offset The byte offset of this occurrence in the input.
+ * @return The provisional id of the wallet.
+ */
+static uint64_t internShared(VertexShard *shards, const address_t *key, size_t offset) {
+    uint32_t shardIndex = address_hash(key->bytes) >> (32 - LOAD_SHARD_BITS);
+    VertexShard *shard = &shards[shardIndex];
+
+    pthread_mutex_lock(&shard->lock);
+    int inserted;
+    uint32_t index = address_map_intern(shard->map, key, &inserted);
+    if (index == ADDRESS_MAP_EMPTY) {
+        fprintf(stderr, "Fatal: could not grow the address map.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (inserted) {
+        if (index == shard->firstSeenCapacity) {
+            size_t capacity = shard->firstSeenCapacity ? shard->firstSeenCapacity * 2 : 1024;
+            size_t *firstSeen = realloc(shard->firstSeen, capacity * sizeof(size_t));
+            if (!firstSeen) {
+                fprintf(stderr, "Fatal: could not grow the first-seen table.\n");
+                exit(EXIT_FAILURE);
+            }
+            shard->firstSeen = firstSeen;
+            shard->firstSeenCapacity = capacity;
+        }
+        shard->firstSeen[index] = offset;
+    } else if (offset < shard->firstSeen[index]) {
+        shard->firstSeen[index] = offset;
+    }
+    pthread_mutex_unlock(&shard->lock);
+    return ((uint64_t)shardIndex << 32) | index;
+}
 
 /**
- * @brief Reads transaction data from a file and populates the graph with edges.
- * @param file The input file, rewound to the beginning.
- * @param G The graph to populate.
- * @param totalTransactions The number of lines/transactions to read.
- * @param ctx The context for the wei parser.
- * @return The populated graph G.
+ * @brief Thread entry point: parses one chunk into the worker's local edge buffer.
+ * @param arg The LoadWorker of this thread.
+ * @return NULL.
  */
-static Graph hashToGraph(FILE *file, Graph G, size_t totalTransactions, parse_wei_ctx_t *ctx) {
-    char from_ad[43], to_ad[43], value_str[100];
-    size_t from_index, to_index;
+static void *loadChunk(void *arg) {
+    LoadWorker *worker = arg;
+    parse_wei_ctx_t *ctx = parse_wei_ctx_create();
+    if (!ctx) {
+        fprintf(stderr, "Fatal error: unable to create wei_parser context.\n");
+        exit(EXIT_FAILURE);
+    }
 
-    mpz_t parsed_value;
-    mpz_init(parsed_value);
+    input_token_t line, tokens[4];
+    address_t from, to;
+    while (input_reader_next_line(worker->reader, &line) == 1) {
+        if (worker->edgeCount == worker->edgeCapacity) {
+            size_t capacity = worker->edgeCapacity ? worker->edgeCapacity * 2 : 4096;
+            PendingEdge *edges = realloc(worker->edges, capacity * sizeof(PendingEdge));
+            if (!edges) {
+                fprintf(stderr, "Fatal: could not grow the edge buffer.\n");
+                exit(EXIT_FAILURE);
+            }
+            worker->edges = edges;
+            worker->edgeCapacity = capacity;
+        }
 
-    for (size_t i = 0; i < totalTransactions; i++) {
-        if (fscanf(file, "%42s %42s %99s", from_ad, to_ad, value_str) != 3) {
-            fprintf(stderr, "Warning: Malformed line at transaction %zu. Skipping.\n", i);
+        PendingEdge *edge = &worker->edges[worker->edgeCount];
+        int parsed = worker->format->csv ? parseCsvTransaction(line, worker->format, tokens, &from, &to, ctx,
+                                                               &edge->value, &edge->timestamp)
+                                         : parseTransaction(line, tokens, &from, &to, ctx, &edge->value,
+                                                            &edge->timestamp);
+        if (parsed == 3) {
+            worker->filtered++;
             continue;
         }
+        size_t offset = (size_t)(line.ptr - worker->base);
+        if (parsed == -1) {
+            fprintf(stderr, "Warning: Malformed line at byte offset %zu. Skipping.\n", offset);
+        } else if (parsed == -2) {
+            fprintf(stderr, "Warning: Failure parsing the value '%.*s' at byte offset %zu. Skipping transaction.\n",
+                    (int)tokens[2].len, tokens[2].ptr, offset);
+        } else if (parsed == -3) {
+            fprintf(stderr, "Warning: Value '%.*s' at byte offset %zu exceeds 256 bits. Skipping transaction.\n",
+                    (int)tokens[2].len, tokens[2].ptr, offset);
+        } else if (parsed == -4) {
+            fprintf(stderr, "Warning: Failure parsing the timestamp '%.*s' at byte offset %zu. Skipping transaction.\n",
+                    (int)tokens[3].len, tokens[3].ptr, offset);
+        }
+        if (parsed <= 0) continue;
+        if (parsed == 2) worker->hasTimestamps = true;
 
-        if (parse_wei_optimized(ctx, value_str, parsed_value) != 0) {
-            fprintf(stderr, "Warning: Failure parsing the value '%s'. Skipping transaction.\n", value_str);
-            continue;
+        edge->from = internShared(worker->shards, &from, (size_t)(tokens[0].ptr - worker->base));
+        edge->to = internShared(worker->shards, &to, (size_t)(tokens[1].ptr - worker->base));
+        worker->edgeCount++;
+    }
+
+    parse_wei_ctx_free(ctx);
+    return NULL;
+}
+
+/**
+ * @brief Orders wallets by their first occurrence in the input.
+ */
+static int compareFirstSeen(const void *a, const void *b) {
+    const FirstSeenEntry *x = a;
+    const FirstSeenEntry *y = b;
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+/**
+ * @brief Maps a provisional id to the final vertex index.
+ */
+static inline size_t finalIndex(const VertexShard *shards, uint64_t id) {
+    return shards[id >> 32].finalIndex[(uint32_t)id];
+}
+
+/**
+ * @brief Loads the graph from a memory-mapped input using several threads.
+ *
+ * The input is cut into newline-aligned chunks, one per thread. Each thread
+ * parses its chunk with its own Wei parser context into a local edge buffer,
+ * interning wallets into an address map split in lock-protected shards.
+ * Afterwards wallets are numbered by first occurrence and the buffers are
+ * merged into the graph in chunk order, so the result is identical to
+ * loadSequential().
+ *
+ * @param data The mapped input.
+ * @param size The size of the input in bytes.
+ * @param threads The number of loader threads.
+ * @param expectedWallets Estimated number of wallets, used to pre-size the address maps.
+ * @param format The layout of the lines; a CSV header is skipped and filtered rows are counted.
+ * @return The populated graph.
+ */
+static Graph loadParallel(const char *data, size_t size, size_t threads, size_t expectedWallets,
+                          InputFormat *format) {
+    VertexShard *shards = calloc(LOAD_SHARDS, sizeof(VertexShard));
+    LoadWorker *workers = calloc(threads, sizeof(LoadWorker));
+    pthread_t *tids = malloc(threads * sizeof(pthread_t));
+    if (!shards || !workers || !tids) {
+        fprintf(stderr, "Fatal: could not allocate loader threads.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t s = 0; s < LOAD_SHARDS; s++) {
+        pthread_mutex_init(&shards[s].lock, NULL);
+        shards[s].map = address_map_create(expectedWallets / LOAD_SHARDS);
+        if (!shards[s].map) {
+            fprintf(stderr, "Fatal: could not allocate the address map.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    const char *end = data + size;
+    const char *chunkStart = data + format->header;
+    for (size_t t = 0; t < threads; t++) {
+        const char *chunkEnd = data + size / threads * (t + 1);
+        if (t == threads - 1 || chunkEnd < chunkStart) chunkEnd = end;
+        if (chunkEnd < end) {
+            const char *nl = memchr(chunkEnd, '\n', (size_t)(end - chunkEnd));
+            chunkEnd = nl ? nl + 1 : end;
         }
 
-        from_index = getVertexIndex(from_ad);
-        to_index = getVertexIndex(to_ad);
+        workers[t].reader = input_reader_slice(chunkStart, chunkEnd);
+        workers[t].base = data;
+        workers[t].shards = shards;
+        workers[t].format = format;
+        if (!workers[t].reader) {
+            fprintf(stderr, "Fatal error: unable to create input reader.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (pthread_create(&tids[t], NULL, loadChunk, &workers[t]) != 0) {
+            fprintf(stderr, "Fatal: could not start loader thread.\n");
+            exit(EXIT_FAILURE);
+        }
+        chunkStart = chunkEnd;
+    }
+    for (size_t t = 0; t < threads; t++) {
+        pthread_join(tids[t], NULL);
+        input_reader_close(workers[t].reader);
+    }
 
-        insertEdge(G, from_index, to_index, parsed_value);
+    // Number wallets by first occurrence.
+    size_t vertexCount = 0;
+    for (size_t s = 0; s < LOAD_SHARDS; s++) {
+        vertexCount += shards[s].map->count;
     }
-    mpz_clear(parsed_value);
-    return G;
+    FirstSeenEntry *order = malloc((vertexCount ? vertexCount : 1) * sizeof(FirstSeenEntry));
+    if (!order) {
+        fprintf(stderr, "Fatal: could not allocate the vertex order.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t n = 0;
+    for (size_t s = 0; s < LOAD_SHARDS; s++) {
+        for (size_t i = 0; i < shards[s].map->count; i++) {
+            order[n].offset = shards[s].firstSeen[i];
+            order[n].id = ((uint64_t)s << 32) | i;
+            n++;
+        }
+        shards[s].finalIndex = malloc((shards[s].map->count ? shards[s].map->count : 1) * sizeof(uint32_t));
+        if (!shards[s].finalIndex) {
+            fprintf(stderr, "Fatal: could not allocate the vertex order.\n");
+            exit(EXIT_FAILURE);
+        }
+        free(shards[s].firstSeen);
+        pthread_mutex_destroy(&shards[s].lock);
+    }
+    qsort(order, vertexCount, sizeof(FirstSeenEntry), compareFirstSeen);
+    for (size_t i = 0; i < vertexCount; i++) {
+        shards[order[i].id >> 32].finalIndex[(uint32_t)order[i].id] = (uint32_t)i;
+    }
+    free(order);
+
+    Graph graph = initGraph(vertexCount);
+    graph->addresses = malloc((vertexCount ? vertexCount : 1) * sizeof(address_t));
+    if (!graph->addresses) {
+        fprintf(stderr, "Fatal: could not allocate the address table.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t s = 0; s < LOAD_SHARDS; s++) {
+        const address_map_t *map = shards[s].map;
+        for (size_t i = 0; i < map->capacity; i++) {
+            if (map->slots[i].index == ADDRESS_MAP_EMPTY) continue;
+            graph->addresses[shards[s].finalIndex[map->slots[i].index]] = map->slots[i].key;
+        }
+        address_map_free(shards[s].map);
+    }
+    for (size_t t = 0; t < threads; t++) {
+        for (size_t i = 0; i < workers[t].edgeCount; i++) {
+            PendingEdge *edge = &workers[t].edges[i];
+            insertEdge(graph, finalIndex(shards, edge->from), finalIndex(shards, edge->to), &edge->value,
+                       edge->timestamp);
+        }
+        if (workers[t].hasTimestamps) graph->hasTimestamps = true;
+        format->filtered += workers[t].filtered;
+        free(workers[t].edges);
+    }
+
+    for (size_t s = 0; s < LOAD_SHARDS; s++) {
+        free(shards[s].finalIndex);
+    }
+    free(tids);
+    free(workers);
+    free(shards);
+    return graph;
+}
+
+/**
+ * @brief Logs the input format when it is not the default text one.
+ * @param format The format detected while loading.
+ * @param logger The logging function.
+ */
+static void logInputFormat(const InputFormat *format, log_function_t logger) {
+    if (!format->csv) return;
+    logger("Input format: ethereum-etl CSV%s\n", format->block == CSV_NO_COLUMN ? "" : " (block_number as timestamp)");
+    logger("Rows filtered (zero value, self-transfer or contract creation): %zu\n", format->filtered);
 }
 
 /**
  * @brief Loads a graph from a file.
+ *
+ * Memory-mapped inputs large enough to be worth it are parsed by several
+ * threads (see loadParallel); pipes and small files are read in a single
+ * sequential pass. Tokens are slices of the input and are never copied before
+ * reaching the address map and the Wei parser. When the input size is known,
+ * the address map is pre-sized from it.
+ *
  * @param file A pointer to the opened input file.
+ * @param threads The number of loader threads to use.
  * @param logger The logging function to use for progress messages.
  * @return An initialized and populated graph.
  */
-Graph loadGraph(FILE *file, log_function_t logger) {
-    parse_wei_ctx_t *ctx = parse_wei_ctx_create();
-    if (!ctx) {
-        fprintf(stderr, "Fatal error: unable to create wei_parser context.\n");
+Graph loadGraph(FILE *file, size_t threads, log_function_t logger) {
+    input_reader_t *reader = input_reader_open(fileno(file));
+    if (!reader) {
+        fprintf(stderr, "Fatal error: unable to create input reader.\n");
         exit(EXIT_FAILURE);
     }
 
-    logger("Processing vertices...\n");
-    clock_t start = clock();
-    size_t vertexCount = addAllVertexToHashmap(file);
-    clock_t end = clock();
-    double time_taken = (double)(end - start) / CLOCKS_PER_SEC;
+    size_t size;
+    const char *data = input_reader_data(reader, &size);
+    if (threads > 1 && size / threads < PARALLEL_LOAD_MIN_CHUNK) {
+        threads = size / PARALLEL_LOAD_MIN_CHUNK;
+    }
+    size_t expectedWallets = size / BYTES_PER_WALLET_ESTIMATE;
 
-    logger("Runtime to fill hashtable: %lf seconds\n", time_taken);
-    logger("Total unique wallets (vertices): %zu\n", vertexCount);
+    logger("Building graph...\n");
+    logger("Parsing kernels: %s\n", simd_parse_isa());
+    double start = wallSeconds();
+    InputFormat format = {0};
+    Graph graph;
+    if (data && threads > 1) {
+        const char *nl = memchr(data, '\n', size);
+        input_token_t first = {data, nl ? (size_t)(nl - data) : size};
+        if (first.len && first.ptr[first.len - 1] == '\r') first.len--;
+        if (parseCsvHeader(first, &format) == 0) format.header = nl ? (size_t)(nl + 1 - data) : size;
+        logger("Loading with %zu threads\n", threads);
+        graph = loadParallel(data, size, threads, expectedWallets, &format);
+    } else {
+        graph = loadSequential(reader, expectedWallets, &format);
+    }
+    double time_taken = wallSeconds() - start;
+    logInputFormat(&format, logger);
 
-    rewind(file);
-    Graph graph = initGraph(vertexCount);
+    start = wallSeconds();
+    buildCSR(graph);
+    logger("Runtime to load graph: %lf seconds\n", time_taken);
+    logger("Runtime to build CSR: %lf seconds\n", wallSeconds() - start);
+    logger("Total unique wallets (vertices): %zu\n", graph->vertexAmount);
+    logger("Total transactions (edges): %zu\n", graph->edgesAmount);
 
-    logger("Building graph...\n");
-    start = clock();
-    graph = hashToGraph(file, graph, graph->vertexAmount, ctx);
-    end = clock();
-    time_taken = (double)(end - start) / CLOCKS_PER_SEC;
-    printf("Runtime to create graph: %lf seconds\n", time_taken);
+    input_reader_close(reader);
+    return graph;
+}
+
+/**
+ * @brief Finds a wallet in the graph or in its delta, adding it to the delta if it is new.
+ * @param G The graph.
+ * @param delta The delta, with its address map.
+ * @param key The binary wallet address.
+ * @return The id of the wallet.
+ */
+static vertex internDeltaVertex(Graph G, GraphDelta *delta, const address_t *key) {
+    uint32_t index = address_index_find(delta->index, delta->indexCapacity, G->addresses, key);
+    if (index != ADDRESS_MAP_EMPTY) return (vertex)index;
+
+    int inserted;
+    index = address_map_intern(delta->map, key, &inserted);
+    if (index == ADDRESS_MAP_EMPTY) {
+        fprintf(stderr, "Fatal: could not grow the address map.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (inserted) {
+        if (delta->vertexAmount == delta->vertexCapacity) {
+            size_t capacity = delta->vertexCapacity ? delta->vertexCapacity * 2 : 1024;
+            address_t *addresses = realloc(delta->addresses, capacity * sizeof(address_t));
+            if (!addresses) {
+                fprintf(stderr, "Fatal: could not grow the address table.\n");
+                exit(EXIT_FAILURE);
+            }
+            delta->addresses = addresses;
+            delta->vertexCapacity = capacity;
+        }
+        delta->addresses[delta->vertexAmount++] = *key;
+    }
+    return (vertex)(G->vertexAmount + index);
+}
+
+/**
+ * @brief Appends an edge to a delta.
+ * @param delta The delta.
+ * @param timed Keep the timestamp: the graph has them.
+ * @param from The source vertex.
+ * @param to The destination vertex.
+ * @param value The value of the transaction.
+ * @param timestamp The block number or timestamp of the transaction.
+ */
+static void appendDeltaEdge(GraphDelta *delta, bool timed, vertex from, vertex to, const uint256_t *value,
+                            uint64_t timestamp) {
+    if (delta->edgesAmount == delta->edgeCapacity) {
+        size_t capacity = delta->edgeCapacity ? delta->edgeCapacity * 2 : GRAPH_INITIAL_EDGE_CAPACITY;
+        vertex *sources = realloc(delta->sources, capacity * sizeof(vertex));
+        if (sources) delta->sources = sources;
+        vertex *destinations = realloc(delta->destinations, capacity * sizeof(vertex));
+        if (destinations) delta->destinations = destinations;
+        uint256_t *values = realloc(delta->values, capacity * sizeof(uint256_t));
+        if (values) delta->values = values;
+        uint64_t *timestamps = timed ? realloc(delta->timestamps, capacity * sizeof(uint64_t)) : NULL;
+        if (timestamps) delta->timestamps = timestamps;
+        if (!sources || !destinations || !values || (timed && !timestamps)) {
+            fprintf(stderr, "Fatal: could not grow the appended edges.\n");
+            exit(EXIT_FAILURE);
+        }
+        delta->edgeCapacity = capacity;
+    }
+    size_t e = delta->edgesAmount++;
+    delta->sources[e] = from;
+    delta->destinations[e] = to;
+    delta->values[e] = *value;
+    if (timed) delta->timestamps[e] = timestamp;
+}
+
+/**
+ * @brief Appends the transactions of a file to the delta of a built graph.
+ *
+ * The input is read sequentially: a batch is small next to the graph it is
+ * appended to, and its wallets are looked up in the address index of the
+ * graph rather than interned into a map of every wallet.
+ *
+ * @param G The graph, with its CSR and addresses.
+ * @param delta The delta; needs the address index of the graph.
+ * @param file The opened input file.
+ * @param logger The logging function to use.
+ * @return The number of transactions appended.
+ */
+size_t loadGraphDelta(Graph G, GraphDelta *delta, FILE *file, log_function_t logger) {
+    if (!G->addresses || !delta->index) {
+        fprintf(stderr, "Error: appending needs the address table of the graph.\n");
+        return 0;
+    }
+    input_reader_t *reader = input_reader_open(fileno(file));
+    parse_wei_ctx_t *ctx = parse_wei_ctx_create();
+    if (!reader || !ctx) {
+        fprintf(stderr, "Fatal error: unable to create the loader state.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!delta->map) {
+        delta->map = address_map_create(delta->vertexAmount);
+        if (!delta->map) {
+            fprintf(stderr, "Fatal error: unable to create the loader state.\n");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < delta->vertexAmount; i++) {
+            if (address_map_intern(delta->map, &delta->addresses[i], NULL) == ADDRESS_MAP_EMPTY) {
+                fprintf(stderr, "Fatal: could not grow the address map.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    logger("Appending transactions...\n");
+    double start = wallSeconds();
+    InputFormat format = {0};
+    bool timed = G->timestamps != NULL;
+    size_t firstVertex = delta->vertexAmount, firstEdge = delta->edgesAmount;
+    size_t lineNumber = 0;
+    address_t from, to;
+    uint256_t value;
+    uint64_t timestamp;
+    int status;
+    while ((status = nextTransaction(reader, &format, ctx, &lineNumber, &from, &to, &value, &timestamp)) > 0) {
+        vertex v = internDeltaVertex(G, delta, &from);
+        vertex w = internDeltaVertex(G, delta, &to);
+        appendDeltaEdge(delta, timed, v, w, &value, timestamp);
+    }
+    if (status < 0) {
+        perror("Warning: error reading input, graph may be incomplete");
+    }
+
+    logInputFormat(&format, logger);
+    logger("Runtime to append transactions: %lf seconds\n", wallSeconds() - start);
+    logger("New wallets: %zu\n", delta->vertexAmount - firstVertex);
+    logger("Appended transactions: %zu\n", delta->edgesAmount - firstEdge);
 
     parse_wei_ctx_free(ctx);
-    return graph;
+    input_reader_close(reader);
+    return delta->edgesAmount - firstEdge;
 }
 
 // --- GRAPH MANIPULATION FUNCTIONS ---
 
 /**
- * @brief Initializes a graph with V vertices.
+ * @brief Initializes a graph with V vertices, in build mode.
  * @param V The number of vertices.
  * @return A pointer to the newly allocated graph.
  */
@@ -179,153 +942,1426 @@ Graph initGraph(size_t V) {
     }
     G->vertexAmount = V;
     G->edgesAmount = 0;
-    G->adjList = malloc(V * sizeof(Transaction *));
+    G->pendingCapacity = GRAPH_INITIAL_EDGE_CAPACITY;
+    G->pending = malloc(G->pendingCapacity * sizeof(Transaction));
+    G->offsets = NULL;
+    G->destinations = NULL;
+    G->values = NULL;
+    G->timestamps = NULL;
+    G->hasTimestamps = false;
+    G->edgeCounts = NULL;
+    G->valueSums = NULL;
+    G->valueMins = NULL;
+    G->addresses = NULL;
+    G->inOffsets = NULL;
+    G->inSources = NULL;
+    G->mapping = NULL;
+    G->mappingSize = 0;
+    G->globalIds = NULL;
+    G->freshEdges = NULL;
 
-    if (!G->adjList) {
-        fprintf(stderr, "Error: Could not allocate memory for the adjacency list.\n");
+    if (!G->pending) {
+        fprintf(stderr, "Error: Could not allocate memory for the edge buffer.\n");
         free(G);
         exit(EXIT_FAILURE);
     }
-
-    for (size_t i = 0; i < V; i++) {
-        G->adjList[i] = NULL;
-    }
     return G;
 }
 
 /**
- * @brief Inserts a directed edge v->w into the graph.
+ * @brief Grows the graph so that it holds at least V vertices.
+ *
+ * In build mode vertices are only a count; their adjacency is laid out by
+ * buildCSR(), so growing the vertex table is O(1).
+ *
+ * @param G The graph.
+ * @param V The required number of vertices.
+ */
+static void reserveVertices(Graph G, size_t V) {
+    if (V > G->vertexAmount) G->vertexAmount = V;
+}
+
+/**
+ * @brief Appends a directed edge v->w to the edge buffer of a graph in build mode.
  * @param G The graph.
  * @param v The source vertex.
  * @param w The destination vertex.
  * @param value The value of the transaction.
+ * @param timestamp The block number or timestamp of the transaction.
  * @return 1 on success, 0 on failure.
  */
-int insertEdge(Graph G, vertex v, vertex w, const mpz_t value) {
+int insertEdge(Graph G, vertex v, vertex w, const uint256_t *value, uint64_t timestamp) {
     if (v < 0 || (size_t)v >= G->vertexAmount || w < 0 || (size_t)w >= G->vertexAmount) return 0;
+    if (!G->pending) return 0; // Already built: the CSR arrays are immutable.
 
-    Transaction *newNode = malloc(sizeof(Transaction));
-    if (!newNode) {
-        fprintf(stderr, "Error: Could not allocate memory for new transaction node.\n");
-        return 0;
+    if (G->edgesAmount == G->pendingCapacity) {
+        size_t capacity = G->pendingCapacity * 2;
+        Transaction *pending = realloc(G->pending, capacity * sizeof(Transaction));
+        if (!pending) {
+            fprintf(stderr, "Error: Could not grow the edge buffer.\n");
+            return 0;
+        }
+        G->pending = pending;
+        G->pendingCapacity = capacity;
     }
 
-    newNode->destination = w;
-    mpz_init_set(newNode->transactionValue, value);
-    newNode->next = G->adjList[v];
-    G->adjList[v] = newNode;
-    G->edgesAmount++;
+    Transaction *edge = &G->pending[G->edgesAmount++];
+    edge->source = v;
+    edge->destination = w;
+    edge->transactionValue = *value;
+    edge->timestamp = timestamp;
     return 1;
 }
 
 /**
- * @brief Frees all memory associated with the graph.
- * @param G The graph to be freed.
+ * @struct TimedSlot
+ * @brief Sort record used to order the out-edges of a vertex by timestamp.
  */
-void freeGraph(Graph G) {
-    if (!G) return;
-    for (size_t i = 0; i < G->vertexAmount; i++) {
-        Transaction *curr = G->adjList[i];
-        while (curr) {
-            Transaction *temp = curr;
-            curr = curr->next;
-            mpz_clear(temp->transactionValue);
-            free(temp);
-        }
-    }
-    free(G->adjList);
-    free(G);
+typedef struct {
+    uint64_t timestamp;          /**< The timestamp of the edge. */
+    size_t slot;                 /**< The CSR slot of the edge; breaks ties, so the sort is stable. */
+} TimedSlot;
+
+/**
+ * @brief Orders edges by timestamp, then by CSR slot.
+ */
+static int compareTimedSlots(const void *a, const void *b) {
+    const TimedSlot *x = a;
+    const TimedSlot *y = b;
+    if (x->timestamp != y->timestamp) return (x->timestamp > y->timestamp) - (x->timestamp < y->timestamp);
+    return (x->slot > y->slot) - (x->slot < y->slot);
 }
 
 /**
- * @brief Displays the graph's adjacency list representation to stdout.
- * @param G The graph to display.
+ * @brief Applies the order of a sorted range of edges to one per-edge array.
+ * @param array The array, or NULL.
+ * @param size The size of an element.
+ * @param first The first slot of the range.
+ * @param order The slots of the range, in their new order.
+ * @param degree The number of slots in the range.
+ * @param scratch Room for degree elements.
  */
-void showGraph(Graph G) {
-    printf("\n/--- GRAPH ADJACENCY LIST ---/\n");
+static void permuteEdges(void *array, size_t size, size_t first, const TimedSlot *order, size_t degree,
+                         void *scratch) {
+    if (!array) return;
+    char *base = array;
+    char *tmp = scratch;
+    for (size_t i = 0; i < degree; i++) memcpy(tmp + i * size, base + order[i].slot * size, size);
+    memcpy(base + first * size, tmp, degree * size);
+}
+
+/**
+ * @brief Stably sorts the out-edges of every vertex by timestamp.
+ *
+ * Inputs are usually in block order already, so each range is checked first
+ * and only the unsorted ones are sorted. Every per-edge array present moves
+ * along: the aggregates and the fresh marks of a graph put together from a
+ * delta as well as the values.
+ *
+ * @param G The graph, with its CSR and timestamps laid out.
+ */
+static void sortEdgesByTime(Graph G) {
+    size_t maxDegree = 0;
     for (size_t v = 0; v < G->vertexAmount; v++) {
-        printf("%zu: ", v);
-        Transaction *curr = G->adjList[v];
-        while (curr) {
-            gmp_printf("%d (Value: %Zd) -> ", curr->destination, curr->transactionValue);
-            curr = curr->next;
+        size_t degree = G->offsets[v + 1] - G->offsets[v];
+        if (degree > maxDegree) maxDegree = degree;
+    }
+    TimedSlot *order = NULL;
+    void *scratch = NULL;
+
+    for (size_t v = 0; v < G->vertexAmount; v++) {
+        size_t first = G->offsets[v], degree = G->offsets[v + 1] - first;
+        size_t e = first + 1;
+        while (e < first + degree && G->timestamps[e - 1] <= G->timestamps[e]) e++;
+        if (degree < 2 || e == first + degree) continue;
+
+        if (!order) {
+            order = malloc(maxDegree * sizeof(TimedSlot));
+            scratch = malloc(maxDegree * sizeof(uint256_t));
+            if (!order || !scratch) {
+                fprintf(stderr, "Error: Could not allocate memory for sorting edges by time.\n");
+                exit(EXIT_FAILURE);
+            }
         }
-        printf("NULL\n");
+        for (size_t i = 0; i < degree; i++) order[i] = (TimedSlot){G->timestamps[first + i], first + i};
+        qsort(order, degree, sizeof(TimedSlot), compareTimedSlots);
+        permuteEdges(G->destinations, sizeof(vertex), first, order, degree, scratch);
+        permuteEdges(G->values, sizeof(uint256_t), first, order, degree, scratch);
+        permuteEdges(G->edgeCounts, sizeof(uint32_t), first, order, degree, scratch);
+        permuteEdges(G->valueSums, sizeof(uint256_t), first, order, degree, scratch);
+        permuteEdges(G->valueMins, sizeof(uint256_t), first, order, degree, scratch);
+        permuteEdges(G->freshEdges, sizeof(unsigned char), first, order, degree, scratch);
+        for (size_t i = 0; i < degree; i++) G->timestamps[first + i] = order[i].timestamp;
     }
-    printf("/--------------------------/\n");
+    free(order);
+    free(scratch);
 }
 
-// --- CYCLE DETECTION (DFS) FUNCTIONS ---
-
 /**
- * @brief Recursive helper for DFS to find cycles.
- * @param G The graph.
- * @param visited Array to keep track of visited vertices.
- * @param recStack Array for the recursion stack to detect cycles.
- * @param path Array to store the current traversal path.
- * @param valuesPath Array to store the values of edges in the current path.
- * @param depth Current depth in the DFS traversal.
- * @param v The current vertex being visited.
- * @param p File pointer to write cycle information.
+ * @brief Converts the edge buffer into the immutable CSR arrays.
+ *
+ * A counting pass computes every vertex's out-degree, a prefix sum turns the
+ * degrees into offsets, and a placement pass moves each edge to its slot. Edges
+ * of the same vertex keep their insertion order, unless the graph has
+ * timestamps: they are then sorted by time.
+ *
+ * @param G The graph.
+ */
+void buildCSR(Graph G) {
+    if (!G->pending) return;
+
+    size_t V = G->vertexAmount, E = G->edgesAmount;
+    G->offsets = calloc(V + 1, sizeof(size_t));
+    G->destinations = malloc((E ? E : 1) * sizeof(vertex));
+    G->values = malloc((E ? E : 1) * sizeof(uint256_t));
+    size_t *cursor = malloc((V ? V : 1) * sizeof(size_t));
+    if (G->hasTimestamps) G->timestamps = malloc((E ? E : 1) * sizeof(uint64_t));
+    if (!G->offsets || !G->destinations || !G->values || !cursor || (G->hasTimestamps && !G->timestamps)) {
+        fprintf(stderr, "Error: Could not allocate memory for the CSR arrays.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t e = 0; e < E; e++) {
+        G->offsets[G->pending[e].source + 1]++;
+    }
+    for (size_t v = 0; v < V; v++) {
+        G->offsets[v + 1] += G->offsets[v];
+        cursor[v] = G->offsets[v];
+    }
+    for (size_t e = 0; e < E; e++) {
+        Transaction *edge = &G->pending[e];
+        size_t slot = cursor[edge->source]++;
+        G->destinations[slot] = edge->destination;
+        G->values[slot] = edge->transactionValue;
+        if (G->timestamps) G->timestamps[slot] = edge->timestamp;
+    }
+    if (G->timestamps) sortEdgesByTime(G);
+
+    free(cursor);
+    free(G->pending);
+    G->pending = NULL;
+    G->pendingCapacity = 0;
+}
+
+/**
+ * @brief Builds the reverse CSR from the forward one with the same counting pass.
+ * @param G The graph.
+ */
+void buildReverseCSR(Graph G) {
+    if (G->inOffsets || !G->offsets) return;
+
+    size_t V = G->vertexAmount, E = G->edgesAmount;
+    G->inOffsets = calloc(V + 1, sizeof(size_t));
+    G->inSources = malloc((E ? E : 1) * sizeof(vertex));
+    size_t *cursor = malloc((V ? V : 1) * sizeof(size_t));
+    if (!G->inOffsets || !G->inSources || !cursor) {
+        fprintf(stderr, "Error: Could not allocate memory for the reverse CSR arrays.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t e = 0; e < E; e++) {
+        G->inOffsets[G->destinations[e] + 1]++;
+    }
+    for (size_t v = 0; v < V; v++) {
+        G->inOffsets[v + 1] += G->inOffsets[v];
+        cursor[v] = G->inOffsets[v];
+    }
+    for (size_t v = 0; v < V; v++) {
+        for (size_t e = G->offsets[v]; e < G->offsets[v + 1]; e++) {
+            G->inSources[cursor[G->destinations[e]]++] = (vertex)v;
+        }
+    }
+    free(cursor);
+}
+
+/**
+ * @brief Returns a heap copy of an array that lives in a snapshot mapping.
+ * @param data The array, or NULL.
+ * @param size The size of the array in bytes.
+ * @return The copy, or NULL if data is NULL.
+ */
+static void *copyMapped(const void *data, size_t size) {
+    if (!data) return NULL;
+    void *copy = malloc(size ? size : 1);
+    if (!copy) {
+        fprintf(stderr, "Error: Could not allocate memory for the graph arrays.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, data, size);
+    return copy;
+}
+
+/**
+ * @brief Copies the arrays of a graph reopened from a snapshot into owned memory, so they can be rewritten.
+ * @param G The graph.
+ */
+static void ownGraphArrays(Graph G) {
+    if (!G->mapping) return;
+    size_t V = G->vertexAmount, E = G->edgesAmount;
+    G->offsets = copyMapped(G->offsets, (V + 1) * sizeof(size_t));
+    G->destinations = copyMapped(G->destinations, E * sizeof(vertex));
+    G->values = copyMapped(G->values, E * sizeof(uint256_t));
+    G->timestamps = copyMapped(G->timestamps, E * sizeof(uint64_t));
+    G->edgeCounts = copyMapped(G->edgeCounts, E * sizeof(uint32_t));
+    G->valueSums = copyMapped(G->valueSums, E * sizeof(uint256_t));
+    G->valueMins = copyMapped(G->valueMins, E * sizeof(uint256_t));
+    G->addresses = copyMapped(G->addresses, V * sizeof(address_t));
+    munmap(G->mapping, G->mappingSize);
+    G->mapping = NULL;
+    G->mappingSize = 0;
+}
+
+/**
+ * @brief Tells whether edge e repeats the edge kept in slot k: same destination, from the same source, at the same time.
+ * @param G The graph.
+ * @param keptSource Source of the edge kept last for each destination, or -1.
+ * @param keptSlot Slot of the edge kept last for each destination.
+ * @param v The source of e.
+ * @param e The edge.
+ * @return The slot to merge e into, or SIZE_MAX if e starts a new edge.
+ */
+static size_t parallelSlot(Graph G, const vertex *keptSource, const size_t *keptSlot, vertex v, size_t e) {
+    vertex w = G->destinations[e];
+    if (keptSource[w] != v) return SIZE_MAX;
+    size_t k = keptSlot[w];
+    if (G->timestamps && G->timestamps[k] != G->timestamps[e]) return SIZE_MAX;
+    return k;
+}
+
+/**
+ * @brief Merges the parallel edges of the graph into one edge each.
+ *
+ * A first pass counts the distinct edges; a second one compacts the CSR in
+ * place, the kept edge of a pair being found through a per-destination marker,
+ * so neither pass sorts anything and edges keep their order. If the graph is
+ * already collapsed, the aggregates of merged edges are combined.
+ *
+ * @param G The graph. Its CSR must be built.
+ * @return The number of edges removed.
+ */
+size_t collapseParallelEdges(Graph G) {
+    if (!G->offsets) return 0;
+    bool collapsed = G->edgeCounts != NULL;
+
+    size_t V = G->vertexAmount, E = G->edgesAmount;
+    vertex *keptSource = malloc((V ? V : 1) * sizeof(vertex));
+    size_t *keptSlot = malloc((V ? V : 1) * sizeof(size_t));
+    if (!keptSource || !keptSlot) {
+        fprintf(stderr, "Error: Could not allocate memory for collapsing parallel edges.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Pass 1: count the distinct edges. keptSlot holds original slots here.
+    for (size_t v = 0; v < V; v++) keptSource[v] = -1;
+    size_t kept = 0;
+    for (size_t v = 0; v < V; v++) {
+        for (size_t e = G->offsets[v]; e < G->offsets[v + 1]; e++) {
+            if (parallelSlot(G, keptSource, keptSlot, (vertex)v, e) != SIZE_MAX) continue;
+            keptSource[G->destinations[e]] = (vertex)v;
+            keptSlot[G->destinations[e]] = e;
+            kept++;
+        }
+    }
+
+    if (collapsed && kept == E) {
+        free(keptSource);
+        free(keptSlot);
+        return 0;
+    }
+    ownGraphArrays(G); // Compacted in place.
+    if (!collapsed) {
+        G->edgeCounts = malloc((kept ? kept : 1) * sizeof(uint32_t));
+        G->valueSums = malloc((kept ? kept : 1) * sizeof(uint256_t));
+        G->valueMins = malloc((kept ? kept : 1) * sizeof(uint256_t));
+        if (!G->edgeCounts || !G->valueSums || !G->valueMins) {
+            fprintf(stderr, "Error: Could not allocate memory for the edge aggregates.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Pass 2: compact. A kept edge never moves past the edges still to be read.
+    for (size_t v = 0; v < V; v++) keptSource[v] = -1;
+    size_t next = 0;
+    for (size_t v = 0; v < V; v++) {
+        size_t first = G->offsets[v], last = G->offsets[v + 1];
+        G->offsets[v] = next;
+        for (size_t e = first; e < last; e++) {
+            size_t k = parallelSlot(G, keptSource, keptSlot, (vertex)v, e);
+            uint256_t value = G->values[e];
+            uint32_t count = collapsed ? G->edgeCounts[e] : 1;
+            uint256_t sum = collapsed ? G->valueSums[e] : value;
+            uint256_t min = collapsed ? G->valueMins[e] : value;
+            if (k == SIZE_MAX) {
+                k = next++;
+                G->destinations[k] = G->destinations[e];
+                if (G->timestamps) G->timestamps[k] = G->timestamps[e];
+                G->values[k] = value;
+                G->edgeCounts[k] = count;
+                G->valueSums[k] = sum;
+                G->valueMins[k] = min;
+                keptSource[G->destinations[k]] = (vertex)v;
+                keptSlot[G->destinations[k]] = k;
+                continue;
+            }
+            G->edgeCounts[k] = G->edgeCounts[k] > UINT32_MAX - count ? UINT32_MAX : G->edgeCounts[k] + count;
+            if (uint256_add(&G->valueSums[k], &G->valueSums[k], &sum)) {
+                memset(&G->valueSums[k], 0xFF, sizeof(uint256_t)); // Saturate
+            }
+            G->valueMins[k] = *uint256_min(&G->valueMins[k], &min);
+            G->values[k] = *uint256_max(&G->values[k], &value);
+        }
+    }
+    G->offsets[V] = next;
+    free(keptSource);
+    free(keptSlot);
+
+    // Give the unused tails back; shrinking in place cannot fail in practice, so failures are ignored.
+    vertex *destinations = realloc(G->destinations, (kept ? kept : 1) * sizeof(vertex));
+    if (destinations) G->destinations = destinations;
+    uint256_t *values = realloc(G->values, (kept ? kept : 1) * sizeof(uint256_t));
+    if (values) G->values = values;
+    if (G->timestamps) {
+        uint64_t *timestamps = realloc(G->timestamps, (kept ? kept : 1) * sizeof(uint64_t));
+        if (timestamps) G->timestamps = timestamps;
+    }
+    if (collapsed) {
+        uint32_t *edgeCounts = realloc(G->edgeCounts, (kept ? kept : 1) * sizeof(uint32_t));
+        if (edgeCounts) G->edgeCounts = edgeCounts;
+        uint256_t *valueSums = realloc(G->valueSums, (kept ? kept : 1) * sizeof(uint256_t));
+        if (valueSums) G->valueSums = valueSums;
+        uint256_t *valueMins = realloc(G->valueMins, (kept ? kept : 1) * sizeof(uint256_t));
+        if (valueMins) G->valueMins = valueMins;
+    }
+
+    free(G->inOffsets);
+    free(G->inSources);
+    G->inOffsets = NULL;
+    G->inSources = NULL;
+    G->edgesAmount = kept;
+    return E - kept;
+}
+
+/**
+ * @brief Returns the number of transactions an edge stands for.
+ * @param G The graph.
+ * @param e The CSR index of the edge.
+ * @return edgeCounts[e] if parallel edges were collapsed, 1 otherwise.
+ */
+size_t edgeMultiplicity(Graph G, size_t e) {
+    return G->edgeCounts ? G->edgeCounts[e] : 1;
+}
+
+/**
+ * @struct SourcedEdge
+ * @brief An appended edge keyed by its source, to find the appended out-edges of a vertex.
+ */
+typedef struct {
+    vertex source;               /**< The source of the edge. */
+    size_t edge;                 /**< Its index in the delta. */
+} SourcedEdge;
+
+/**
+ * @brief Orders appended edges by source, then by arrival.
+ */
+static int compareSourcedEdges(const void *a, const void *b) {
+    const SourcedEdge *x = a;
+    const SourcedEdge *y = b;
+    if (x->source != y->source) return (x->source > y->source) - (x->source < y->source);
+    return (x->edge > y->edge) - (x->edge < y->edge);
+}
+
+/**
+ * @brief Orders vertex ids.
+ */
+static int compareVertices(const void *a, const void *b) {
+    vertex x = *(const vertex *)a;
+    vertex y = *(const vertex *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sorts the edges of a delta by source, so the out-edges of a vertex are found by binary search.
+ * @param delta The delta.
+ * @return The edges, by source then by arrival.
+ */
+static SourcedEdge *deltaBySource(const GraphDelta *delta) {
+    SourcedEdge *order = malloc((delta->edgesAmount ? delta->edgesAmount : 1) * sizeof(SourcedEdge));
+    if (!order) {
+        fprintf(stderr, "Error: Could not allocate memory for the appended edges.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t e = 0; e < delta->edgesAmount; e++) order[e] = (SourcedEdge){delta->sources[e], e};
+    qsort(order, delta->edgesAmount, sizeof(SourcedEdge), compareSourcedEdges);
+    return order;
+}
+
+/**
+ * @struct EdgeCursor
+ * @brief Walks the out-edges of a vertex in the graph and then in a delta.
+ *
+ * Graph edges come first, in CSR order, then appended ones in arrival order:
+ * the order a full load of the same transactions lays them out in before
+ * sorting by time.
+ */
+typedef struct {
+    size_t edge;                 /**< The next CSR edge. */
+    size_t end;                  /**< The end of the CSR range. */
+    size_t next;                 /**< The next entry of bySource. */
+    size_t last;                 /**< The end of the vertex's entries in bySource. */
+    const SourcedEdge *bySource; /**< The appended edges by source. */
+} EdgeCursor;
+
+/**
+ * @brief Starts walking the out-edges of a vertex.
+ * @param G The graph.
+ * @param delta The delta.
+ * @param bySource The edges of the delta sorted by deltaBySource().
+ * @param v The vertex, of the graph or added by the delta.
+ * @return The cursor.
+ */
+static EdgeCursor outEdges(Graph G, const GraphDelta *delta, const SourcedEdge *bySource, vertex v) {
+    EdgeCursor cursor = {0, 0, 0, 0, bySource};
+    if ((size_t)v < G->vertexAmount) {
+        cursor.edge = G->offsets[v];
+        cursor.end = G->offsets[v + 1];
+    }
+    size_t lo = 0, hi = delta->edgesAmount;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (bySource[mid].source < v) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    cursor.next = cursor.last = lo;
+    while (cursor.last < delta->edgesAmount && bySource[cursor.last].source == v) cursor.last++;
+    return cursor;
+}
+
+/**
+ * @brief Steps to the next out-edge.
+ * @param cursor The cursor.
+ * @param e Receives the edge: a CSR index, or a delta index if appended.
+ * @param appended Receives whether the edge is in the delta.
+ * @return true if there was an edge left.
+ */
+static bool nextOutEdge(EdgeCursor *cursor, size_t *e, bool *appended) {
+    if (cursor->edge < cursor->end) {
+        *e = cursor->edge++;
+        *appended = false;
+        return true;
+    }
+    if (cursor->next < cursor->last) {
+        *e = cursor->bySource[cursor->next++].edge;
+        *appended = true;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @struct RegionSearch
+ * @brief A breadth-first search over the graph and a delta that only pays for what it visits.
+ *
+ * `position` is indexed by global id but only written for visited vertices;
+ * a large calloc is served with zero pages, so it costs nothing until then.
+ */
+typedef struct {
+    int *position;               /**< Per global vertex: its position in order + 1, or 0 if not visited. */
+    vertex *order;               /**< The visited vertices, in visit order. */
+    int *depth;                  /**< Depth of each visited vertex, by position. */
+    size_t count;                /**< The number of visited vertices. */
+    size_t capacity;             /**< The allocated size of order and depth. */
+} RegionSearch;
+
+/**
+ * @brief Marks a vertex as visited at a depth, unless it already is.
+ * @param search The search.
+ * @param v The vertex.
+ * @param depth Its depth.
+ */
+static void regionVisit(RegionSearch *search, vertex v, int depth) {
+    if (search->position[v]) return;
+    if (search->count == search->capacity) {
+        search->capacity = search->capacity ? search->capacity * 2 : 1024;
+        search->order = realloc(search->order, search->capacity * sizeof(vertex));
+        search->depth = realloc(search->depth, search->capacity * sizeof(int));
+        if (!search->order || !search->depth) {
+            fprintf(stderr, "Error: Could not allocate memory for the touched region.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    search->order[search->count] = v;
+    search->depth[search->count] = depth;
+    search->position[v] = (int)++search->count;
+}
+
+/**
+ * @brief Extracts the part of the graph where the fresh edges of a delta can close a cycle.
+ *
+ * A forward search from the fresh destinations collects Fwd; the edges inside
+ * Fwd are reversed into a small local CSR, and a backward search from the
+ * fresh sources over it collects Bwd. With a length bound, a vertex is only
+ * kept if its two depths add up to less than the bound, as on a cycle through
+ * a fresh edge. The region is then laid out as a CSR of its own.
+ *
+ * @param G The graph.
+ * @param delta The delta; its edges from savedEdges on are fresh.
+ * @param maxLength The longest cycle that will be searched, or 0 for no limit.
+ * @param logger The logging function to use.
+ * @return The region, built.
+ */
+Graph extractAppendedRegion(Graph G, const GraphDelta *delta, size_t maxLength, log_function_t logger) {
+    double start = wallSeconds();
+    size_t V = G->vertexAmount + delta->vertexAmount;
+    int maxDepth = maxLength > 0 && maxLength - 1 < (size_t)INT32_MAX ? (int)(maxLength - 1) : INT32_MAX;
+    SourcedEdge *bySource = deltaBySource(delta);
+    EdgeCursor cursor;
+    size_t e;
+    bool appended;
+
+    // Fwd(fresh destinations).
+    RegionSearch forward = {calloc(V ? V : 1, sizeof(int)), NULL, NULL, 0, 0};
+    if (!forward.position) {
+        fprintf(stderr, "Error: Could not allocate memory for the touched region.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t k = delta->savedEdges; k < delta->edgesAmount; k++) regionVisit(&forward, delta->destinations[k], 0);
+    for (size_t i = 0; i < forward.count; i++) {
+        int depth = forward.depth[i];
+        if (depth >= maxDepth) continue;
+        cursor = outEdges(G, delta, bySource, forward.order[i]);
+        while (nextOutEdge(&cursor, &e, &appended)) {
+            regionVisit(&forward, appended ? delta->destinations[e] : G->destinations[e], depth + 1);
+        }
+    }
+
+    // The edges inside Fwd, reversed, by position.
+    size_t F = forward.count;
+    size_t *inOffsets = calloc(F + 1, sizeof(size_t));
+    size_t *fill = malloc((F ? F : 1) * sizeof(size_t));
+    if (!inOffsets || !fill) {
+        fprintf(stderr, "Error: Could not allocate memory for the touched region.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < F; i++) {
+        cursor = outEdges(G, delta, bySource, forward.order[i]);
+        while (nextOutEdge(&cursor, &e, &appended)) {
+            int p = forward.position[appended ? delta->destinations[e] : G->destinations[e]];
+            if (p) inOffsets[p]++;
+        }
+    }
+    for (size_t i = 0; i < F; i++) {
+        inOffsets[i + 1] += inOffsets[i];
+        fill[i] = inOffsets[i];
+    }
+    size_t *inSources = malloc((inOffsets[F] ? inOffsets[F] : 1) * sizeof(size_t));
+    if (!inSources) {
+        fprintf(stderr, "Error: Could not allocate memory for the touched region.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < F; i++) {
+        cursor = outEdges(G, delta, bySource, forward.order[i]);
+        while (nextOutEdge(&cursor, &e, &appended)) {
+            int p = forward.position[appended ? delta->destinations[e] : G->destinations[e]];
+            if (p) inSources[fill[p - 1]++] = i;
+        }
+    }
+    free(fill);
+
+    // Bwd(fresh sources) inside Fwd, by position; -1 if not reached.
+    int *backward = malloc((F ? F : 1) * sizeof(int));
+    size_t *queue = malloc((F ? F : 1) * sizeof(size_t));
+    if (!backward || !queue) {
+        fprintf(stderr, "Error: Could not allocate memory for the touched region.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < F; i++) backward[i] = -1;
+    size_t head = 0, tail = 0;
+    for (size_t k = delta->savedEdges; k < delta->edgesAmount; k++) {
+        int p = forward.position[delta->sources[k]];
+        if (p && backward[p - 1] < 0) {
+            backward[p - 1] = 0;
+            queue[tail++] = (size_t)(p - 1);
+        }
+    }
+    while (head < tail) {
+        size_t i = queue[head++];
+        if (backward[i] >= maxDepth) continue;
+        for (size_t k = inOffsets[i]; k < inOffsets[i + 1]; k++) {
+            size_t j = inSources[k];
+            if (backward[j] < 0) {
+                backward[j] = backward[i] + 1;
+                queue[tail++] = j;
+            }
+        }
+    }
+    free(inOffsets);
+    free(inSources);
+    free(queue);
+
+    // The region, numbered in the order of the global ids; position now holds the local id + 1.
+    vertex *members = malloc((F ? F : 1) * sizeof(vertex));
+    if (!members) {
+        fprintf(stderr, "Error: Could not allocate memory for the touched region.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < F; i++) {
+        if (backward[i] >= 0 && (maxLength == 0 || (size_t)forward.depth[i] + (size_t)backward[i] < maxLength)) {
+            members[n++] = forward.order[i];
+        }
+        forward.position[forward.order[i]] = 0;
+    }
+    free(backward);
+    qsort(members, n, sizeof(vertex), compareVertices);
+    for (size_t i = 0; i < n; i++) forward.position[members[i]] = (int)i + 1;
+    const int *local = forward.position;
+
+    Graph R = initGraph(n);
+    free(R->pending); // Laid out directly.
+    R->pending = NULL;
+    R->pendingCapacity = 0;
+    R->offsets = calloc(n + 1, sizeof(size_t));
+    R->globalIds = members;
+    R->addresses = malloc((n ? n : 1) * sizeof(address_t));
+    if (!R->offsets || !R->addresses) {
+        fprintf(stderr, "Error: Could not allocate memory for the touched region.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = 0; i < n; i++) {
+        vertex g = members[i];
+        R->addresses[i] = (size_t)g < G->vertexAmount ? G->addresses[g] : delta->addresses[g - G->vertexAmount];
+        size_t degree = 0;
+        cursor = outEdges(G, delta, bySource, g);
+        while (nextOutEdge(&cursor, &e, &appended)) {
+            if (local[appended ? delta->destinations[e] : G->destinations[e]]) degree++;
+        }
+        R->offsets[i + 1] = R->offsets[i] + degree;
+    }
+
+    size_t E = R->offsets[n];
+    R->edgesAmount = E;
+    R->destinations = malloc((E ? E : 1) * sizeof(vertex));
+    R->values = malloc((E ? E : 1) * sizeof(uint256_t));
+    R->freshEdges = malloc(E ? E : 1);
+    if (G->timestamps) R->timestamps = malloc((E ? E : 1) * sizeof(uint64_t));
+    if (G->edgeCounts) {
+        R->edgeCounts = malloc((E ? E : 1) * sizeof(uint32_t));
+        R->valueSums = malloc((E ? E : 1) * sizeof(uint256_t));
+        R->valueMins = malloc((E ? E : 1) * sizeof(uint256_t));
+    }
+    if (!R->destinations || !R->values || !R->freshEdges || (G->timestamps && !R->timestamps)
+        || (G->edgeCounts && (!R->edgeCounts || !R->valueSums || !R->valueMins))) {
+        fprintf(stderr, "Error: Could not allocate memory for the touched region.\n");
+        exit(EXIT_FAILURE);
+    }
+    R->hasTimestamps = R->timestamps != NULL;
+    size_t slot = 0, fresh = 0;
+    for (size_t i = 0; i < n; i++) {
+        cursor = outEdges(G, delta, bySource, members[i]);
+        while (nextOutEdge(&cursor, &e, &appended)) {
+            int w = local[appended ? delta->destinations[e] : G->destinations[e]];
+            if (!w) continue;
+            R->destinations[slot] = w - 1;
+            R->values[slot] = appended ? delta->values[e] : G->values[e];
+            R->freshEdges[slot] = appended && e >= delta->savedEdges;
+            fresh += R->freshEdges[slot];
+            if (R->timestamps) R->timestamps[slot] = appended ? delta->timestamps[e] : G->timestamps[e];
+            if (R->edgeCounts) {
+                R->edgeCounts[slot] = appended ? 1 : G->edgeCounts[e];
+                R->valueSums[slot] = appended ? delta->values[e] : G->valueSums[e];
+                R->valueMins[slot] = appended ? delta->values[e] : G->valueMins[e];
+            }
+            slot++;
+        }
+    }
+    if (R->timestamps) sortEdgesByTime(R);
+
+    free(forward.position);
+    free(forward.order);
+    free(forward.depth);
+    free(bySource);
+
+    logger("Runtime to extract the touched region: %lf seconds\n", wallSeconds() - start);
+    logger("Touched region: %zu wallets, %zu transactions (%zu new)\n", n, E, fresh);
+    return R;
+}
+
+/**
+ * @brief Releases the arrays of a graph, mapped or owned, and the reverse CSR.
+ * @param G The graph; its array pointers are left dangling.
+ */
+static void freeGraphArrays(Graph G) {
+    free(G->inSources);
+    free(G->inOffsets);
+    G->inSources = NULL;
+    G->inOffsets = NULL;
+    if (G->mapping) {
+        munmap(G->mapping, G->mappingSize);
+        G->mapping = NULL;
+        G->mappingSize = 0;
+        return;
+    }
+    free(G->timestamps);
+    free(G->edgeCounts);
+    free(G->valueSums);
+    free(G->valueMins);
+    free(G->addresses);
+    free(G->values);
+    free(G->destinations);
+    free(G->offsets);
+}
+
+/**
+ * @brief Folds a delta into the CSR of the graph and empties it.
+ *
+ * Lays the CSR out again with the appended edges after the graph's own, in
+ * the order a full load would have read them, then sorts by time and
+ * collapses parallel edges if the graph was set up that way. O(V + E).
+ *
+ * @param G The graph.
+ * @param delta The delta.
+ */
+void mergeGraphDelta(Graph G, GraphDelta *delta) {
+    if (delta->edgesAmount == 0 && delta->vertexAmount == 0) {
+        freeGraphDelta(delta);
+        return;
+    }
+    size_t V0 = G->vertexAmount, V = V0 + delta->vertexAmount;
+    size_t E = G->edgesAmount + delta->edgesAmount;
+    SourcedEdge *bySource = deltaBySource(delta);
+
+    GraphDS merged = *G;
+    merged.vertexAmount = V;
+    merged.edgesAmount = E;
+    merged.offsets = malloc((V + 1) * sizeof(size_t));
+    merged.destinations = malloc((E ? E : 1) * sizeof(vertex));
+    merged.values = malloc((E ? E : 1) * sizeof(uint256_t));
+    merged.timestamps = G->timestamps ? malloc((E ? E : 1) * sizeof(uint64_t)) : NULL;
+    merged.edgeCounts = G->edgeCounts ? malloc((E ? E : 1) * sizeof(uint32_t)) : NULL;
+    merged.valueSums = G->edgeCounts ? malloc((E ? E : 1) * sizeof(uint256_t)) : NULL;
+    merged.valueMins = G->edgeCounts ? malloc((E ? E : 1) * sizeof(uint256_t)) : NULL;
+    merged.addresses = G->addresses ? malloc((V ? V : 1) * sizeof(address_t)) : NULL;
+    if (!merged.offsets || !merged.destinations || !merged.values || (G->timestamps && !merged.timestamps)
+        || (G->edgeCounts && (!merged.edgeCounts || !merged.valueSums || !merged.valueMins))
+        || (G->addresses && !merged.addresses)) {
+        fprintf(stderr, "Error: Could not allocate memory for the graph arrays.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t slot = 0;
+    for (size_t v = 0; v < V; v++) {
+        merged.offsets[v] = slot;
+        EdgeCursor cursor = outEdges(G, delta, bySource, (vertex)v);
+        size_t e;
+        bool appended;
+        while (nextOutEdge(&cursor, &e, &appended)) {
+            merged.destinations[slot] = appended ? delta->destinations[e] : G->destinations[e];
+            merged.values[slot] = appended ? delta->values[e] : G->values[e];
+            if (merged.timestamps) merged.timestamps[slot] = appended ? delta->timestamps[e] : G->timestamps[e];
+            if (merged.edgeCounts) {
+                merged.edgeCounts[slot] = appended ? 1 : G->edgeCounts[e];
+                merged.valueSums[slot] = appended ? delta->values[e] : G->valueSums[e];
+                merged.valueMins[slot] = appended ? delta->values[e] : G->valueMins[e];
+            }
+            slot++;
+        }
+    }
+    merged.offsets[V] = slot;
+    if (merged.addresses) {
+        memcpy(merged.addresses, G->addresses, V0 * sizeof(address_t));
+        memcpy(merged.addresses + V0, delta->addresses, delta->vertexAmount * sizeof(address_t));
+    }
+    free(bySource);
+
+    freeGraphArrays(G);
+    *G = merged;
+    G->mapping = NULL;
+    G->mappingSize = 0;
+    G->inOffsets = NULL;
+    G->inSources = NULL;
+    freeGraphDelta(delta);
+
+    if (G->timestamps) sortEdgesByTime(G);
+    if (G->edgeCounts) collapseParallelEdges(G);
+}
+
+/**
+ * @brief Frees the arrays of a delta, leaving it empty.
+ * @param delta The delta.
+ */
+void freeGraphDelta(GraphDelta *delta) {
+    free(delta->addresses);
+    address_map_free(delta->map);
+    free(delta->sources);
+    free(delta->destinations);
+    free(delta->values);
+    free(delta->timestamps);
+    memset(delta, 0, sizeof(*delta));
+}
+
+/**
+ * @brief Frees all memory associated with the graph.
+ * @param G The graph to be freed.
+ */
+void freeGraph(Graph G) {
+    if (!G) return;
+    freeGraphArrays(G);
+    free(G->pending);
+    free(G->globalIds);
+    free(G->freshEdges);
+    free(G);
+}
+
+/**
+ * @brief Displays the graph's adjacency list representation to stdout.
+ * @param G The graph to display. It must have been built with buildCSR().
+ */
+void showGraph(Graph G) {
+    char value[UINT256_DEC_SIZE];
+    printf("\n/--- GRAPH ADJACENCY LIST ---/\n");
+    for (size_t v = 0; v < G->vertexAmount; v++) {
+        printf("%zu: ", v);
+        for (size_t e = G->offsets[v]; e < G->offsets[v + 1]; e++) {
+            printf("%d (Value: %s", G->destinations[e], uint256_to_dec(&G->values[e], value));
+            if (G->edgeCounts) printf(", x%" PRIu32, G->edgeCounts[e]);
+            printf(") -> ");
+        }
+        printf("NULL\n");
+    }
+    printf("/--------------------------/\n");
+}
+
+// --- CYCLE DETECTION (DFS) FUNCTIONS ---
+
+/**
+ * @def CYCLE_BLOCK_SIZE
+ * @brief Bytes of cycle records a search thread gathers before it queues them to the writer.
+ */
+#define CYCLE_BLOCK_SIZE (64 * 1024)
+
+/**
+ * @def CYCLE_BLOCKS_QUEUED
+ * @brief Blocks that may wait for the writer, besides the one each search thread fills.
+ */
+#define CYCLE_BLOCKS_QUEUED 64
+
+/**
+ * @def CYCLE_TEXT_SIZE
+ * @brief Bytes of formatted output the writer gathers before it writes them.
+ */
+#define CYCLE_TEXT_SIZE (1024 * 1024)
+
+/**
+ * @brief Picks the number of search threads.
+ * @param threads The requested number of threads.
+ * @param tasks The most tasks that can be in flight at once.
+ * @return The number of threads to start, at least 1.
+ */
+static size_t searchWorkers(size_t threads, size_t tasks) {
+    size_t workers = threads < tasks ? threads : tasks;
+    return workers ? workers : 1;
+}
+
+/**
+ * @brief Picks the wallet table the writer names vertices with.
+ * @param G The graph.
+ * @param options The search options.
+ * @return The address table, or NULL to write vertex ids.
+ */
+static const address_t *cycleAddresses(Graph G, const SearchOptions *options) {
+    if (!options->addresses) return NULL;
+    if (!G->addresses) fprintf(stderr, "Warning: wallet addresses are unknown; writing vertex ids.\n");
+    return G->addresses;
+}
+
+/**
+ * @brief Writes the formatted output gathered by the writer.
+ * @param out The output; its text is emptied.
+ */
+static void writeCycleText(CycleOutput *out) {
+    if (out->textSize > 0 && !out->writeFailed
+        && fwrite(out->text, 1, out->textSize, out->file) != out->textSize) {
+        perror("ERROR: writing output file");
+        out->writeFailed = true; // Keep draining the queue, so the search can finish.
+    }
+    out->written += out->textSize;
+    out->textSize = 0;
+}
+
+/**
+ * @brief Makes room in the writer's text, writing what it holds if needed.
+ * @param out The output.
+ * @param need The bytes needed after textSize.
+ */
+static void reserveCycleText(CycleOutput *out, size_t need) {
+    if (out->textCapacity - out->textSize >= need) return;
+    writeCycleText(out);
+    if (out->textCapacity < need) {
+        char *text = realloc(out->text, need);
+        if (!text) {
+            fprintf(stderr, "ERROR: bad alloc for cycle text\n");
+            exit(EXIT_FAILURE);
+        }
+        out->text = text;
+        out->textCapacity = need;
+    }
+}
+
+/**
+ * @brief Logs a cycle from its text.
+ * @param out The output.
+ * @param line The text of the cycle, from cycle_text_format().
+ * @param stats The aggregates of the cycle.
+ */
+static void logCycle(const CycleOutput *out, const char *line, const cycle_stats_t *stats) {
+    char value[UINT320_DEC_SIZE];
+    out->log("%.*s", (int)(strchr(line, '\n') + 1 - line), line);
+    for (int k = 0; k < CYCLE_STAT_KINDS; k++) {
+        if (!(out->stats & cycle_stat_info[k].flag)) continue;
+        cycle_stat_to_dec(stats, cycle_stat_info[k].flag, value);
+        out->log(cycle_stat_info[k].log_format, value);
+    }
+}
+
+/**
+ * @brief Notes the offset of the next binary record if it starts a stride of the index.
+ * @param out The output.
+ */
+static void indexCycle(CycleOutput *out) {
+    if (out->cycles % CYCLE_FILE_INDEX_STRIDE != 0) return;
+    if (out->indexSize == out->indexCapacity) {
+        size_t capacity = out->indexCapacity ? out->indexCapacity * 2 : 1024;
+        uint64_t *index = realloc(out->index, capacity * sizeof(uint64_t));
+        if (!index) {
+            fprintf(stderr, "ERROR: bad alloc for cycle index\n");
+            exit(EXIT_FAILURE);
+        }
+        out->index = index;
+        out->indexCapacity = capacity;
+    }
+    out->index[out->indexSize++] = out->written + out->textSize;
+}
+
+/**
+ * @brief Replaces the vertices of the record being formatted by the ids they are written with.
+ *
+ * Only a region (GraphDS.globalIds) numbers its vertices apart from the graph
+ * the user loaded; addresses are still looked up by the region's own ids.
+ *
+ * @param out The output.
+ * @param length The number of vertices in the record.
+ */
+static void translateCycle(CycleOutput *out, uint32_t length) {
+    if (!out->globalIds) return;
+    for (uint32_t i = 0; i < length; i++) out->vertices[i] = out->globalIds[out->vertices[i]];
+}
+
+/**
+ * @brief Numbers, formats and logs the cycle records of a block.
+ * @param out The output.
+ * @param block The block.
+ */
+static void formatCycleBlock(CycleOutput *out, const queue_block_t *block) {
+    bool logging = out->log != log_silent;
+    for (const char *p = block->data; p < block->data + block->size;) {
+        uint32_t length;
+        memcpy(&length, p, sizeof(length));
+        if (length > out->vertexCapacity) {
+            vertex *vertices = realloc(out->vertices, length * sizeof(vertex));
+            if (!vertices) {
+                fprintf(stderr, "ERROR: bad alloc for cycle text\n");
+                exit(EXIT_FAILURE);
+            }
+            out->vertices = vertices;
+            out->vertexCapacity = length;
+        }
+        memcpy(out->vertices, p + sizeof(length), length * sizeof(vertex));
+        cycle_stats_t stats;
+        p = cycle_stats_unpack(&stats, out->stats, p + sizeof(length) + (size_t)length * sizeof(vertex));
+
+        if (out->binary) indexCycle(out);
+        size_t number = ++out->cycles;
+        if (out->binary) {
+            size_t need = cycle_file_record_size(length);
+            reserveCycleText(out, need + (logging ? cycle_text_size(length) : 0));
+            char *line = out->text + out->textSize + need;
+            if (!out->addresses) translateCycle(out, length);
+            if (logging) { // Format the log text past the record; it is not written.
+                cycle_text_format(line, number, out->vertices, length, &stats, out->stats, out->addresses);
+            }
+            if (out->addresses) translateCycle(out, length); // The file keeps the ids
+            char *q = cycle_file_put_record(out->text + out->textSize, out->vertices, length, &stats, out->stats);
+            out->textSize = (size_t)(q - out->text);
+            if (logging) logCycle(out, line, &stats);
+        } else {
+            if (!out->addresses) translateCycle(out, length);
+            reserveCycleText(out, cycle_text_size(length));
+            char *line = out->text + out->textSize;
+            char *q = cycle_text_format(line, number, out->vertices, length, &stats, out->stats, out->addresses);
+            out->textSize = (size_t)(q - out->text);
+            if (logging) logCycle(out, line, &stats);
+        }
+    }
+}
+
+/**
+ * @brief Appends the index and the trailer that end a binary cycle file.
+ * @param out The output.
+ */
+static void finishCycleIndex(CycleOutput *out) {
+    uint64_t indexOffset = out->written + out->textSize;
+    for (size_t i = 0; i < out->indexSize; i++) {
+        reserveCycleText(out, sizeof(uint64_t));
+        out->textSize = (size_t)(cycle_file_put_u64(out->text + out->textSize, out->index[i]) - out->text);
+    }
+    reserveCycleText(out, CYCLE_FILE_TRAILER_SIZE);
+    out->textSize = (size_t)(cycle_file_put_trailer(out->text + out->textSize, indexOffset, out->cycles) - out->text);
+}
+
+/**
+ * @brief The writer thread: writes the queued blocks in the order they were queued.
+ * @param arg The CycleOutput.
+ * @return NULL.
+ */
+static void *cycleWriter(void *arg) {
+    CycleOutput *out = arg;
+    if (out->binary) {
+        out->textSize = (size_t)(cycle_file_put_header(out->text, out->stats) - out->text);
+    }
+    for (queue_block_t *block; (block = block_queue_pop(out->queue)) != NULL;) {
+        formatCycleBlock(out, block);
+        block_queue_release(out->queue, block);
+        if (out->textSize >= CYCLE_TEXT_SIZE / 2) writeCycleText(out);
+    }
+    if (out->binary) finishCycleIndex(out);
+    writeCycleText(out);
+    return NULL;
+}
+
+/**
+ * @brief Creates the block queue and starts the writer thread of a search.
+ * @param out The output, with its file open.
+ * @param workers The number of search threads.
+ * @return 0 on success, -1 on failure.
+ */
+static int startCycleWriter(CycleOutput *out, size_t workers) {
+    out->queue = block_queue_create(CYCLE_BLOCK_SIZE, workers + CYCLE_BLOCKS_QUEUED);
+    out->text = malloc(CYCLE_TEXT_SIZE);
+    out->textCapacity = CYCLE_TEXT_SIZE;
+    if (out->queue && out->text && pthread_create(&out->writer, NULL, cycleWriter, out) == 0) return 0;
+    block_queue_free(out->queue);
+    free(out->text);
+    out->queue = NULL;
+    out->text = NULL;
+    return -1;
+}
+
+/**
+ * @brief Waits for the writer to write every queued block, then frees the queue.
+ *
+ * Every search thread must have flushed its buffer.
+ *
+ * @param out The output.
+ */
+static void stopCycleWriter(CycleOutput *out) {
+    block_queue_close(out->queue);
+    pthread_join(out->writer, NULL);
+    block_queue_free(out->queue);
+    free(out->text);
+    free(out->vertices);
+    free(out->index);
+    out->queue = NULL;
+    out->text = NULL;
+    out->vertices = NULL;
+    out->index = NULL;
+}
+
+/**
+ * @brief Queues the block a thread is filling to the writer.
+ * @param buf The buffer; left without a block.
+ */
+static void flushCycles(CycleBuffer *buf) {
+    if (!buf->block) return;
+    if (buf->block->size > 0) {
+        block_queue_push(buf->out->queue, buf->block);
+    } else {
+        block_queue_release(buf->out->queue, buf->block);
+    }
+    buf->block = NULL;
+}
+
+/**
+ * @brief Returns the volume of an edge: the sum of its transactions once parallel edges are collapsed.
+ * @param G The graph.
+ * @param e The CSR index of the edge.
+ * @return The volume.
+ */
+static inline const uint256_t *edgeVolume(Graph G, size_t e) {
+    return G->valueSums ? &G->valueSums[e] : &G->values[e];
+}
+
+/**
+ * @brief Records the cycle closed by the edge e (frames[depth - 1].v -> frames[start].v) and its aggregates.
+ *
+ * The path must hold the edges between the frames, so frames[start .. depth)
+ * are joined by path edges start .. depth - 2; the aggregates are read from
+ * it without walking the cycle. If duplicates are dropped and the same vertex
+ * cycle was already reported, in any rotation, nothing is recorded. In a
+ * region (GraphDS.freshEdges), cycles without a fresh edge are not recorded
+ * either.
+ *
+ * @param G The graph.
+ * @param frames The current path.
+ * @param path The running aggregates of the current path.
+ * @param start The depth of the closing vertex on the current path.
+ * @param depth The current depth of the path.
+ * @param e The CSR index of the closing edge.
+ * @param buf The cycle buffer of the calling thread.
+ */
+static void reportCycle(Graph G, const DFSFrame *frames, const path_stats_t *path, int start, int depth, size_t e,
+                        CycleBuffer *buf) {
+    size_t length = (size_t)(depth - start);
+    if (G->freshEdges && !G->freshEdges[e]) {
+        int i = start;
+        while (i < depth - 1 && !G->freshEdges[frames[i].nextEdge - 1]) i++;
+        if (i == depth - 1) return; // Found by an earlier run
+    }
+    if (buf->out->seen) {
+        if (buf->cycleCapacity < length) {
+            size_t capacity = buf->cycleCapacity ? buf->cycleCapacity : 64;
+            while (capacity < length) capacity *= 2;
+            vertex *cycle = realloc(buf->cycle, capacity * sizeof(vertex));
+            if (!cycle) {
+                fprintf(stderr, "ERROR: bad alloc for cycle buffer\n");
+                exit(EXIT_FAILURE);
+            }
+            buf->cycle = cycle;
+            buf->cycleCapacity = capacity;
+        }
+        for (size_t i = 0; i < length; i++) buf->cycle[i] = frames[start + (int)i].v;
+        int added = cycle_set_insert(buf->out->seen, buf->cycle, length);
+        if (added < 0) {
+            fprintf(stderr, "ERROR: bad alloc for cycle set\n");
+            exit(EXIT_FAILURE);
+        }
+        if (!added) {
+            buf->duplicates++;
+            return;
+        }
+    }
+
+    size_t need = sizeof(uint32_t) + length * sizeof(vertex) + cycle_stats_packed_size(buf->out->stats);
+    if (!buf->block || buf->block->capacity - buf->block->size < need) {
+        flushCycles(buf);
+        buf->block = block_queue_acquire(buf->out->queue, need);
+        if (!buf->block) {
+            fprintf(stderr, "ERROR: bad alloc for cycle buffer\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    char *q = buf->block->data + buf->block->size;
+    uint32_t count = (uint32_t)length;
+    memcpy(q, &count, sizeof(count));
+    q += sizeof(count);
+    for (int i = start; i < depth; i++) {
+        memcpy(q, &frames[i].v, sizeof(vertex));
+        q += sizeof(vertex);
+    }
+    cycle_stats_t stats;
+    path_stats_cycle(path, start, &G->values[e], edgeVolume(G, e), &stats);
+    q = cycle_stats_pack(&stats, buf->out->stats, q);
+    buf->block->size = (size_t)(q - buf->block->data);
+}
+
+/**
+ * @brief Explores the SCC of root, reporting each back edge as a cycle.
+ *
+ * Uses an explicit stack of (vertex, next edge) frames instead of recursion, so
+ * the depth of the search is bounded by the heap rather than the thread stack,
+ * and visits edges in the same order as a recursive DFS would. Edges that
+ * leave the SCC of root cannot be on a cycle and are skipped.
+ *
+ * @param G The graph.
+ * @param root The unvisited vertex to start from.
+ * @param state The DFS working arrays of the calling thread.
  * @param log_func The logging function to use.
- * @param cycle_count Pointer to a counter for found cycles.
- */
-static void recursiveDFS(Graph G, int *visited, int *recStack, int *path, mpz_t *valuesPath, int *depth, vertex v, FILE *p, log_function_t log_func, size_t *cycle_count) {
-    visited[v] = 1;
-    recStack[v] = 1;
-    path[*depth] = v;
-    (*depth)++;
-
-    Transaction *curr = G->adjList[v];
-    while (curr) {
-        vertex w = curr->destination;
-        mpz_set(valuesPath[*depth - 1], curr->transactionValue);
-
-        if (!visited[w]) {
-            log_func("(%d -> %d)\n", v, w);
-            recursiveDFS(G, visited, recStack, path, valuesPath, depth, w, p, log_func, cycle_count);
-        } else if (recStack[w]) { // Cycle detected
-            (*cycle_count)++;
-            log_func("Cycle #%zu: ", *cycle_count);
-            fprintf(p, "Cycle #%zu: ", *cycle_count);
-
-            mpz_t cycle_max_value;
-            mpz_init(cycle_max_value); // Initializes to 0
-
-            size_t start_index = 0;
-            for (start_index = 0; (size_t)start_index < (size_t)*depth; start_index++) {
-                if (path[start_index] == w) break;
-            }
-            
-            // Find max value within the cycle path
-            for (size_t i = start_index; (size_t)i < (size_t)*depth - 1; i++) {
-                fprintf(p, "%d -> ", path[i]);
-                log_func("%d -> ", path[i]);
-                if (mpz_cmp(cycle_max_value, valuesPath[i]) < 0) {
-                    mpz_set(cycle_max_value, valuesPath[i]);
-                }
-            }
-            
-            fprintf(p, "%d -> ", path[*depth - 1]);
-            log_func("%d -> ", path[*depth - 1]);
-            if (mpz_cmp(cycle_max_value, curr->transactionValue) < 0) {
-                mpz_set(cycle_max_value, curr->transactionValue);
-            }
+ */
+static void iterativeDFS(Graph G, vertex root, DFSState *state, log_function_t log_func) {
+    DFSFrame *frames = state->frames;
+    int component = state->component[root];
+    int depth = 0;
+
+    state->visited[root] = 1;
+    state->stackPos[root] = depth;
+    frames[depth++] = (DFSFrame){root, G->offsets[root]};
+
+    while (depth > 0) {
+        DFSFrame *top = &frames[depth - 1];
+        if (top->nextEdge == G->offsets[top->v + 1]) {
+            state->stackPos[top->v] = -1; // Backtrack
+            if (--depth > 0) path_stats_pop(&state->path);
+            continue;
+        }
+
+        size_t e = top->nextEdge++;
+        vertex w = G->destinations[e];
+        if (state->component[w] != component) continue;
+
+        if (!state->visited[w]) {
+            log_func("(%d -> %d)\n", top->v, w);
+            state->visited[w] = 1;
+            state->stackPos[w] = depth;
+            path_stats_push(&state->path, &G->values[e], edgeVolume(G, e));
+            frames[depth++] = (DFSFrame){w, G->offsets[w]};
+        } else if (state->stackPos[w] >= 0) { // Cycle detected
+            reportCycle(G, frames, &state->path, state->stackPos[w], depth, e, state->output);
+        }
+    }
+}
+
+/**
+ * @brief Computes the SCCs of a graph and records their statistics.
+ * @param G The graph.
+ * @param info Receives the SCC statistics and runtime.
+ * @return The partition, or NULL on allocation failure (already reported).
+ */
+static scc_partition_t *partitionSCCs(Graph G, LogInfo_t *info) {
+    double start = wallSeconds();
+    scc_partition_t *scc = scc_partition(G);
+    if (!scc) {
+        fprintf(stderr, "ERROR: bad alloc for SCC arrays\n");
+        return NULL;
+    }
+    info->runtimeSCC = wallSeconds() - start;
+    info->sccCount = scc->count;
+    info->sccVertices = scc->vertices;
+    info->sccEdges = scc->edges;
+    info->sccLargest = scc->largest;
+    info->sccDiscarded = scc->discarded;
+    memcpy(info->sccSizeHistogram, scc->histogram, sizeof(info->sccSizeHistogram));
+    return scc;
+}
 
-            fprintf(p, "%d\n", w);
-            log_func("%d\n", w);
+/**
+ * @brief Creates one cycle buffer per worker.
+ * @param out The shared output.
+ * @param workers The number of workers.
+ * @return The buffers, or NULL on allocation failure.
+ */
+static CycleBuffer *createCycleBuffers(CycleOutput *out, size_t workers) {
+    CycleBuffer *buffers = calloc(workers, sizeof(CycleBuffer));
+    if (!buffers) return NULL;
+    for (size_t t = 0; t < workers; t++) buffers[t].out = out;
+    return buffers;
+}
+
+/**
+ * @brief Frees the cycle buffers of a search.
+ * @param buffers The buffers, or NULL.
+ * @param workers The number of workers.
+ */
+static void freeCycleBuffers(CycleBuffer *buffers, size_t workers) {
+    for (size_t t = 0; buffers && t < workers; t++) free(buffers[t].cycle);
+    free(buffers);
+}
 
-            gmp_fprintf(p, "Max Flow: %Zd WEI\n", cycle_max_value);
-            log_func("Max Flow in Cycle: ");
-            if (log_func == log_verbose) {
-                gmp_printf("%Zd\n", cycle_max_value);
+/**
+ * @brief Checks whether some pair of vertices is joined by more than one edge.
+ * @param G The graph.
+ * @return true if there are parallel edges, or if the check ran out of memory.
+ */
+static bool hasParallelEdges(Graph G) {
+    vertex *lastSource = malloc((G->vertexAmount ? G->vertexAmount : 1) * sizeof(vertex));
+    if (!lastSource) return true;
+    for (size_t v = 0; v < G->vertexAmount; v++) lastSource[v] = -1;
+    bool found = false;
+    for (size_t v = 0; v < G->vertexAmount && !found; v++) {
+        for (size_t e = G->offsets[v]; e < G->offsets[v + 1]; e++) {
+            vertex w = G->destinations[e];
+            if (lastSource[w] == (vertex)v) {
+                found = true;
+                break;
             }
-            mpz_clear(cycle_max_value);
+            lastSource[w] = (vertex)v;
         }
-        curr = curr->next;
     }
-    recStack[v] = 0; // Backtrack
-    (*depth)--;
+    free(lastSource);
+    return found;
+}
+
+/**
+ * @brief Creates the set of reported cycles if duplicates are to be dropped and can occur.
+ *
+ * Every search reports a given sequence of edges once, so it can only find a
+ * vertex cycle twice through parallel edges. Without any, the set would only
+ * cost memory and is not created.
+ *
+ * @param G The graph.
+ * @param options The search options.
+ * @param out The shared output; receives the set.
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int trackDuplicates(Graph G, const SearchOptions *options, CycleOutput *out) {
+    if (!options->dedup || !hasParallelEdges(G)) return 0;
+    out->seen = cycle_set_create();
+    return out->seen ? 0 : -1;
+}
+
+/**
+ * @brief Runs the queued search tasks while the writer thread writes the cycles they find.
+ * @param pool The pool, with the initial tasks queued.
+ * @param fn The task function.
+ * @param ctx The search context.
+ * @param buffers The cycle buffer of each worker.
+ * @param info Receives the number of cycles found and dropped, and the runtime.
+ */
+static void runSearch(work_pool_t *pool, work_fn_t fn, void *ctx, CycleBuffer *buffers, LogInfo_t *info) {
+    CycleOutput *out = buffers->out;
+    size_t workers = work_pool_workers(pool);
+    double start = wallSeconds();
+    if (startCycleWriter(out, workers) != 0) {
+        fprintf(stderr, "ERROR: could not start the cycle writer\n");
+        return;
+    }
+    if (work_pool_run(pool, fn, ctx) != 0) {
+        fprintf(stderr, "WARNING: could not start every search thread\n");
+    }
+    info->cyclesDuplicate = 0;
+    for (size_t t = 0; t < workers; t++) {
+        flushCycles(&buffers[t]);
+        info->cyclesDuplicate += buffers[t].duplicates;
+    }
+    stopCycleWriter(out);
+    info->runtimeAlgorithm = wallSeconds() - start;
+    info->cyclesFound = out->cycles;
+}
+
+/**
+ * @struct DFSRun
+ * @brief The context of the DFS tasks; a task explores one SCC.
+ */
+typedef struct {
+    Graph G;                     /**< The graph. */
+    const scc_partition_t *scc;  /**< Its non-trivial SCCs. */
+    DFSState *states;            /**< The working arrays of each worker. */
+    log_function_t log;          /**< The logging function. */
+} DFSRun;
+
+/**
+ * @brief Explores SCC item.first, starting at its first member.
+ * @param pool The pool.
+ * @param worker The calling worker.
+ * @param item The SCC.
+ * @param ctx A DFSRun.
+ */
+static void dfsTask(work_pool_t *pool, size_t worker, work_item_t item, void *ctx) {
+    (void)pool;
+    DFSRun *run = ctx;
+    iterativeDFS(run->G, run->scc->members[run->scc->offsets[item.first]], &run->states[worker], run->log);
 }
 
 /**
@@ -338,61 +2374,758 @@ static void recursiveDFS(Graph G, int *visited, int *recStack, int *path, mpz_t
  *   O(V + E)
  * \f]
  * where \f$ V \f$ is the number of vertices and \f$ E \f$ is the number of edges.
+ *
+ * SCCs are searched in parallel. A single DFS cannot be split, so one giant
+ * SCC is still searched by one thread.
  * @param G The graph to search.
- * @param filename The name of the file to write cycle information to.
- * @param logger The logging function to use.
- * @param total_cycles_found A pointer to a size_t to store the count of found cycles.
+ * @param options The output file, threads, reported aggregates, deduplication and logger.
+ * @param info Receives the number of cycles found, the SCC statistics and the runtimes.
  */
-void depthFirstSearch(Graph G, const char *const filename, log_function_t logger, size_t *total_cycles_found) {
+void depthFirstSearch(Graph G, const SearchOptions *options, LogInfo_t *info) {
+    info->cyclesFound = 0;
     if (G->vertexAmount == 0) return;
 
-    int *visited = calloc(G->vertexAmount, sizeof(int));
-    int *recStack = calloc(G->vertexAmount, sizeof(int));
-    int *path = malloc(G->vertexAmount * sizeof(int));
-    mpz_t *valuesPath = malloc(G->vertexAmount * sizeof(mpz_t));
-    int depth = 0;
+    scc_partition_t *scc = partitionSCCs(G, info);
+    if (!scc) return;
+
+    size_t workers = searchWorkers(options->threads, scc->count);
+    size_t pathLength = scc->largest ? scc->largest : 1;
+    CycleOutput out = {NULL, options->logger, options->stats, options->binary, cycleAddresses(G, options), G->globalIds, NULL};
+    unsigned char *visited = calloc(G->vertexAmount, sizeof(unsigned char));
+    int *stackPos = malloc(G->vertexAmount * sizeof(int));
+    DFSState *states = calloc(workers, sizeof(DFSState));
+    CycleBuffer *buffers = createCycleBuffers(&out, workers);
+    work_pool_t *pool = work_pool_create(workers);
+
+    bool ok = visited && stackPos && states && buffers && pool && trackDuplicates(G, options, &out) == 0;
+    for (size_t t = 0; ok && t < workers; t++) {
+        states[t].visited = visited;
+        states[t].stackPos = stackPos;
+        states[t].frames = malloc(pathLength * sizeof(DFSFrame));
+        int pathStatus = path_stats_init(&states[t].path, pathLength, options->stats);
+        states[t].component = scc->component;
+        states[t].output = &buffers[t];
+        ok = states[t].frames && pathStatus == 0;
+    }
+    // Deal the SCCs round-robin; each worker pops its smallest one first.
+    for (size_t c = scc->count; ok && c-- > 0;) {
+        ok = work_pool_push(pool, c % workers, (work_item_t){c, 0}) == 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "ERROR: bad alloc for DFS arrays\n");
+        goto cleanup;
+    }
 
-    FILE *p = fopen(filename, "w");
-    if (p == NULL) {
+    out.file = fopen(options->filename, "w");
+    if (out.file == NULL) {
         perror("ERROR: creating/opening output file");
-        // Free allocated memory before returning
-        free(visited);
-        free(recStack);
-        free(path);
-        free(valuesPath);
+        goto cleanup;
+    }
+
+    for (size_t v = 0; v < G->vertexAmount; v++) stackPos[v] = -1;
+
+    DFSRun run = {G, scc, states, options->logger};
+    runSearch(pool, dfsTask, &run, buffers, info);
+
+cleanup:
+    for (size_t t = 0; states && t < workers; t++) {
+        free(states[t].frames);
+        path_stats_destroy(&states[t].path);
+    }
+    free(states);
+    freeCycleBuffers(buffers, workers);
+    free(visited);
+    free(stackPos);
+    work_pool_free(pool);
+    scc_partition_free(scc);
+    if (out.file) fclose(out.file);
+    cycle_set_free(out.seen);
+}
+
+// --- CYCLE ENUMERATION (JOHNSON) FUNCTIONS ---
+
+/**
+ * @brief Unblocks a vertex and, transitively, every vertex waiting on it (Johnson's unblock()).
+ * @param state The Johnson state.
+ * @param u The vertex to unblock.
+ */
+static void johnsonUnblock(JohnsonState *state, vertex u) {
+    size_t top = 0;
+    state->blocked[u] = 0;
+    state->unblockStack[top++] = u;
+
+    while (top > 0) {
+        BlockList *list = &state->blockLists[state->unblockStack[--top]];
+        for (size_t i = 0; i < list->count; i++) {
+            BlockEntry entry = list->items[i];
+            state->inBlockList[entry.edge] = 0;
+            if (state->blocked[entry.v]) {
+                state->blocked[entry.v] = 0;
+                state->unblockStack[top++] = entry.v;
+            }
+        }
+        list->count = 0;
+    }
+}
+
+/**
+ * @brief Appends (v, edge) to the B-list of w, unless that edge is already there.
+ * @param state The Johnson state.
+ * @param w The owner of the list.
+ * @param v The vertex to release when w is unblocked.
+ * @param edge The edge from v to w.
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int johnsonBlockOn(JohnsonState *state, vertex w, vertex v, size_t edge) {
+    if (state->inBlockList[edge]) return 0;
+    BlockList *list = &state->blockLists[w];
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 4;
+        BlockEntry *items = realloc(list->items, capacity * sizeof(BlockEntry));
+        if (!items) return -1;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = (BlockEntry){v, edge};
+    state->inBlockList[edge] = 1;
+    return 0;
+}
+
+/**
+ * @brief Reports every elementary cycle through s inside the subproblem of s (Johnson's circuit()).
+ *
+ * Iterative, with an explicit stack of (vertex, next edge) frames. A vertex
+ * stays blocked after it is left without finding a cycle, until one of the
+ * vertices it leads to is unblocked, so no dead end is explored twice between
+ * two cycles.
+ *
+ * @param G The graph.
+ * @param s The smallest vertex of the subproblem.
+ * @param state The Johnson state of the calling thread.
+ * @return 0 on success, -1 on allocation failure.
+ */
+static int johnsonCircuit(Graph G, vertex s, JohnsonState *state) {
+    DFSFrame *frames = state->frames;
+    const int *label = state->label;
+    int set = scc_label_get(label, s);
+    int depth = 0;
+
+    state->blocked[s] = 1;
+    state->found[depth] = 0;
+    frames[depth++] = (DFSFrame){s, G->offsets[s]};
+
+    while (depth > 0) {
+        DFSFrame *top = &frames[depth - 1];
+        vertex v = top->v;
+
+        if (top->nextEdge < G->offsets[v + 1]) {
+            size_t e = top->nextEdge++;
+            vertex w = G->destinations[e];
+            if (scc_label_get(label, w) != set) continue;
+
+            if (w == s) {
+                reportCycle(G, frames, &state->path, 0, depth, e, state->output);
+                state->found[depth - 1] = 1;
+            } else if (!state->blocked[w]) {
+                state->blocked[w] = 1;
+                state->found[depth] = 0;
+                path_stats_push(&state->path, &G->values[e], edgeVolume(G, e));
+                frames[depth++] = (DFSFrame){w, G->offsets[w]};
+            }
+            continue;
+        }
+
+        // All edges of v done.
+        if (state->found[depth - 1]) {
+            johnsonUnblock(state, v);
+        } else {
+            for (size_t e = G->offsets[v]; e < G->offsets[v + 1]; e++) {
+                vertex w = G->destinations[e];
+                if (scc_label_get(label, w) == set && johnsonBlockOn(state, w, v, e) != 0) return -1;
+            }
+        }
+        if (--depth > 0) {
+            path_stats_pop(&state->path);
+            if (state->found[depth]) state->found[depth - 1] = 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @struct JohnsonRun
+ * @brief The context of the Johnson tasks; a task is one subproblem, a range of the arena.
+ */
+typedef struct {
+    Graph G;                     /**< The graph. */
+    vertex *arena;               /**< The members of every pending subproblem, each in its own range. */
+    int nextLabel;               /**< The next unused subproblem label; accessed atomically. */
+    int failed;                  /**< Set once a task ran out of memory; accessed atomically. */
+    JohnsonState *states;        /**< The working arrays of each worker. */
+} JohnsonRun;
+
+/**
+ * @brief Reports the cycles through the smallest vertex of a subproblem and queues what is left of it.
+ * @param pool The pool; receives the child subproblems on the calling worker.
+ * @param worker The calling worker.
+ * @param item The subproblem: item.count members from arena[item.first].
+ * @param ctx A JohnsonRun.
+ */
+static void johnsonTask(work_pool_t *pool, size_t worker, work_item_t item, void *ctx) {
+    JohnsonRun *run = ctx;
+    JohnsonState *state = &run->states[worker];
+    if (__atomic_load_n(&run->failed, __ATOMIC_RELAXED)) return;
+
+    vertex *members = run->arena + item.first;
+    size_t n = item.count;
+    vertex s = members[0];
+
+    if (johnsonCircuit(run->G, s, state) != 0) {
+        fprintf(stderr, "ERROR: bad alloc for Johnson block lists\n");
+        __atomic_store_n(&run->failed, 1, __ATOMIC_RELAXED);
         return;
     }
+    for (size_t i = 0; i < n; i++) {
+        BlockList *list = &state->blockLists[members[i]];
+        for (size_t j = 0; j < list->count; j++) state->inBlockList[list->items[j].edge] = 0;
+        list->count = 0;
+        state->blocked[members[i]] = 0;
+    }
 
-    if (!visited || !recStack || !path || !valuesPath) {
-        fprintf(stderr, "ERROR: bad alloc for DFS arrays\n");
-        free(visited);
-        free(recStack);
-        free(path);
-        free(valuesPath);
-        fclose(p);
+    // Remove s and split what is left; the children reuse the range of their parent.
+    scc_label_set(state->label, s, SCC_NONE);
+    size_t k = scc_split(run->G, members + 1, n - 1, state->label, &run->nextLabel, state->ws,
+                         state->children, state->childOffsets, NULL);
+    memcpy(members, state->children, state->childOffsets[k] * sizeof(vertex));
+    for (size_t c = k; c-- > 0;) {
+        work_item_t child = {item.first + state->childOffsets[c], state->childOffsets[c + 1] - state->childOffsets[c]};
+        if (work_pool_push(pool, worker, child) != 0) {
+            fprintf(stderr, "ERROR: bad alloc for Johnson tasks\n");
+            __atomic_store_n(&run->failed, 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Enumerates every elementary cycle with Johnson's algorithm.
+ *
+ * Each non-trivial SCC is a subproblem. For a subproblem, all cycles through
+ * its smallest vertex s are reported; s is then removed and the rest is split
+ * into SCCs again, each a new subproblem. Subproblems are disjoint, so they
+ * are work items of a thread pool: a large SCC is split start vertex by start
+ * vertex, and idle threads steal the pieces. The vertex lists of all
+ * subproblems share one arena, since the children of a subproblem never hold
+ * more vertices than it did.
+ *
+ * The complexity is
+ * \f[
+ *   O((V + E)(C + 1))
+ * \f]
+ * where \f$ C \f$ is the number of cycles.
+ * @param G The graph to search.
+ * @param options The output file, threads, reported aggregates, deduplication and logger.
+ * @param info Receives the number of cycles found, the SCC statistics and the runtimes.
+ */
+void johnsonCycles(Graph G, const SearchOptions *options, LogInfo_t *info) {
+    info->cyclesFound = 0;
+    if (G->vertexAmount == 0) return;
+
+    scc_partition_t *scc = partitionSCCs(G, info);
+    if (!scc) return;
+
+    size_t V = G->vertexAmount;
+    size_t workers = searchWorkers(options->threads, scc->vertices);
+    size_t setSize = scc->largest ? scc->largest : 1;
+    CycleOutput out = {NULL, options->logger, options->stats, options->binary, cycleAddresses(G, options), G->globalIds, NULL};
+    unsigned char *blocked = calloc(V, sizeof(unsigned char));
+    BlockList *blockLists = calloc(V, sizeof(BlockList));
+    unsigned char *inBlockList = calloc(G->edgesAmount ? G->edgesAmount : 1, sizeof(unsigned char));
+    scc_workspace_t *ws = scc_workspace_create(V);
+    vertex *arena = malloc(V * sizeof(vertex));
+    JohnsonState *states = calloc(workers, sizeof(JohnsonState));
+    CycleBuffer *buffers = createCycleBuffers(&out, workers);
+    work_pool_t *pool = work_pool_create(workers);
+
+    bool ok = blocked && blockLists && inBlockList && ws && arena && states && buffers && pool
+              && trackDuplicates(G, options, &out) == 0;
+    for (size_t t = 0; ok && t < workers; t++) {
+        JohnsonState *state = &states[t];
+        state->blocked = blocked;
+        state->blockLists = blockLists;
+        state->inBlockList = inBlockList;
+        state->frames = malloc(setSize * sizeof(DFSFrame));
+        state->found = malloc(setSize * sizeof(unsigned char));
+        int pathStatus = path_stats_init(&state->path, setSize, options->stats);
+        state->unblockStack = malloc(setSize * sizeof(vertex));
+        state->label = scc->component;
+        state->ws = t == 0 ? ws : scc_workspace_clone(ws, setSize);
+        state->children = malloc(setSize * sizeof(vertex));
+        state->childOffsets = malloc((setSize + 1) * sizeof(size_t));
+        state->output = &buffers[t];
+        ok = state->frames && state->found && pathStatus == 0 && state->unblockStack && state->ws
+             && state->children && state->childOffsets;
+    }
+    // Deal the SCCs round-robin; each worker pops the one with its smallest vertex first.
+    if (ok) memcpy(arena, scc->members, scc->vertices * sizeof(vertex));
+    for (size_t c = scc->count; ok && c-- > 0;) {
+        work_item_t item = {scc->offsets[c], scc->offsets[c + 1] - scc->offsets[c]};
+        ok = work_pool_push(pool, c % workers, item) == 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "ERROR: bad alloc for Johnson arrays\n");
+        goto cleanup;
+    }
+
+    out.file = fopen(options->filename, "w");
+    if (out.file == NULL) {
+        perror("ERROR: creating/opening output file");
+        goto cleanup;
+    }
+
+    JohnsonRun run = {G, arena, (int)scc->count, 0, states};
+    runSearch(pool, johnsonTask, &run, buffers, info);
+
+cleanup:
+    if (blockLists) {
+        for (size_t v = 0; v < V; v++) free(blockLists[v].items);
+    }
+    for (size_t t = 0; states && t < workers; t++) {
+        free(states[t].frames);
+        free(states[t].found);
+        path_stats_destroy(&states[t].path);
+        free(states[t].unblockStack);
+        if (t > 0) scc_workspace_free(states[t].ws);
+        free(states[t].children);
+        free(states[t].childOffsets);
+    }
+    free(states);
+    freeCycleBuffers(buffers, workers);
+    free(blocked);
+    free(blockLists);
+    free(inBlockList);
+    scc_workspace_free(ws);
+    free(arena);
+    work_pool_free(pool);
+    scc_partition_free(scc);
+    if (out.file) fclose(out.file);
+    cycle_set_free(out.seen);
+}
+
+// --- LENGTH-BOUNDED CYCLE ENUMERATION FUNCTIONS ---
+
+/**
+ * @struct BoundedState
+ * @brief The working arrays of one thread of the bounded search, indexed by position within the SCC.
+ */
+typedef struct {
+    DFSState dfs;                /**< The path; dfs.stackPos is indexed by position within the SCC. */
+    int *distance;               /**< Distance of each vertex to the start vertex, or -1. */
+    vertex *queue;               /**< The reverse BFS queue. */
+} BoundedState;
+
+/**
+ * @brief Computes, by reverse BFS, the distance to s of every vertex that can reach it in fewer than maxLength edges.
+ *
+ * Only vertices of the SCC of s that are greater than s are considered, since
+ * cycles through smaller vertices are reported from those.
+ *
+ * @param G The graph, with its reverse CSR built.
+ * @param s The start vertex.
+ * @param maxLength The longest cycle to report.
+ * @param component SCC id of each vertex.
+ * @param localIndex Position of each vertex within its SCC.
+ * @param distance Distance to s, by position; -1 for every vertex on entry, and for the vertices not reached on exit.
+ * @param queue Receives the vertices reached, in BFS order. Capacity: the size of the SCC.
+ * @return The number of vertices reached, s included.
+ */
+static size_t distancesToStart(Graph G, vertex s, size_t maxLength, const int *component, const int *localIndex,
+                               int *distance, vertex *queue) {
+    int set = component[s];
+    size_t head = 0, tail = 0;
+    distance[localIndex[s]] = 0;
+    queue[tail++] = s;
+
+    while (head < tail) {
+        vertex u = queue[head++];
+        int du = distance[localIndex[u]];
+        if ((size_t)du + 1 >= maxLength) continue; // A farther vertex could not close in time
+        for (size_t e = G->inOffsets[u]; e < G->inOffsets[u + 1]; e++) {
+            vertex x = G->inSources[e];
+            if (x > s && component[x] == set && distance[localIndex[x]] < 0) {
+                distance[localIndex[x]] = du + 1;
+                queue[tail++] = x;
+            }
+        }
+    }
+    return tail;
+}
+
+/**
+ * @brief Reports every elementary cycle through s, made of s and larger vertices, of at most maxLength edges.
+ *
+ * A path of depth frames reaching w can only close in depth + distance[w]
+ * edges or more, so w is entered only if that fits the budget.
+ *
+ * @param G The graph.
+ * @param s The start vertex.
+ * @param maxLength The longest cycle to report.
+ * @param state The bounded state of the calling thread; distance filled by distancesToStart(), stackPos all -1.
+ * @param localIndex Position of each vertex within its SCC.
+ */
+static void boundedCircuits(Graph G, vertex s, size_t maxLength, BoundedState *state, const int *localIndex) {
+    DFSFrame *frames = state->dfs.frames;
+    int *stackPos = state->dfs.stackPos;
+    const int *distance = state->distance;
+    const int *component = state->dfs.component;
+    int set = component[s];
+    int depth = 0;
+
+    stackPos[localIndex[s]] = depth;
+    frames[depth++] = (DFSFrame){s, G->offsets[s]};
+
+    while (depth > 0) {
+        DFSFrame *top = &frames[depth - 1];
+        if (top->nextEdge == G->offsets[top->v + 1]) {
+            stackPos[localIndex[top->v]] = -1;
+            if (--depth > 0) path_stats_pop(&state->dfs.path);
+            continue;
+        }
+
+        size_t e = top->nextEdge++;
+        vertex w = G->destinations[e];
+        if (w == s) {
+            reportCycle(G, frames, &state->dfs.path, 0, depth, e, state->dfs.output);
+            continue;
+        }
+        if (component[w] != set) continue;
+        int lw = localIndex[w];
+        if (distance[lw] > 0 && stackPos[lw] < 0 && (size_t)(depth + distance[lw]) <= maxLength) {
+            path_stats_push(&state->dfs.path, &G->values[e], edgeVolume(G, e));
+            stackPos[lw] = depth;
+            frames[depth++] = (DFSFrame){w, G->offsets[w]};
+        }
+    }
+}
+
+/**
+ * @struct BoundedRun
+ * @brief The context of the bounded tasks; a task is one start vertex.
+ */
+typedef struct {
+    Graph G;                     /**< The graph, with its reverse CSR built. */
+    const scc_partition_t *scc;  /**< Its non-trivial SCCs. */
+    size_t maxLength;            /**< The longest cycle to report. */
+    const int *localIndex;       /**< Position of each vertex within its SCC. */
+    BoundedState *states;        /**< The working arrays of each worker. */
+} BoundedRun;
+
+/**
+ * @brief Reports the bounded cycles through the start vertex scc->members[item.first].
+ * @param pool The pool.
+ * @param worker The calling worker.
+ * @param item The start vertex.
+ * @param ctx A BoundedRun.
+ */
+static void boundedTask(work_pool_t *pool, size_t worker, work_item_t item, void *ctx) {
+    (void)pool;
+    BoundedRun *run = ctx;
+    BoundedState *state = &run->states[worker];
+    vertex s = run->scc->members[item.first];
+
+    size_t reached = distancesToStart(run->G, s, run->maxLength, run->scc->component, run->localIndex,
+                                      state->distance, state->queue);
+    boundedCircuits(run->G, s, run->maxLength, state, run->localIndex);
+    for (size_t j = 0; j < reached; j++) state->distance[run->localIndex[state->queue[j]]] = -1;
+}
+
+/**
+ * @brief Enumerates every elementary cycle of at most maxLength edges.
+ *
+ * Every start vertex is a separate task, so large SCCs are spread over all threads.
+ *
+ * @param G The graph to search.
+ * @param maxLength The longest cycle to report, in edges.
+ * @param options The output file, threads, reported aggregates, deduplication and logger.
+ * @param info Receives the number of cycles found, the SCC statistics and the runtimes.
+ */
+void boundedCycles(Graph G, size_t maxLength, const SearchOptions *options, LogInfo_t *info) {
+    info->cyclesFound = 0;
+    if (G->vertexAmount == 0 || maxLength == 0) return;
+
+    scc_partition_t *scc = partitionSCCs(G, info);
+    if (!scc) return;
+    buildReverseCSR(G);
+
+    size_t workers = searchWorkers(options->threads, scc->vertices);
+    size_t setSize = scc->largest ? scc->largest : 1;
+    CycleOutput out = {NULL, options->logger, options->stats, options->binary, cycleAddresses(G, options), G->globalIds, NULL};
+    int *localIndex = malloc(G->vertexAmount * sizeof(int));
+    BoundedState *states = calloc(workers, sizeof(BoundedState));
+    CycleBuffer *buffers = createCycleBuffers(&out, workers);
+    work_pool_t *pool = work_pool_create(workers);
+
+    bool ok = localIndex && states && buffers && pool && trackDuplicates(G, options, &out) == 0;
+    for (size_t t = 0; ok && t < workers; t++) {
+        BoundedState *state = &states[t];
+        state->dfs.stackPos = malloc(setSize * sizeof(int));
+        state->dfs.frames = malloc(setSize * sizeof(DFSFrame));
+        int pathStatus = path_stats_init(&state->dfs.path, setSize, options->stats);
+        state->dfs.component = scc->component;
+        state->dfs.output = &buffers[t];
+        state->distance = malloc(setSize * sizeof(int));
+        state->queue = malloc(setSize * sizeof(vertex));
+        ok = state->dfs.stackPos && state->dfs.frames && pathStatus == 0 && state->distance && state->queue;
+        for (size_t i = 0; ok && i < setSize; i++) {
+            state->dfs.stackPos[i] = -1;
+            state->distance[i] = -1;
+        }
+    }
+    for (size_t i = scc->vertices; ok && i-- > 0;) {
+        ok = work_pool_push(pool, i % workers, (work_item_t){i, 0}) == 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "ERROR: bad alloc for bounded search arrays\n");
+        goto cleanup;
+    }
+
+    out.file = fopen(options->filename, "w");
+    if (out.file == NULL) {
+        perror("ERROR: creating/opening output file");
+        goto cleanup;
+    }
+
+    for (size_t c = 0; c < scc->count; c++) {
+        for (size_t i = scc->offsets[c]; i < scc->offsets[c + 1]; i++) {
+            localIndex[scc->members[i]] = (int)(i - scc->offsets[c]);
+        }
+    }
+
+    BoundedRun run = {G, scc, maxLength, localIndex, states};
+    runSearch(pool, boundedTask, &run, buffers, info);
+
+cleanup:
+    for (size_t t = 0; states && t < workers; t++) {
+        free(states[t].dfs.stackPos);
+        free(states[t].dfs.frames);
+        path_stats_destroy(&states[t].dfs.path);
+        free(states[t].distance);
+        free(states[t].queue);
+    }
+    free(states);
+    freeCycleBuffers(buffers, workers);
+    free(localIndex);
+    work_pool_free(pool);
+    scc_partition_free(scc);
+    if (out.file) fclose(out.file);
+    cycle_set_free(out.seen);
+}
+
+// --- TEMPORAL CYCLE ENUMERATION FUNCTIONS ---
+
+/**
+ * @brief Finds the first out-edge of v with a timestamp at or after t.
+ * @param G The graph, with timestamps.
+ * @param v The vertex.
+ * @param t The earliest usable timestamp.
+ * @return The CSR index of that edge, or offsets[v + 1] if there is none.
+ */
+static size_t firstEdgeAfter(Graph G, vertex v, uint64_t t) {
+    size_t lo = G->offsets[v], hi = G->offsets[v + 1];
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (G->timestamps[mid] < t) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @struct TemporalRun
+ * @brief The context of the temporal tasks; a task is one start vertex.
+ */
+typedef struct {
+    Graph G;                     /**< The graph, with timestamps. */
+    const scc_partition_t *scc;  /**< Its non-trivial SCCs. */
+    uint64_t window;             /**< The largest time span of a cycle. */
+    size_t maxLength;            /**< The longest cycle to report, or 0 for no limit. */
+    const int *localIndex;       /**< Position of each vertex within its SCC. */
+    DFSState *states;            /**< The working arrays of each worker; stackPos is indexed by position within the SCC. */
+} TemporalRun;
+
+/**
+ * @brief Reports every time-respecting elementary cycle that starts and ends at s.
+ *
+ * The first edge out of s fixes the start time t0. Every later edge must be no
+ * earlier than the one before it and no later than t0 + window. Edges are
+ * sorted by time, so entering a vertex at time t starts its scan at the first
+ * edge at or after t (binary search), and the scan stops at the first edge past
+ * the window.
+ *
+ * The time order fixes where a cycle starts, so, unlike the static searches,
+ * the path may go through vertices smaller than s. The one exception is a
+ * cycle whose edges all share one timestamp: it is time-respecting from every
+ * one of its vertices, and is only reported from the smallest.
+ *
+ * @param run The search context.
+ * @param s The start vertex.
+ * @param state The working arrays of the calling thread; stackPos all -1.
+ */
+static void temporalCircuits(const TemporalRun *run, vertex s, DFSState *state) {
+    Graph G = run->G;
+    DFSFrame *frames = state->frames;
+    int *stackPos = state->stackPos;
+    const int *component = state->component;
+    const int *localIndex = run->localIndex;
+    int set = component[s];
+    size_t maxDepth = run->maxLength ? run->maxLength : SIZE_MAX;
+    uint64_t startTime = 0, deadline = 0;
+    size_t below = 0; // Vertices smaller than s on the path
+    int depth = 0;
+
+    stackPos[localIndex[s]] = depth;
+    frames[depth++] = (DFSFrame){s, G->offsets[s]};
+
+    while (depth > 0) {
+        DFSFrame *top = &frames[depth - 1];
+        size_t e = top->nextEdge;
+        if (e == G->offsets[top->v + 1] || (depth > 1 && G->timestamps[e] > deadline)) {
+            stackPos[localIndex[top->v]] = -1;
+            if (top->v < s) below--;
+            if (--depth > 0) path_stats_pop(&state->path);
+            continue;
+        }
+        top->nextEdge++;
+
+        uint64_t t = G->timestamps[e];
+        if (depth == 1) {
+            startTime = t;
+            deadline = t > UINT64_MAX - run->window ? UINT64_MAX : t + run->window;
+        }
+        vertex w = G->destinations[e];
+        if (w == s) {
+            if (below > 0 && t == startTime) continue; // Reported from its smallest vertex
+            reportCycle(G, frames, &state->path, 0, depth, e, state->output);
+            continue;
+        }
+        if (component[w] != set || stackPos[localIndex[w]] >= 0 || (size_t)depth + 1 > maxDepth) continue;
+
+        path_stats_push(&state->path, &G->values[e], edgeVolume(G, e));
+        stackPos[localIndex[w]] = depth;
+        if (w < s) below++;
+        frames[depth++] = (DFSFrame){w, firstEdgeAfter(G, w, t)};
+    }
+}
+
+/**
+ * @brief Reports the temporal cycles through the start vertex scc->members[item.first].
+ * @param pool The pool.
+ * @param worker The calling worker.
+ * @param item The start vertex.
+ * @param ctx A TemporalRun.
+ */
+static void temporalTask(work_pool_t *pool, size_t worker, work_item_t item, void *ctx) {
+    (void)pool;
+    TemporalRun *run = ctx;
+    temporalCircuits(run, run->scc->members[item.first], &run->states[worker]);
+}
+
+/**
+ * @brief Enumerates every time-respecting elementary cycle that fits in a time window.
+ * @param G The graph to search; it must have timestamps.
+ * @param window The largest time span of a cycle, between its first and last edges.
+ * @param maxLength The longest cycle to report, in edges, or 0 for no limit.
+ * @param options The output file, threads, reported aggregates, deduplication and logger.
+ * @param info Receives the number of cycles found, the SCC statistics and the runtimes.
+ */
+void temporalCycles(Graph G, uint64_t window, size_t maxLength, const SearchOptions *options, LogInfo_t *info) {
+    info->cyclesFound = 0;
+    if (G->vertexAmount == 0) return;
+    if (!G->timestamps) {
+        fprintf(stderr, "ERROR: the temporal search needs a timestamp column in the input\n");
         return;
     }
 
-    for (size_t i = 0; i < G->vertexAmount; i++) {
-        mpz_init(valuesPath[i]);
+    scc_partition_t *scc = partitionSCCs(G, info);
+    if (!scc) return;
+
+    size_t workers = searchWorkers(options->threads, scc->vertices);
+    size_t setSize = scc->largest ? scc->largest : 1;
+    CycleOutput out = {NULL, options->logger, options->stats, options->binary, cycleAddresses(G, options), G->globalIds, NULL};
+    int *localIndex = malloc(G->vertexAmount * sizeof(int));
+    DFSState *states = calloc(workers, sizeof(DFSState));
+    CycleBuffer *buffers = createCycleBuffers(&out, workers);
+    work_pool_t *pool = work_pool_create(workers);
+
+    bool ok = localIndex && states && buffers && pool && trackDuplicates(G, options, &out) == 0;
+    for (size_t t = 0; ok && t < workers; t++) {
+        states[t].stackPos = malloc(setSize * sizeof(int));
+        states[t].frames = malloc(setSize * sizeof(DFSFrame));
+        int pathStatus = path_stats_init(&states[t].path, setSize, options->stats);
+        states[t].component = scc->component;
+        states[t].output = &buffers[t];
+        ok = states[t].stackPos && states[t].frames && pathStatus == 0;
+        for (size_t i = 0; ok && i < setSize; i++) states[t].stackPos[i] = -1;
+    }
+    for (size_t i = scc->vertices; ok && i-- > 0;) {
+        ok = work_pool_push(pool, i % workers, (work_item_t){i, 0}) == 0;
+    }
+    if (!ok) {
+        fprintf(stderr, "ERROR: bad alloc for temporal search arrays\n");
+        goto cleanup;
     }
 
-    *total_cycles_found = 0;
-    for (size_t v = 0; v < G->vertexAmount; v++) {
-        if (!visited[v]) {
-            recursiveDFS(G, visited, recStack, path, valuesPath, &depth, v, p, logger, total_cycles_found);
+    out.file = fopen(options->filename, "w");
+    if (out.file == NULL) {
+        perror("ERROR: creating/opening output file");
+        goto cleanup;
+    }
+
+    for (size_t c = 0; c < scc->count; c++) {
+        for (size_t i = scc->offsets[c]; i < scc->offsets[c + 1]; i++) {
+            localIndex[scc->members[i]] = (int)(i - scc->offsets[c]);
         }
     }
 
-    // Cleanup
-    free(visited);
-    free(recStack);
-    free(path);
-    for (size_t i = 0; i < G->vertexAmount; i++) {
-        mpz_clear(valuesPath[i]);
+    TemporalRun run = {G, scc, window, maxLength, localIndex, states};
+    runSearch(pool, temporalTask, &run, buffers, info);
+
+cleanup:
+    for (size_t t = 0; states && t < workers; t++) {
+        free(states[t].stackPos);
+        free(states[t].frames);
+        path_stats_destroy(&states[t].path);
+    }
+    free(states);
+    freeCycleBuffers(buffers, workers);
+    free(localIndex);
+    work_pool_free(pool);
+    scc_partition_free(scc);
+    if (out.file) fclose(out.file);
+    cycle_set_free(out.seen);
+}
+
+/**
+ * @brief Logs the run statistics gathered in a LogInfo_t.
+ * @param info The statistics.
+ * @param logger The logging function to use.
+ */
+void logRunInfo(const LogInfo_t *info, log_function_t logger) {
+    logger("Algorithm: %s\n", info->algorithmUsed);
+    logger("Runtime to find SCCs: %lf seconds\n", info->runtimeSCC);
+    logger("Cyclic SCCs: %zu (%zu vertices, %zu edges, largest %zu)\n",
+           info->sccCount, info->sccVertices, info->sccEdges, info->sccLargest);
+    logger("Acyclic singleton SCCs skipped: %zu\n", info->sccDiscarded);
+    for (int i = 0; i < LOG_SCC_BUCKETS; i++) {
+        if (info->sccSizeHistogram[i] == 0) continue;
+        logger("  SCCs of size %zu..%zu: %zu\n", (size_t)1 << i, ((size_t)2 << i) - 1, info->sccSizeHistogram[i]);
     }
-    free(valuesPath);
-    fclose(p);
+    logger("Runtime to detect cycles: %f seconds\n", info->runtimeAlgorithm);
+    logger("Total cycles found: %zu\n", info->cyclesFound);
+    if (info->cyclesDuplicate > 0) logger("Duplicate cycles dropped: %zu\n", info->cyclesDuplicate);
 }
 
 
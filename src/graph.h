@@ -2,20 +2,23 @@
  * @file graph.h
  * @brief Defines graph data structures and related function prototypes.
  *
- * This file contains definitions for the graph, transactions, vertex map (hash table),
+ * This file contains definitions for the graph, transactions and logging metrics,
  * and the function signatures for graph manipulation, cycle detection, and data loading.
  */
 
 #ifndef CF34E36C_803A_4D30_AC71_0842482F2317
 #define CF34E36C_803A_4D30_AC71_0842482F2317
 
-#include <gmp.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 
-#include "uthash.h"
+#include "address.h"
+#include "address_map.h"
+#include "input_reader.h"
+#include "uint256.h"
 #include "wei_parser.h" // Assumed to exist for parse_wei_ctx_t
 
 // --- TYPE DEFINITIONS ---
@@ -25,35 +28,96 @@
  */
 typedef int vertex;
 
-/**
- * @struct VertexMap
- * @brief A hash map entry that maps a string key (wallet address) to an integer index.
- * Uses uthash for the hash table implementation.
+/** @def GRAPH_INITIAL_EDGE_CAPACITY
+ *  @brief Initial size of the edge buffer of a graph in build mode.
+ */
+#define GRAPH_INITIAL_EDGE_CAPACITY 1024
+
+/** @def LOAD_SHARD_BITS
+ *  @brief log2 of the number of lock-protected address map shards used by the parallel loader.
+ */
+#define LOAD_SHARD_BITS 6
+
+/** @def LOAD_SHARDS
+ *  @brief Number of address map shards used by the parallel loader.
+ */
+#define LOAD_SHARDS (1u << LOAD_SHARD_BITS)
+
+/** @def PARALLEL_LOAD_MIN_CHUNK
+ *  @brief Smallest input chunk (in bytes) worth handing to its own loader thread.
  */
-typedef struct vertex_map {
-    char key[43];      /**< The string key (wallet address). */
-    size_t index;      /**< The integer index corresponding to the key. */
-    UT_hash_handle hh; /**< Handle for uthash. */
-} VertexMap;
+#define PARALLEL_LOAD_MIN_CHUNK (4u << 20)
+
+/** @def BYTES_PER_WALLET_ESTIMATE
+ *  @brief Input bytes per distinct wallet assumed when pre-sizing the address map.
+ *
+ * A line is about 110 bytes and real dumps have roughly one new wallet per line.
+ */
+#define BYTES_PER_WALLET_ESTIMATE 110
 
 /**
  * @struct Transaction
- * @brief A node in the adjacency list, representing a directed edge in the graph.
+ * @brief A directed edge waiting in the edge buffer of a graph in build mode.
  */
 typedef struct transaction {
+    vertex source;               /**< The source vertex of the transaction. */
     vertex destination;          /**< The destination vertex of the transaction. */
-    mpz_t transactionValue;      /**< The value of the transaction (using GMP for large numbers). */
-    struct transaction *next;    /**< Pointer to the next transaction in the list. */
+    uint256_t transactionValue;  /**< The value of the transaction, in Wei. */
+    uint64_t timestamp;          /**< Block number or timestamp of the transaction; 0 if the input has none. */
 } Transaction;
 
 /**
  * @struct GraphDS
- * @brief The main graph data structure using an adjacency list.
+ * @brief The main graph data structure, in compressed sparse row (CSR) form.
+ *
+ * A graph starts in build mode: insertEdge() appends to the `pending` buffer.
+ * buildCSR() then lays the edges out so that the out-edges of vertex v are the
+ * contiguous range `[offsets[v], offsets[v + 1])` of `destinations` and `values`,
+ * and every traversal streams neighbors sequentially. After that the graph is
+ * immutable.
+ *
+ * If the input carried a timestamp column, `timestamps` holds it per edge and
+ * the out-edges of each vertex are sorted by it, so the edges usable after a
+ * given time are a suffix of the range, found by binary search.
+ *
+ * After collapseParallelEdges(), each edge stands for every transaction
+ * between its two endpoints (at the same timestamp, if the graph has them):
+ * `values` holds the largest of their values, and `edgeCounts`, `valueSums`
+ * and `valueMins` the rest of the aggregate.
+ *
+ * The loaders fill `addresses` as they number the wallets, so a vertex id maps
+ * back to its wallet in O(1) once the address map is gone.
+ *
+ * A graph reopened from a snapshot (snapshot.h) does not own its arrays: they
+ * point into the read-only `mapping`, which freeGraph() unmaps. The reverse
+ * CSR is always owned. Anything that rewrites the arrays, such as
+ * collapseParallelEdges(), first copies them into owned memory.
+ *
+ * A region extracted around appended transactions (extractAppendedRegion())
+ * is a graph of its own with local ids: `globalIds` maps them back, and
+ * `freshEdges` marks the edges that arrived in this run, so that the searches
+ * only report the cycles that go through one of them.
  */
 typedef struct {
     size_t vertexAmount;         /**< The number of vertices in the graph. */
     size_t edgesAmount;          /**< The number of edges in the graph. */
-    Transaction **adjList;       /**< An array of pointers to Transaction lists (the adjacency list). */
+    Transaction *pending;        /**< Edge buffer in build mode; NULL once the CSR is built. */
+    size_t pendingCapacity;      /**< The number of allocated slots in pending. */
+    size_t *offsets;             /**< CSR row offsets, vertexAmount + 1 entries. */
+    vertex *destinations;        /**< CSR destination of each edge. */
+    uint256_t *values;           /**< CSR value of each edge, inline 256-bit Wei amounts. */
+    uint64_t *timestamps;        /**< CSR timestamp of each edge, or NULL if the input has none. */
+    bool hasTimestamps;          /**< True once an edge with a timestamp was inserted. */
+    uint32_t *edgeCounts;        /**< Transactions merged into each edge, or NULL if parallel edges were not collapsed. */
+    uint256_t *valueSums;        /**< Sum of the merged values (saturating at 2^256 - 1), or NULL. */
+    uint256_t *valueMins;        /**< Smallest of the merged values, or NULL. */
+    address_t *addresses;        /**< Wallet address of each vertex, indexed by vertex id, or NULL if unknown. */
+    size_t *inOffsets;           /**< Reverse CSR row offsets, or NULL until buildReverseCSR(). */
+    vertex *inSources;           /**< Reverse CSR source of each in-edge, or NULL until buildReverseCSR(). */
+    void *mapping;               /**< The read-only snapshot the arrays above point into, or NULL if the graph owns them. */
+    size_t mappingSize;          /**< The size of mapping in bytes. */
+    vertex *globalIds;           /**< Id of each vertex in the graph the region was extracted from, or NULL. */
+    unsigned char *freshEdges;   /**< Per edge: non-zero if it arrived in this run, or NULL to report every cycle. */
 } GraphDS;
 
 /** @typedef Graph
@@ -61,12 +125,45 @@ typedef struct {
  */
 typedef GraphDS *Graph;
 
+/**
+ * @struct GraphDelta
+ * @brief Transactions appended to a built graph without laying its CSR out again.
+ *
+ * Wallets not in the graph get the ids after its vertices, in order of first
+ * appearance, and edges are kept in arrival order. The part already stored in
+ * the snapshot (see snapshot_append()) was searched in an earlier run; the
+ * rest arrived in this one. Wallets of the graph itself are found through the
+ * read-only address index stored in the snapshot.
+ */
+typedef struct {
+    size_t vertexAmount;         /**< Wallets added; their ids start at the graph's vertexAmount. */
+    size_t vertexCapacity;       /**< The allocated size of addresses. */
+    address_t *addresses;        /**< Wallet of each added vertex. */
+    address_map_t *map;          /**< Position of each added wallet in addresses, or NULL until needed. */
+    size_t edgesAmount;          /**< Edges appended. */
+    size_t edgeCapacity;         /**< The allocated size of the edge arrays. */
+    vertex *sources;             /**< Source of each appended edge. */
+    vertex *destinations;        /**< Destination of each appended edge. */
+    uint256_t *values;           /**< Value of each appended edge. */
+    uint64_t *timestamps;        /**< Timestamp of each appended edge, or NULL if the graph has none. */
+    size_t savedVertices;        /**< Added wallets already stored in the snapshot. */
+    size_t savedEdges;           /**< Appended edges already stored in the snapshot; the rest are fresh. */
+    const uint32_t *index;       /**< address_index_build() index of the graph's addresses, or NULL. */
+    size_t indexCapacity;        /**< The number of slots of index. */
+} GraphDelta;
+
 
 /** @typedef log_function_t
  *  @brief A function pointer type for logging messages.
  */
 typedef void (*log_function_t)(const char *, ...);
 
+/**
+ * @def LOG_SCC_BUCKETS
+ * @brief Number of power-of-two buckets in the SCC size distribution of LogInfo_t.
+ */
+#define LOG_SCC_BUCKETS 32
+
 /**
  * @struct LogInfo_t
  * @brief A struct to hold logging and performance metrics.
@@ -75,61 +172,78 @@ typedef struct {
     size_t walletsAmount;
     size_t transactionAmount;
     size_t cyclesFound;
+    size_t cyclesDuplicate;      /**< Cycles dropped because the same vertex cycle was already reported. */
     double runtimeFillHashmap;
     double runtimeAlgorithm;
     double runtimeCreateGraph;
     char algorithmUsed[64];
     const char *outputFileName;
+    size_t sccCount;             /**< Number of SCCs handed to the cycle finder. */
+    size_t sccVertices;          /**< Vertices inside those SCCs. */
+    size_t sccEdges;             /**< Edges with both endpoints in the same one of those SCCs. */
+    size_t sccLargest;           /**< Size of the largest SCC. */
+    size_t sccDiscarded;         /**< Singleton SCCs without a self-loop, skipped. */
+    size_t sccSizeHistogram[LOG_SCC_BUCKETS]; /**< sccSizeHistogram[i] counts SCCs with 2^i <= size < 2^(i+1). */
+    double runtimeSCC;           /**< Seconds spent computing the SCCs. */
 } LogInfo_t;
 
-
-// --- GLOBAL VARIABLES ---
-
-/** @var vertex_map
- *  @brief Global pointer to the head of the vertex hash map.
- */
-extern VertexMap *vertex_map;
-
-// --- HASHMAP FUNCTIONS ---
-
 /**
- * @brief Adds all unique vertices from a file to the hash map.
- * @param file Pointer to the input file containing transactions.
- * @return The total number of unique vertices (wallets) found.
+ * @struct SearchOptions
+ * @brief How a cycle search runs and reports what it finds.
  */
-size_t addAllVertexToHashmap(FILE *file);
+typedef struct {
+    const char *filename;        /**< The name of the file to write cycle information to. */
+    size_t threads;              /**< The number of search threads. */
+    unsigned stats;              /**< The aggregates to report per cycle, CYCLE_STAT_* flags (cycle_stats.h). */
+    bool dedup;                  /**< Report each vertex cycle once, however many parallel edges go around it. */
+    bool binary;                 /**< Write the binary format of cycle_file.h instead of text. */
+    bool addresses;              /**< Write checksummed wallet addresses instead of vertex ids, in text output. */
+    log_function_t logger;       /**< The logging function to use (log_verbose or log_silent). */
+} SearchOptions;
 
-/**
- * @brief Retrieves the integer index for a given vertex name (wallet address).
- * @param name The string key (wallet address) to look up.
- * @return The index of the vertex.
- */
-size_t getVertexIndex(const char *name);
-
-/**
- * @brief Frees all memory allocated for the vertex hash map.
- */
-void freeVertexMap();
 
 // --- GRAPH LOADER FUNCTIONS ---
 
 /**
  * @brief Loads a graph from a file.
  *
- * This function first populates a hash map with all vertices, then initializes
- * a graph of the appropriate size, and finally populates the graph with edges.
- * It uses the provided logger to report progress.
+ * The input is read in a single pass: both endpoints of each transaction are
+ * interned into an address map and the edge is inserted, growing the vertex table
+ * as new wallets appear. The file is never rewound, so non-seekable inputs
+ * (pipes) are supported. Regular files are split into newline-aligned chunks
+ * parsed concurrently by up to `threads` threads; vertex numbering is the same
+ * as for a sequential load. It uses the provided logger to report progress.
+ *
+ * Each line is `from to value`, optionally followed by a block number or
+ * timestamp (decimal). If any line has one, the graph keeps them; lines
+ * without one get timestamp 0.
  *
  * @param file A pointer to the opened input file.
+ * @param threads The maximum number of loader threads.
  * @param logger The logging function to use (log_verbose or log_silent).
  * @return An initialized and populated graph.
  */
-Graph loadGraph(FILE *file, log_function_t logger);
+Graph loadGraph(FILE *file, size_t threads, log_function_t logger);
+
+/**
+ * @brief Appends the transactions of a file to the delta of a built graph.
+ *
+ * The input formats are those of loadGraph(). Only wallets that are neither
+ * in the graph nor in the delta are interned, so the cost follows the size of
+ * the file, not of the graph. Timestamps are kept if the graph has them.
+ *
+ * @param G The graph, with its CSR and addresses.
+ * @param delta The delta; needs the address index of the graph.
+ * @param file The opened input file.
+ * @param logger The logging function to use (log_verbose or log_silent).
+ * @return The number of transactions appended.
+ */
+size_t loadGraphDelta(Graph G, GraphDelta *delta, FILE *file, log_function_t logger);
 
 // --- GRAPH MANIPULATION FUNCTIONS ---
 
 /**
- * @brief Initializes a graph with V vertices and empty adjacency lists.
+ * @brief Initializes a graph with V vertices and no edges, in build mode.
  * @param V The number of vertices for the graph.
  * @return A pointer to the newly allocated and initialized graph.
  */
@@ -137,13 +251,105 @@ Graph initGraph(size_t V);
 
 /**
  * @brief Inserts a directed edge from vertex v to vertex w with a given value.
+ *
+ * Only valid in build mode, before buildCSR(). The timestamp is only kept if
+ * G->hasTimestamps is set before buildCSR().
+ *
  * @param G The graph.
  * @param v The source vertex.
  * @param w The destination vertex.
  * @param value The value of the transaction (edge weight).
+ * @param timestamp The block number or timestamp of the transaction.
  * @return 1 on success, 0 on failure.
  */
-int insertEdge(Graph G, vertex v, vertex w, const mpz_t value);
+int insertEdge(Graph G, vertex v, vertex w, const uint256_t *value, uint64_t timestamp);
+
+/**
+ * @brief Freezes the graph into its CSR representation.
+ *
+ * Builds `offsets`, `destinations` and `values` from the edge buffer with a
+ * counting pass and releases the buffer. Edges of a vertex keep their insertion
+ * order; if the graph has timestamps, they are then stably sorted by timestamp.
+ * Calling it on a graph already built does nothing.
+ *
+ * @param G The graph.
+ */
+void buildCSR(Graph G);
+
+/**
+ * @brief Builds the reverse CSR: the in-edges of v are the sources
+ * `inSources[inOffsets[v] .. inOffsets[v + 1])`.
+ *
+ * Needed by the searches that walk edges backwards. Calling it again does
+ * nothing. The forward CSR must be built.
+ *
+ * @param G The graph.
+ */
+void buildReverseCSR(Graph G);
+
+/**
+ * @brief Merges the parallel edges of the graph, i.e. the edges with the same endpoints (and the same
+ * timestamp, if the graph has them), into one edge each.
+ *
+ * The merged edge keeps the position of the first of its edges and carries the
+ * count, sum, minimum and maximum (in `values`) of their values. Repeated
+ * transfers between the same pair otherwise multiply the edges to scan and
+ * the cycles to report. Runs in O(V + E). The reverse CSR, if built, is
+ * dropped and rebuilt on demand. On a graph already collapsed, edges added
+ * since (see mergeGraphDelta()) are merged into the existing aggregates.
+ *
+ * @param G The graph. Its CSR must be built.
+ * @return The number of edges removed, or 0 if there were no parallel edges.
+ */
+size_t collapseParallelEdges(Graph G);
+
+/**
+ * @brief Extracts the part of the graph where the fresh edges of a delta can close a cycle.
+ *
+ * A cycle through a fresh edge u -> v goes from v back to u, so it stays in
+ * Fwd(v) ∩ Bwd(u). The region is Fwd(fresh destinations) ∩ Bwd(fresh sources)
+ * over the graph and the whole delta, the backward pass only walking the
+ * forward set; with maxLength, both passes stop at depth maxLength - 1. Only
+ * the region is visited, never the whole graph, and the search that follows
+ * computes the SCCs of the region alone.
+ *
+ * The region has local ids (in the order of the global ones) with globalIds,
+ * its addresses, freshEdges, and the same timestamps and aggregates as the
+ * graph; appended edges stand for one transaction each.
+ *
+ * @param G The graph.
+ * @param delta The delta; its edges from savedEdges on are fresh.
+ * @param maxLength The longest cycle that will be searched, or 0 for no limit.
+ * @param logger The logging function to use.
+ * @return The region, built.
+ */
+Graph extractAppendedRegion(Graph G, const GraphDelta *delta, size_t maxLength, log_function_t logger);
+
+/**
+ * @brief Folds a delta into the CSR of the graph and empties it.
+ *
+ * The result is the graph a full load of the same transactions would give,
+ * with its arrays owned. If the graph's parallel edges were collapsed, the
+ * appended ones are collapsed into them.
+ *
+ * @param G The graph.
+ * @param delta The delta.
+ */
+void mergeGraphDelta(Graph G, GraphDelta *delta);
+
+/**
+ * @brief Frees the arrays of a delta, leaving it empty.
+ * @param delta The delta.
+ */
+void freeGraphDelta(GraphDelta *delta);
+
+/**
+ * @brief Returns the number of transactions an edge stands for.
+ * @param G The graph.
+ * @param e The CSR index of the edge.
+ * @return edgeCounts[e] if parallel edges were collapsed, 1 otherwise.
+ */
+size_t edgeMultiplicity(Graph G, size_t e);
 
 /**
  * @brief Frees all memory associated with the graph.
@@ -152,21 +358,92 @@ int insertEdge(Graph G, vertex v, vertex w, const mpz_t value);
 void freeGraph(Graph G);
 
 /**
- * @brief Displays the graph's adjacency list representation.
+ * @brief Displays the graph's adjacency list representation. The CSR must be built.
  * @param G The graph to display.
  */
 void showGraph(Graph G);
 
-// --- CYCLE DETECTION (DFS) FUNCTIONS ---
+// --- CYCLE DETECTION FUNCTIONS ---
 
 /**
  * @brief The main function to perform Depth First Search and find cycles.
+ *
+ * The strongly connected components are computed first; the search then runs
+ * once per non-trivial SCC, from its smallest vertex, and ignores edges that
+ * leave the component. SCCs are searched in parallel, one task per SCC.
+ *
+ * With more than one thread, cycles are numbered in the order they reach the
+ * output file, which depends on scheduling; the set of cycles does not. With
+ * options->dedup, a vertex cycle found again through parallel edges is
+ * dropped.
+ *
+ * @param G The graph to search.
+ * @param options The output file, threads, reported aggregates, deduplication and logger.
+ * @param info Receives the number of cycles found, the SCC statistics and the runtimes.
+ */
+void depthFirstSearch(Graph G, const SearchOptions *options, LogInfo_t *info);
+
+/**
+ * @brief Enumerates every elementary cycle of the graph with Johnson's algorithm.
+ *
+ * Unlike depthFirstSearch(), which only reports one cycle per back edge of its
+ * search tree, this reports every elementary cycle exactly once, in the same
+ * output format. Transactions between the same two wallets are distinct edges,
+ * so cycles that differ only in which of them they use are all found; with
+ * options->dedup only the first of them is reported. Runs in
+ * O((V + E)(C + 1)) for C cycles. Subproblems (an SCC minus the start vertices
+ * already done) are spread over the threads with work stealing.
+ *
+ * @param G The graph to search.
+ * @param options The output file, threads, reported aggregates, deduplication and logger.
+ * @param info Receives the number of cycles found, the SCC statistics and the runtimes.
+ */
+void johnsonCycles(Graph G, const SearchOptions *options, LogInfo_t *info);
+
+/**
+ * @brief Enumerates every elementary cycle of at most maxLength edges.
+ *
+ * Like johnsonCycles(), each cycle is reported once, from its smallest vertex
+ * s. Before searching from s, a reverse BFS computes how far each vertex is from
+ * s, so a branch is never extended once it can no longer close within the
+ * remaining budget. The work is proportional to the short cycles and the paths
+ * that lead back to s, not to all cycles. Each start vertex is a separate task.
+ *
  * @param G The graph to search.
- * @param filename The name of the file to write cycle information to.
+ * @param maxLength The longest cycle to report, in edges (a self-loop has length 1).
+ * @param options The output file, threads, reported aggregates, deduplication and logger.
+ * @param info Receives the number of cycles found, the SCC statistics and the runtimes.
+ */
+void boundedCycles(Graph G, size_t maxLength, const SearchOptions *options, LogInfo_t *info);
+
+/**
+ * @brief Enumerates every time-respecting elementary cycle that fits in a time window.
+ *
+ * A cycle is time-respecting if, from its start vertex, the timestamps of its
+ * edges never decrease, so the funds could actually have gone around it. Its
+ * last edge may be at most `window` after its first. Each cycle is reported
+ * once, starting at the vertex its time order starts from (or its smallest
+ * vertex, if all its edges share one timestamp). The edges of each vertex are
+ * kept sorted by time, so the search jumps to the first usable edge by binary
+ * search and stops scanning at the end of the window. With options->dedup,
+ * only the first copy of a vertex cycle is reported, even if the copies use
+ * transactions at different times; with several threads, which copy comes
+ * first depends on scheduling, since copies may start at different vertices.
+ *
+ * @param G The graph to search. It must have been loaded with a timestamp column.
+ * @param window The largest time span of a cycle, in the unit of the timestamps.
+ * @param maxLength The longest cycle to report, in edges, or 0 for no limit.
+ * @param options The output file, threads, reported aggregates, deduplication and logger.
+ * @param info Receives the number of cycles found, the SCC statistics and the runtimes.
+ */
+void temporalCycles(Graph G, uint64_t window, size_t maxLength, const SearchOptions *options, LogInfo_t *info);
+
+/**
+ * @brief Logs the run statistics gathered in a LogInfo_t.
+ * @param info The statistics.
  * @param logger The logging function to use (log_verbose or log_silent).
- * @param total_cycles_found A pointer to a size_t to store the count of found cycles.
  */
-void depthFirstSearch(Graph G, const char *const filename, log_function_t logger, size_t *total_cycles_found);
+void logRunInfo(const LogInfo_t *info, log_function_t logger);
 
 // --- LOGGING FUNCTIONS ---
 
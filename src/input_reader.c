@@ -0,0 +1,458 @@
+/**
+ * @file input_reader.c
+ * @brief Implementation of the zero-copy line reader.
+ * @defgroup input_reader Input Reader
+ * @{
+ */
+
+#include "input_reader.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "block_queue.h"
+
+/**
+ * @struct gzip_source_t
+ * @brief The decompression side of a reader over gzip-compressed input.
+ *
+ * A dedicated thread read()s the compressed bytes, inflates them into blocks
+ * of the queue and hands each block over once it ends on a newline; the bytes
+ * after the last newline start the next block. The reader then walks each
+ * block in place, so lines never straddle two blocks and are not copied.
+ */
+typedef struct {
+    z_stream stream;             /**< The zlib inflater. Decompression thread only. */
+    int fd;                      /**< The descriptor of the compressed input. */
+    unsigned char *in;           /**< The buffer of compressed bytes. */
+    block_queue_t *queue;        /**< Carries the decompressed blocks to the reader. */
+    pthread_t thread;            /**< The decompression thread. */
+    int stop;                    /**< Set when the reader is closed early; accessed atomically. */
+    int failed;                  /**< Set before the queue is closed if the input is unreadable or corrupt. */
+} gzip_source_t;
+
+/**
+ * @struct input_reader_t
+ * @brief The internal structure of the input reader.
+ */
+struct input_reader_t {
+    /** @var fd The descriptor being read. */
+    int fd;
+    /** @var mapped True when data points to a memory mapping of the whole file. */
+    bool mapped;
+    /** @var borrowed True when data belongs to someone else and must not be released. */
+    bool borrowed;
+    /** @var eof True once read() reported end of input. */
+    bool eof;
+    /** @var data The mapped file or the read() buffer. */
+    char *data;
+    /** @var size The number of valid bytes in data. */
+    size_t size;
+    /** @var capacity The allocated size of the read() buffer. */
+    size_t capacity;
+    /** @var pos The offset of the next unread byte in data. */
+    size_t pos;
+    /** @var gzip The decompression thread when the input is gzip-compressed, or NULL. */
+    gzip_source_t *gzip;
+    /** @var block The decompressed block that data points into, in gzip mode. */
+    queue_block_t *block;
+};
+
+static ssize_t refill(input_reader_t *reader);
+static int start_gzip(input_reader_t *reader);
+
+/**
+ * @brief Creates a reader over an open file descriptor.
+ * @param fd The file descriptor to read from.
+ * @return A pointer to the reader, or NULL on failure.
+ */
+input_reader_t *input_reader_open(int fd) {
+    input_reader_t *reader = calloc(1, sizeof(input_reader_t));
+    if (!reader) return NULL;
+    reader->fd = fd;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        if (st.st_size == 0) {
+            // Nothing to map; behave like an exhausted mapping.
+            reader->mapped = true;
+            return reader;
+        }
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            const unsigned char *bytes = map;
+            if (st.st_size < 2 || bytes[0] != 0x1f || bytes[1] != 0x8b) {
+                madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+                reader->mapped = true;
+                reader->data = map;
+                reader->size = (size_t)st.st_size;
+                return reader;
+            }
+            // Compressed: the mapping is of no use, stream it instead.
+            munmap(map, (size_t)st.st_size);
+        }
+    }
+
+    // Fallback for pipes and anything else mmap refuses.
+    reader->capacity = INPUT_READER_BLOCK_SIZE;
+    reader->data = malloc(reader->capacity);
+    if (!reader->data) {
+        free(reader);
+        return NULL;
+    }
+
+    // Peek at the first bytes for the gzip magic.
+    while (reader->size < 2 && !reader->eof) {
+        if (refill(reader) < 0) return reader; // Reported by input_reader_next_line().
+    }
+    const unsigned char *bytes = (const unsigned char *)reader->data;
+    if (reader->size >= 2 && bytes[0] == 0x1f && bytes[1] == 0x8b && start_gzip(reader) != 0) {
+        input_reader_close(reader);
+        return NULL;
+    }
+    return reader;
+}
+
+/**
+ * @brief Creates a reader over a range of memory that stays owned by the caller.
+ * @param begin The first byte of the range.
+ * @param end One past the last byte of the range.
+ * @return A pointer to the reader, or NULL on allocation failure.
+ */
+input_reader_t *input_reader_slice(const char *begin, const char *end) {
+    input_reader_t *reader = calloc(1, sizeof(input_reader_t));
+    if (!reader) return NULL;
+    reader->fd = -1;
+    reader->mapped = true;
+    reader->borrowed = true;
+    reader->data = (char *)begin;
+    reader->size = (size_t)(end - begin);
+    return reader;
+}
+
+/**
+ * @brief Returns the whole input when it is memory-mapped.
+ * @param reader The reader.
+ * @param size Receives the size of the input in bytes.
+ * @return The first byte of the mapping, or NULL if the input is streamed or compressed.
+ */
+const char *input_reader_data(const input_reader_t *reader, size_t *size) {
+    *size = reader->mapped ? reader->size : 0;
+    return reader->mapped ? reader->data : NULL;
+}
+
+/**
+ * @brief Releases the mapping or buffer held by the reader.
+ * @param reader The reader to be freed.
+ */
+void input_reader_close(input_reader_t *reader) {
+    if (!reader) return;
+
+    if (reader->gzip) {
+        gzip_source_t *gzip = reader->gzip;
+        if (reader->block) block_queue_release(gzip->queue, reader->block);
+        if (!reader->eof) {
+            // Closed early: let the thread see the flag and run out of blocks to fill.
+            __atomic_store_n(&gzip->stop, 1, __ATOMIC_RELEASE);
+            for (queue_block_t *block; (block = block_queue_pop(gzip->queue)) != NULL;) {
+                block_queue_release(gzip->queue, block);
+            }
+        }
+        pthread_join(gzip->thread, NULL);
+        inflateEnd(&gzip->stream);
+        block_queue_free(gzip->queue);
+        free(gzip->in);
+        free(gzip);
+    } else if (reader->borrowed) {
+        // The caller owns the memory.
+    } else if (reader->mapped) {
+        if (reader->data) munmap(reader->data, reader->size);
+    } else {
+        free(reader->data);
+    }
+    free(reader);
+}
+
+/**
+ * @brief Refills the read() buffer, keeping the unread tail at its front.
+ * @param reader The reader, in read() mode.
+ * @return The number of bytes added, 0 at end of input, -1 on error.
+ */
+static ssize_t refill(input_reader_t *reader) {
+    size_t pending = reader->size - reader->pos;
+    memmove(reader->data, reader->data + reader->pos, pending);
+    reader->size = pending;
+    reader->pos = 0;
+
+    // A single line larger than the buffer: grow instead of failing.
+    if (reader->size == reader->capacity) {
+        size_t capacity = reader->capacity * 2;
+        char *data = realloc(reader->data, capacity);
+        if (!data) return -1;
+        reader->data = data;
+        reader->capacity = capacity;
+    }
+
+    ssize_t n;
+    do {
+        n = read(reader->fd, reader->data + reader->size, reader->capacity - reader->size);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) return -1;
+    if (n == 0) reader->eof = true;
+    reader->size += (size_t)n;
+    return n;
+}
+
+/**
+ * @brief Hands a filled block to the reader, keeping the bytes after its last newline for the next one.
+ *
+ * A block with no newline at all is moved to one twice as large instead, so a
+ * line longer than a block is never cut.
+ *
+ * @param gzip The decompression side.
+ * @param block The full block; replaced by the block to fill next.
+ * @return 0 on success, -1 if a block could not be allocated.
+ */
+static int hand_over(gzip_source_t *gzip, queue_block_t **block) {
+    queue_block_t *full = *block;
+    size_t end = full->size;
+    while (end > 0 && full->data[end - 1] != '\n') end--;
+
+    size_t tail = full->size - end;
+    size_t need = end ? 2 * tail : 2 * full->capacity;
+    if (need < INPUT_READER_BLOCK_SIZE) need = INPUT_READER_BLOCK_SIZE;
+    queue_block_t *next = block_queue_acquire(gzip->queue, need);
+    if (!next) return -1;
+    memcpy(next->data, full->data + end, tail);
+    next->size = tail;
+    if (end) {
+        full->size = end;
+        block_queue_push(gzip->queue, full);
+    } else {
+        block_queue_release(gzip->queue, full);
+    }
+    *block = next;
+    return 0;
+}
+
+/**
+ * @brief Thread entry point: inflates the compressed input into blocks of the queue.
+ *
+ * Concatenated gzip members, as written by `cat a.gz b.gz` or pigz, are read
+ * one after the other.
+ *
+ * @param arg The gzip_source_t of the reader.
+ * @return NULL.
+ */
+static void *inflate_input(void *arg) {
+    gzip_source_t *gzip = arg;
+    z_stream *stream = &gzip->stream;
+    const char *error = NULL;
+    int status = Z_OK;
+
+    queue_block_t *block = block_queue_acquire(gzip->queue, INPUT_READER_BLOCK_SIZE);
+    if (!block) error = "out of memory";
+    while (!error && !__atomic_load_n(&gzip->stop, __ATOMIC_ACQUIRE)) {
+        if (stream->avail_in == 0) {
+            ssize_t n;
+            do {
+                n = read(gzip->fd, gzip->in, INPUT_READER_BLOCK_SIZE);
+            } while (n < 0 && errno == EINTR);
+            if (n < 0) {
+                error = strerror(errno);
+                break;
+            }
+            if (n == 0) {
+                if (status != Z_STREAM_END) error = "unexpected end of compressed data";
+                break;
+            }
+            stream->next_in = gzip->in;
+            stream->avail_in = (uInt)n;
+        }
+        if (status == Z_STREAM_END) {
+            inflateReset(stream); // Another member follows.
+        }
+
+        stream->next_out = (Bytef *)block->data + block->size;
+        stream->avail_out = (uInt)(block->capacity - block->size);
+        status = inflate(stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+            error = stream->msg ? stream->msg : "corrupt compressed data";
+            break;
+        }
+        block->size = block->capacity - stream->avail_out;
+        if (block->size == block->capacity && hand_over(gzip, &block) != 0) error = "out of memory";
+    }
+
+    if (error) {
+        fprintf(stderr, "Error: decompressing the input: %s\n", error);
+        gzip->failed = 1;
+    }
+    if (block) {
+        if (block->size && !error) {
+            block_queue_push(gzip->queue, block);
+        } else {
+            block_queue_release(gzip->queue, block);
+        }
+    }
+    block_queue_close(gzip->queue);
+    return NULL;
+}
+
+/**
+ * @brief Switches a streaming reader to gzip mode and starts the decompression thread.
+ *
+ * The bytes already read while peeking at the magic are the first input of the inflater.
+ *
+ * @param reader The reader, in read() mode, holding the first bytes of the input.
+ * @return 0 on success, -1 on failure.
+ */
+static int start_gzip(input_reader_t *reader) {
+    gzip_source_t *gzip = calloc(1, sizeof(gzip_source_t));
+    if (!gzip) return -1;
+    gzip->fd = reader->fd;
+    gzip->in = malloc(INPUT_READER_BLOCK_SIZE);
+    // One block for the reader, two for the thread while it moves a tail, the rest in flight.
+    gzip->queue = block_queue_create(INPUT_READER_BLOCK_SIZE, INPUT_READER_GZIP_BLOCKS);
+    // 15 + 32: the largest window, with the gzip header detected automatically.
+    if (!gzip->in || !gzip->queue || inflateInit2(&gzip->stream, 15 + 32) != Z_OK) {
+        block_queue_free(gzip->queue);
+        free(gzip->in);
+        free(gzip);
+        return -1;
+    }
+
+    memcpy(gzip->in, reader->data, reader->size);
+    gzip->stream.next_in = gzip->in;
+    gzip->stream.avail_in = (uInt)reader->size;
+    free(reader->data);
+    reader->data = NULL;
+    reader->size = 0;
+    reader->capacity = 0;
+    reader->gzip = gzip;
+
+    if (pthread_create(&gzip->thread, NULL, inflate_input, gzip) != 0) {
+        inflateEnd(&gzip->stream);
+        block_queue_free(gzip->queue);
+        free(gzip->in);
+        free(gzip);
+        reader->gzip = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Moves to the next decompressed block, returning the previous one.
+ * @param reader The reader, in gzip mode.
+ * @return The number of bytes in the new block, 0 at end of input, -1 if decompression failed.
+ */
+static ssize_t next_block(input_reader_t *reader) {
+    gzip_source_t *gzip = reader->gzip;
+    if (reader->block) block_queue_release(gzip->queue, reader->block);
+    reader->block = block_queue_pop(gzip->queue);
+    reader->pos = 0;
+    if (!reader->block) {
+        reader->data = NULL;
+        reader->size = 0;
+        reader->eof = true;
+        if (gzip->failed) {
+            errno = EIO;
+            return -1;
+        }
+        return 0;
+    }
+    reader->data = reader->block->data;
+    reader->size = reader->block->size;
+    return (ssize_t)reader->size;
+}
+
+/**
+ * @brief Returns the next line of the input, without its line terminator.
+ * @param reader The reader.
+ * @param line Receives the line.
+ * @return 1 if a line was returned, 0 at end of input, -1 on read error.
+ */
+int input_reader_next_line(input_reader_t *reader, input_token_t *line) {
+    for (;;) {
+        const char *start = reader->data + reader->pos;
+        size_t available = reader->size - reader->pos;
+        const char *nl = available ? memchr(start, '\n', available) : NULL;
+
+        // Decompressed blocks end on a newline, except possibly the last one.
+        if (nl || (available && (reader->mapped || reader->eof || reader->gzip))) {
+            size_t len = nl ? (size_t)(nl - start) : available;
+            reader->pos += nl ? len + 1 : len;
+            if (len && start[len - 1] == '\r') len--;
+            line->ptr = start;
+            line->len = len;
+            return 1;
+        }
+
+        if (reader->mapped || reader->eof) return 0;
+        if ((reader->gzip ? next_block(reader) : refill(reader)) < 0) return -1;
+    }
+}
+
+/**
+ * @brief Splits a line into whitespace-separated tokens.
+ * @param line The line to split.
+ * @param tokens Array that receives up to max_tokens tokens.
+ * @param max_tokens The capacity of tokens.
+ * @return The number of tokens in the line.
+ */
+size_t input_split_tokens(input_token_t line, input_token_t *tokens, size_t max_tokens) {
+    const char *p = line.ptr;
+    const char *end = line.ptr + line.len;
+    size_t count = 0;
+
+    for (;;) {
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (p == end) break;
+
+        const char *start = p;
+        while (p < end && *p != ' ' && *p != '\t') p++;
+
+        if (count < max_tokens) {
+            tokens[count].ptr = start;
+            tokens[count].len = (size_t)(p - start);
+        }
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Splits the first fields of a comma-separated line.
+ * @param line The line to split.
+ * @param fields Array that receives up to max_fields fields.
+ * @param max_fields The capacity of fields.
+ * @return The number of fields stored, at most max_fields.
+ */
+size_t input_split_csv(input_token_t line, input_token_t *fields, size_t max_fields) {
+    const char *p = line.ptr;
+    const char *end = line.ptr + line.len;
+    size_t count = 0;
+
+    while (count < max_fields) {
+        const char *comma = memchr(p, ',', (size_t)(end - p));
+        const char *stop = comma ? comma : end;
+        fields[count].ptr = p;
+        fields[count].len = (size_t)(stop - p);
+        count++;
+        if (!comma) break;
+        p = comma + 1;
+    }
+    return count;
+}
+
+ /** @} */
@@ -0,0 +1,124 @@
+/**
+ * @file input_reader.h
+ * @brief Defines a zero-copy line reader for transaction files.
+ *
+ * Regular files are memory-mapped and walked in place, so every line and token
+ * handed to the caller is a (pointer, length) slice into the mapping. Inputs that
+ * cannot be mapped (pipes, sockets) fall back to large buffered read() calls.
+ * In both cases no per-token copy or format-string parsing is done.
+ *
+ * Gzip-compressed input, recognised by its magic bytes, is inflated on a
+ * separate thread and handed to the reader in newline-aligned blocks through
+ * a block queue, so parsing overlaps decompression and nothing touches disk.
+ */
+
+#ifndef A61F3C9E_2B7D_4E58_9C0A_5D84E1B7F263
+#define A61F3C9E_2B7D_4E58_9C0A_5D84E1B7F263
+
+#include <stddef.h>
+
+/**
+ * @def INPUT_READER_BLOCK_SIZE
+ * @brief Size of each read() call when the input cannot be memory-mapped.
+ */
+#define INPUT_READER_BLOCK_SIZE (1 << 20)
+
+/**
+ * @def INPUT_READER_GZIP_BLOCKS
+ * @brief Most decompressed blocks of INPUT_READER_BLOCK_SIZE in memory at once for a gzip input.
+ */
+#define INPUT_READER_GZIP_BLOCKS 8
+
+/**
+ * @struct input_reader_t
+ * @brief An opaque type for the input reader.
+ *
+ * Holds either the memory mapping of the input or the buffer used by the
+ * read() fallback, plus the current position.
+ */
+typedef struct input_reader_t input_reader_t;
+
+/**
+ * @struct input_token_t
+ * @brief A slice of the input. It is not NUL-terminated.
+ */
+typedef struct {
+    const char *ptr; /**< First byte of the token. */
+    size_t len;      /**< Number of bytes in the token. */
+} input_token_t;
+
+/**
+ * @brief Creates a reader over an open file descriptor.
+ *
+ * The descriptor is memory-mapped when it refers to a regular file; otherwise
+ * it is consumed with buffered read() calls. Input starting with the gzip magic
+ * is never mapped: it is read and inflated by a thread owned by the reader.
+ * The descriptor is not closed by the reader.
+ *
+ * @param fd The file descriptor to read from.
+ * @return A pointer to the reader, or NULL on failure.
+ */
+input_reader_t *input_reader_open(int fd);
+
+/**
+ * @brief Creates a reader over a range of memory that stays owned by the caller.
+ *
+ * Used to hand newline-aligned chunks of a mapped file to worker threads, each
+ * of which walks its own chunk with the usual line API.
+ *
+ * @param begin The first byte of the range.
+ * @param end One past the last byte of the range.
+ * @return A pointer to the reader, or NULL on allocation failure.
+ */
+input_reader_t *input_reader_slice(const char *begin, const char *end);
+
+/**
+ * @brief Returns the whole input when it is memory-mapped.
+ * @param reader The reader.
+ * @param size Receives the size of the input in bytes.
+ * @return The first byte of the mapping, or NULL if the input is streamed or compressed.
+ */
+const char *input_reader_data(const input_reader_t *reader, size_t *size);
+
+/**
+ * @brief Releases the mapping or buffer held by the reader.
+ * @param reader The reader to be freed.
+ */
+void input_reader_close(input_reader_t *reader);
+
+/**
+ * @brief Returns the next line of the input, without its line terminator.
+ *
+ * The returned slice stays valid until the next call on the same reader.
+ *
+ * @param reader The reader.
+ * @param line Receives the line.
+ * @return 1 if a line was returned, 0 at end of input, -1 on read error.
+ */
+int input_reader_next_line(input_reader_t *reader, input_token_t *line);
+
+/**
+ * @brief Splits a line into whitespace-separated tokens.
+ *
+ * @param line The line to split.
+ * @param tokens Array that receives up to max_tokens tokens.
+ * @param max_tokens The capacity of tokens.
+ * @return The number of tokens in the line. It may be larger than max_tokens,
+ *         in which case only the first max_tokens were stored.
+ */
+size_t input_split_tokens(input_token_t line, input_token_t *tokens, size_t max_tokens);
+
+/**
+ * @brief Splits the first fields of a comma-separated line.
+ *
+ * Fields are not unquoted, and scanning stops once max_fields fields are
+ * found, so long trailing columns are never read.
+ *
+ * @param line The line to split.
+ * @param fields Array that receives up to max_fields fields.
+ * @param max_fields The capacity of fields.
+ * @return The number of fields stored, at most max_fields.
+ */
+size_t input_split_csv(input_token_t line, input_token_t *fields, size_t max_fields);
+
+#endif /* A61F3C9E_2B7D_4E58_9C0A_5D84E1B7F263 */
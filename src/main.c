@@ -38,12 +38,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <time.h>
+#include <unistd.h>
 
 #include "cli_parser.h"
+#include "cycle_file.h"
 #include "graph.h"
+#include "snapshot.h"
 
 static FILE *openFile(char const *const filename);
+static int decodeCycles(const char *input, const char *outName, log_function_t logger);
 
 /**
  * @brief The main function and entry point of the program.
@@ -55,6 +58,8 @@ static FILE *openFile(char const *const filename);
 int main(int argc, char **argv) {
     FILE *file = NULL;
     Graph graph = NULL;
+    Graph region = NULL;
+    GraphDelta delta = {0};
     CLIOptions options;
 
     parse_cli_args(argc, argv, &options);
@@ -68,7 +73,12 @@ int main(int argc, char **argv) {
         return 0;
     }
 
-    if (options.positional_count < 1) {
+    if (options.append_snapshot && (options.load_snapshot || options.save_snapshot || options.collapse_parallel)) {
+        fprintf(stderr, "Incorrect usage: --append cannot be combined with --load-snapshot, --save-snapshot or -c.\n\n");
+        print_short_help(argv[0]);
+        return 1;
+    }
+    if (options.positional_count < 1 && !(options.load_snapshot && !options.decode)) {
         fprintf(stderr, "Incorrect usage: an input file is required.\n\n");
         print_short_help(argv[0]);
         return 1;
@@ -78,37 +88,137 @@ int main(int argc, char **argv) {
     const char *const outName = make_output_filename(&options);
     logger("Output will be saved to: %s\n", outName);
 
-    file = openFile(options.positionals[0]);
-    if (file == NULL) {
-        return 1; 
+    if (options.decode) {
+        return decodeCycles(options.positionals[0], outName, logger);
     }
 
     // TODO: Integrate with a tool to extract data or provide test files.
-    graph = loadGraph(file, logger);
-    if (graph == NULL) {
-        fprintf(stderr, "Error: Failed to load graph from file.\n");
-        fclose(file);
-        return 1;
+    size_t threads = options.threads;
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (size_t)cpus : 1;
+    }
+    if (options.load_snapshot) {
+        graph = snapshot_load(options.load_snapshot, options.verify_snapshot, logger);
+        if (graph == NULL) {
+            return 1;
+        }
+    } else if (options.append_snapshot) {
+        graph = snapshot_open(options.append_snapshot, options.verify_snapshot, &delta, logger);
+        if (graph == NULL) {
+            return 1;
+        }
+        file = openFile(options.positionals[0]);
+        if (file == NULL) {
+            freeGraphDelta(&delta);
+            freeGraph(graph);
+            return 1;
+        }
+        loadGraphDelta(graph, &delta, file, logger);
+        region = extractAppendedRegion(graph, &delta, options.max_cycle_length, logger);
+    } else {
+        file = openFile(options.positionals[0]);
+        if (file == NULL) {
+            return 1; 
+        }
+        graph = loadGraph(file, threads, logger);
+        if (graph == NULL) {
+            fprintf(stderr, "Error: Failed to load graph from file.\n");
+            fclose(file);
+            return 1;
+        }
     }
 
-    size_t total_cycles_found = 0;
+    LogInfo_t info = {0};
+    info.walletsAmount = graph->vertexAmount + delta.vertexAmount;
+    info.transactionAmount = graph->edgesAmount + delta.edgesAmount;
+    if (options.collapse_parallel) {
+        size_t removed = collapseParallelEdges(graph);
+        logger("Collapsed %zu parallel edges: %zu edges left\n", removed, graph->edgesAmount);
+    }
+    if (options.save_snapshot) {
+        if (snapshot_save(graph, options.save_snapshot) != 0) {
+            if (file) fclose(file);
+            freeGraph(graph);
+            return 1;
+        }
+        logger("Snapshot saved to: %s\n", options.save_snapshot);
+    }
+    info.outputFileName = outName;
+    if (options.temporal) {
+        if (!graph->timestamps) {
+            fprintf(stderr, "Error: --time-window needs a block number or timestamp column in the input.\n");
+            if (file) fclose(file);
+            if (region) freeGraph(region);
+            freeGraph(graph);
+            freeGraphDelta(&delta);
+            return 1;
+        }
+        snprintf(info.algorithmUsed, sizeof(info.algorithmUsed), "temporal (window %" PRIu64 ")",
+                 options.time_window);
+    } else if (options.max_cycle_length > 0) {
+        snprintf(info.algorithmUsed, sizeof(info.algorithmUsed), "bounded (max length %zu)",
+                 options.max_cycle_length);
+    } else {
+        snprintf(info.algorithmUsed, sizeof(info.algorithmUsed), "%s",
+                 options.algorithm == ALGORITHM_JOHNSON ? "johnson" : "dfs");
+    }
+
+    SearchOptions search = {outName, threads, options.cycle_stats, !options.keep_duplicates,
+                            options.output_format == OUTPUT_BINARY, options.print_addresses, logger};
+    Graph searched = region ? region : graph;
     logger("\nStarting cycle detection...\n");
-    clock_t start = clock();
-    depthFirstSearch(graph, outName, logger, &total_cycles_found);
-    clock_t end = clock();
-    double time_taken = (double)(end - start) / CLOCKS_PER_SEC;
+    if (options.temporal) {
+        temporalCycles(searched, options.time_window, options.max_cycle_length, &search, &info);
+    } else if (options.max_cycle_length > 0) {
+        boundedCycles(searched, options.max_cycle_length, &search, &info);
+    } else if (options.algorithm == ALGORITHM_JOHNSON) {
+        johnsonCycles(searched, &search, &info);
+    } else {
+        depthFirstSearch(searched, &search, &info);
+    }
+
+    // Stored only once its cycles are written, so a failed run can be repeated.
+    int status = 0;
+    if (options.append_snapshot) {
+        status = snapshot_append(graph, &delta, options.append_snapshot, logger) == 0 ? 0 : 1;
+    }
 
     logger("\n-----------------------------------\n");
     logger("Cycle detection completed.\n");
-    logger("Runtime to detect cycles: %f seconds\n", time_taken);
-    logger("Total cycles found: %zu\n", total_cycles_found);
+    logRunInfo(&info, logger);
     logger("-----------------------------------\n");
 
-    fclose(file);
+    if (file) fclose(file);
+    if (region) freeGraph(region);
     freeGraph(graph);
-    freeVertexMap();
+    freeGraphDelta(&delta);
     graph = NULL;
 
+    return status;
+}
+
+/**
+ * @brief Converts a binary cycle file written with --format=bin to text.
+ *
+ * @param input The binary cycle file.
+ * @param outName The text file to write.
+ * @param logger The logging function.
+ * @return 0 on success, 1 on error.
+ */
+static int decodeCycles(const char *input, const char *outName, log_function_t logger) {
+    FILE *out = fopen(outName, "w");
+    if (out == NULL) {
+        perror("ERROR: creating/opening output file");
+        return 1;
+    }
+    long long cycles = cycle_file_decode(input, out);
+    if (fclose(out) != 0 && cycles >= 0) {
+        perror("ERROR: writing output file");
+        return 1;
+    }
+    if (cycles < 0) return 1;
+    logger("Decoded %lld cycles\n", cycles);
     return 0;
 }
 
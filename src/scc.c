@@ -0,0 +1,316 @@
+/**
+ * @file scc.c
+ * @brief Implementation of the strongly-connected-component pre-pass.
+ * @defgroup scc Strongly Connected Components
+ * @{
+ */
+
+#include "scc.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * @def TARJAN_UNVISITED
+ * @brief Tarjan index of a vertex that has not been reached yet.
+ */
+#define TARJAN_UNVISITED (-1)
+
+/**
+ * @struct tarjan_frame_t
+ * @brief One level of the explicit Tarjan stack: a vertex and where its edge scan resumes.
+ */
+typedef struct {
+    vertex v;                    /**< The vertex being explored. */
+    size_t next_edge;            /**< CSR index of the next out-edge of v to explore. */
+} tarjan_frame_t;
+
+/**
+ * @struct scc_workspace_t
+ * @brief The internal structure of the Tarjan scratch arrays, all sized by the vertex count.
+ */
+struct scc_workspace_t {
+    int *index;                  /**< Discovery order of each vertex, or TARJAN_UNVISITED. */
+    int *low;                    /**< Low-link of each vertex. */
+    int *raw;                    /**< SCC of each vertex, numbered in order of completion. */
+    bool *on_stack;              /**< True while a vertex is on the Tarjan stack. */
+    vertex *stack;               /**< The Tarjan stack of vertices whose SCC is still open. */
+    tarjan_frame_t *frames;      /**< The explicit DFS stack. */
+    size_t *raw_size;            /**< Size of each SCC, by completion number. */
+    int *renumber;               /**< Final label of each SCC, by completion number. */
+    bool borrowed;               /**< True if index, low, raw and on_stack belong to another workspace. */
+};
+
+/**
+ * @brief Allocates the scratch arrays for graphs of up to V vertices.
+ * @param V The number of vertices.
+ * @return The workspace, or NULL on allocation failure.
+ */
+scc_workspace_t *scc_workspace_create(size_t V) {
+    scc_workspace_t *ws = calloc(1, sizeof(scc_workspace_t));
+    if (!ws) return NULL;
+    size_t n = V ? V : 1;
+    ws->index = malloc(n * sizeof(int));
+    ws->low = malloc(n * sizeof(int));
+    ws->raw = malloc(n * sizeof(int));
+    ws->on_stack = calloc(n, sizeof(bool));
+    ws->stack = malloc(n * sizeof(vertex));
+    ws->frames = malloc(n * sizeof(tarjan_frame_t));
+    ws->raw_size = malloc(n * sizeof(size_t));
+    ws->renumber = malloc(n * sizeof(int));
+    if (!ws->index || !ws->low || !ws->raw || !ws->on_stack || !ws->stack || !ws->frames
+        || !ws->raw_size || !ws->renumber) {
+        scc_workspace_free(ws);
+        return NULL;
+    }
+    return ws;
+}
+
+/**
+ * @brief Creates a workspace for one more thread, sharing the per-vertex arrays of another.
+ * @param shared The workspace whose per-vertex arrays are shared.
+ * @param max_set The largest vertex set the clone will split.
+ * @return The workspace, or NULL on allocation failure.
+ */
+scc_workspace_t *scc_workspace_clone(const scc_workspace_t *shared, size_t max_set) {
+    scc_workspace_t *ws = calloc(1, sizeof(scc_workspace_t));
+    if (!ws) return NULL;
+    size_t n = max_set ? max_set : 1;
+    ws->index = shared->index;
+    ws->low = shared->low;
+    ws->raw = shared->raw;
+    ws->on_stack = shared->on_stack;
+    ws->borrowed = true;
+    ws->stack = malloc(n * sizeof(vertex));
+    ws->frames = malloc(n * sizeof(tarjan_frame_t));
+    ws->raw_size = malloc(n * sizeof(size_t));
+    ws->renumber = malloc(n * sizeof(int));
+    if (!ws->stack || !ws->frames || !ws->raw_size || !ws->renumber) {
+        scc_workspace_free(ws);
+        return NULL;
+    }
+    return ws;
+}
+
+/**
+ * @brief Frees a workspace.
+ * @param ws The workspace to be freed.
+ */
+void scc_workspace_free(scc_workspace_t *ws) {
+    if (!ws) return;
+    if (!ws->borrowed) {
+        free(ws->index);
+        free(ws->low);
+        free(ws->raw);
+        free(ws->on_stack);
+    }
+    free(ws->stack);
+    free(ws->frames);
+    free(ws->raw_size);
+    free(ws->renumber);
+    free(ws);
+}
+
+/**
+ * @brief Tells whether a vertex has an edge to itself.
+ * @param G The graph.
+ * @param v The vertex.
+ * @return True if one of the out-edges of v points back to v.
+ */
+static bool has_self_loop(Graph G, vertex v) {
+    for (size_t e = G->offsets[v]; e < G->offsets[v + 1]; e++) {
+        if (G->destinations[e] == v) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Runs Tarjan's algorithm over a labelled vertex set, filling ws->raw and ws->raw_size.
+ * @param G The graph.
+ * @param members The vertex set.
+ * @param n The number of members.
+ * @param label The label of each vertex; only edges to vertices labelled like the members are followed.
+ * @param ws The scratch arrays.
+ * @return The number of SCCs found.
+ */
+static size_t tarjan(Graph G, const vertex *members, size_t n, const int *label, scc_workspace_t *ws) {
+    int *index = ws->index, *low = ws->low;
+    bool *on_stack = ws->on_stack;
+    vertex *stack = ws->stack;
+    tarjan_frame_t *frames = ws->frames;
+    if (n == 0) return 0;
+
+    int set = scc_label_get(label, members[0]);
+    for (size_t i = 0; i < n; i++) index[members[i]] = TARJAN_UNVISITED;
+
+    int next_index = 0;
+    size_t stack_size = 0;
+    size_t count = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        vertex root = members[i];
+        if (index[root] != TARJAN_UNVISITED) continue;
+
+        size_t depth = 0;
+        index[root] = low[root] = next_index++;
+        stack[stack_size++] = root;
+        on_stack[root] = true;
+        frames[depth++] = (tarjan_frame_t){root, G->offsets[root]};
+
+        while (depth > 0) {
+            tarjan_frame_t *top = &frames[depth - 1];
+            vertex v = top->v;
+
+            if (top->next_edge < G->offsets[v + 1]) {
+                vertex w = G->destinations[top->next_edge++];
+                if (scc_label_get(label, w) != set) continue;
+                if (index[w] == TARJAN_UNVISITED) {
+                    index[w] = low[w] = next_index++;
+                    stack[stack_size++] = w;
+                    on_stack[w] = true;
+                    frames[depth++] = (tarjan_frame_t){w, G->offsets[w]};
+                } else if (on_stack[w] && index[w] < low[v]) {
+                    low[v] = index[w];
+                }
+                continue;
+            }
+
+            // All edges of v done: propagate its low-link and close its SCC if it is the root.
+            depth--;
+            if (depth > 0) {
+                vertex parent = frames[depth - 1].v;
+                if (low[v] < low[parent]) low[parent] = low[v];
+            }
+            if (low[v] == index[v]) {
+                size_t size = 0;
+                vertex w;
+                do {
+                    w = stack[--stack_size];
+                    on_stack[w] = false;
+                    ws->raw[w] = (int)count;
+                    size++;
+                } while (w != v);
+                ws->raw_size[count++] = size;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Splits a set of vertices into the SCCs of the subgraph it induces.
+ * @param G The graph. Its CSR must be built.
+ * @param members The vertex set, in ascending order, all with the same label.
+ * @param n The number of members.
+ * @param label The label of each vertex of the graph; updated for the members.
+ * @param next_label The next unused label; advanced by the number of kept SCCs.
+ * @param ws Scratch arrays sized for G.
+ * @param out Receives the members of the kept SCCs, grouped by SCC and ascending.
+ * @param out_offsets Receives the group boundaries.
+ * @param discarded If not NULL, incremented by the number of singleton SCCs without a self-loop.
+ * @return The number of kept SCCs.
+ */
+size_t scc_split(Graph G, const vertex *members, size_t n, int *label, int *next_label,
+                 scc_workspace_t *ws, vertex *out, size_t *out_offsets, size_t *discarded) {
+    size_t raw_count = tarjan(G, members, n, label, ws);
+    int *renumber = ws->renumber;
+    for (size_t c = 0; c < raw_count; c++) renumber[c] = SCC_NONE; // Not seen yet
+
+    // Number the kept SCCs by first appearance in ascending vertex order, so that
+    // labels follow the smallest vertex of each SCC.
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        int r = ws->raw[members[i]];
+        if (renumber[r] == SCC_NONE) {
+            if (ws->raw_size[r] == 1 && !has_self_loop(G, members[i])) {
+                if (discarded) (*discarded)++;
+                renumber[r] = SCC_NONE - 1; // Seen, discarded
+            } else {
+                renumber[r] = (int)count++;
+            }
+        }
+    }
+    // Reserve the labels in one step, so that threads splitting disjoint sets never share one.
+    int first = __atomic_fetch_add(next_label, (int)count, __ATOMIC_RELAXED);
+
+    // Group the members with a counting sort; ascending order is kept.
+    for (size_t c = 0; c <= count; c++) out_offsets[c] = 0;
+    for (size_t i = 0; i < n; i++) {
+        int r = renumber[ws->raw[members[i]]];
+        if (r >= 0) out_offsets[r + 1]++;
+    }
+    for (size_t c = 0; c < count; c++) out_offsets[c + 1] += out_offsets[c];
+
+    size_t *cursor = ws->raw_size; // Sizes are no longer needed.
+    for (size_t c = 0; c < count; c++) cursor[c] = out_offsets[c];
+    for (size_t i = 0; i < n; i++) {
+        vertex v = members[i];
+        int r = renumber[ws->raw[v]];
+        scc_label_set(label, v, r >= 0 ? first + r : SCC_NONE);
+        if (r >= 0) out[cursor[r]++] = v;
+    }
+    return count;
+}
+
+/**
+ * @brief Computes the non-trivial SCCs of a graph.
+ * @param G The graph. Its CSR must be built.
+ * @return The partition, or NULL on allocation failure.
+ */
+scc_partition_t *scc_partition(Graph G) {
+    size_t V = G->vertexAmount;
+    scc_partition_t *scc = calloc(1, sizeof(scc_partition_t));
+    scc_workspace_t *ws = scc_workspace_create(V);
+    vertex *all = malloc((V ? V : 1) * sizeof(vertex));
+    if (!scc || !ws || !all) goto fail;
+
+    scc->component = calloc(V ? V : 1, sizeof(int));
+    scc->members = malloc((V ? V : 1) * sizeof(vertex));
+    scc->offsets = malloc((V + 1) * sizeof(size_t));
+    if (!scc->component || !scc->members || !scc->offsets) goto fail;
+
+    for (size_t v = 0; v < V; v++) all[v] = (vertex)v;
+    int next_label = 0;
+    scc->count = scc_split(G, all, V, scc->component, &next_label, ws,
+                           scc->members, scc->offsets, &scc->discarded);
+
+    for (size_t c = 0; c < scc->count; c++) {
+        size_t size = scc->offsets[c + 1] - scc->offsets[c];
+        scc->vertices += size;
+        if (size > scc->largest) scc->largest = size;
+        int bucket = 0;
+        while (bucket + 1 < SCC_HISTOGRAM_BUCKETS && (size >> (bucket + 1)) != 0) bucket++;
+        scc->histogram[bucket]++;
+
+        for (size_t i = scc->offsets[c]; i < scc->offsets[c + 1]; i++) {
+            vertex v = scc->members[i];
+            for (size_t e = G->offsets[v]; e < G->offsets[v + 1]; e++) {
+                if (scc->component[G->destinations[e]] == (int)c) scc->edges++;
+            }
+        }
+    }
+
+    free(all);
+    scc_workspace_free(ws);
+    return scc;
+
+fail:
+    free(all);
+    scc_workspace_free(ws);
+    scc_partition_free(scc);
+    return NULL;
+}
+
+/**
+ * @brief Frees a partition returned by scc_partition().
+ * @param scc The partition to be freed.
+ */
+void scc_partition_free(scc_partition_t *scc) {
+    if (!scc) return;
+    free(scc->component);
+    free(scc->offsets);
+    free(scc->members);
+    free(scc);
+}
+
+ /** @} */
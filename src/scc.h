@@ -0,0 +1,150 @@
+/**
+ * @file scc.h
+ * @brief Defines the strongly-connected-component pre-pass of the cycle search.
+ *
+ * Every cycle lies entirely inside one strongly connected component (SCC). In a
+ * transaction graph most wallets are pure sources or sinks, i.e. singleton SCCs
+ * without a self-loop, and can never be on a cycle. Partitioning the graph first
+ * lets the cycle finders skip those vertices and every edge between components,
+ * and treat each remaining SCC as an independent subproblem.
+ */
+
+#ifndef F4B29D3E_7A61_4C08_9E5D_31C8A6F07B24
+#define F4B29D3E_7A61_4C08_9E5D_31C8A6F07B24
+
+#include <stddef.h>
+
+#include "graph.h"
+
+/**
+ * @def SCC_HISTOGRAM_BUCKETS
+ * @brief Number of power-of-two buckets in the SCC size histogram.
+ */
+#define SCC_HISTOGRAM_BUCKETS LOG_SCC_BUCKETS
+
+/**
+ * @def SCC_NONE
+ * @brief Component id of a vertex that is not in any non-trivial SCC.
+ */
+#define SCC_NONE (-1)
+
+/**
+ * @struct scc_partition_t
+ * @brief The non-trivial SCCs of a graph.
+ *
+ * Components are numbered by their smallest vertex, and the members of each
+ * one are listed in ascending order, so the first member is that smallest
+ * vertex.
+ */
+typedef struct {
+    size_t count;                /**< The number of non-trivial SCCs. */
+    int *component;              /**< Component id of each vertex, or SCC_NONE. */
+    size_t *offsets;             /**< Members of component c are members[offsets[c] .. offsets[c + 1]). */
+    vertex *members;             /**< The vertices of all non-trivial SCCs, grouped by component. */
+    size_t vertices;             /**< The number of vertices in non-trivial SCCs. */
+    size_t edges;                /**< The number of edges with both endpoints in the same non-trivial SCC. */
+    size_t largest;              /**< The size of the largest SCC. */
+    size_t discarded;            /**< The number of singleton SCCs without a self-loop. */
+    size_t histogram[SCC_HISTOGRAM_BUCKETS]; /**< histogram[i] counts SCCs with 2^i <= size < 2^(i+1). */
+} scc_partition_t;
+
+/**
+ * @brief Reads the label of a vertex.
+ *
+ * Labels may be rewritten by another thread splitting a different set; a
+ * relaxed atomic access is enough, since a label is only ever compared with
+ * the caller's own, which no other thread writes.
+ *
+ * @param label The labels.
+ * @param v The vertex.
+ * @return The label of v.
+ */
+static inline int scc_label_get(const int *label, vertex v) {
+    return __atomic_load_n(&label[v], __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Writes the label of a vertex.
+ * @param label The labels.
+ * @param v The vertex.
+ * @param value The new label.
+ */
+static inline void scc_label_set(int *label, vertex v, int value) {
+    __atomic_store_n(&label[v], value, __ATOMIC_RELAXED);
+}
+
+/**
+ * @struct scc_workspace_t
+ * @brief An opaque type for the per-vertex scratch arrays of Tarjan's algorithm.
+ *
+ * Lets callers that split many vertex sets (e.g. Johnson's algorithm) allocate
+ * them once.
+ */
+typedef struct scc_workspace_t scc_workspace_t;
+
+/**
+ * @brief Allocates the scratch arrays for graphs of up to V vertices.
+ * @param V The number of vertices.
+ * @return The workspace, or NULL on allocation failure.
+ */
+scc_workspace_t *scc_workspace_create(size_t V);
+
+/**
+ * @brief Creates a workspace for one more thread, sharing the per-vertex arrays of another.
+ *
+ * Threads may split disjoint vertex sets at the same time with clones of one
+ * workspace: the per-vertex arrays are only touched at the members being
+ * split, and only the stacks, which are sized by the set, are private.
+ *
+ * @param shared The workspace whose per-vertex arrays are shared. It must outlive the clone.
+ * @param max_set The largest vertex set the clone will split.
+ * @return The workspace, or NULL on allocation failure.
+ */
+scc_workspace_t *scc_workspace_clone(const scc_workspace_t *shared, size_t max_set);
+
+/**
+ * @brief Frees a workspace.
+ * @param ws The workspace to be freed.
+ */
+void scc_workspace_free(scc_workspace_t *ws);
+
+/**
+ * @brief Splits a set of vertices into the SCCs of the subgraph it induces.
+ *
+ * Only edges between vertices that carry the same label as members[0] are
+ * followed. Afterwards, the vertices of each kept SCC (more than one vertex, or
+ * a self-loop) carry a fresh label taken from *next_label, in order of the
+ * SCC's smallest vertex; all other members are labelled SCC_NONE.
+ *
+ * @param G The graph. Its CSR must be built.
+ * @param members The vertex set, in ascending order, all with the same label.
+ * @param n The number of members.
+ * @param label The label of each vertex of the graph; updated for the members.
+ * @param next_label The next unused label; advanced atomically by the number of kept SCCs.
+ * @param ws Scratch arrays sized for G, or a clone sized for n.
+ * @param out Receives the members of the kept SCCs, grouped by SCC and ascending. Capacity n.
+ * @param out_offsets Receives the group boundaries, group c being out[out_offsets[c] .. out_offsets[c + 1]). Capacity n + 1.
+ * @param discarded If not NULL, incremented by the number of singleton SCCs without a self-loop.
+ * @return The number of kept SCCs.
+ */
+size_t scc_split(Graph G, const vertex *members, size_t n, int *label, int *next_label,
+                 scc_workspace_t *ws, vertex *out, size_t *out_offsets, size_t *discarded);
+
+/**
+ * @brief Computes the non-trivial SCCs of a graph with Tarjan's algorithm.
+ *
+ * Uses an explicit stack, so its depth is bounded by the heap only. Runs in
+ * O(V + E). Singleton SCCs are kept only if the vertex has a self-loop.
+ *
+ * @param G The graph. Its CSR must be built.
+ * @return The partition, or NULL on allocation failure.
+ */
+scc_partition_t *scc_partition(Graph G);
+
+/**
+ * @brief Frees a partition returned by scc_partition().
+ * @param scc The partition to be freed.
+ */
+void scc_partition_free(scc_partition_t *scc);
+
+#endif /* F4B29D3E_7A61_4C08_9E5D_31C8A6F07B24 */
@@ -0,0 +1,271 @@
+/**
+ * @file simd_parse.c
+ * @brief Implementation of the vectorised digit kernels and their runtime dispatch.
+ * @defgroup simd_parse SIMD Parsing Kernels
+ * @{
+ */
+
+#include "simd_parse.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_PARSE_X86 1
+#endif
+
+/**
+ * @brief Maps an ASCII character to 0x10 | its hexadecimal value, or to 0 if it is not a hex digit.
+ *
+ * The 0x10 marker lets validation be folded into the same table lookups as the
+ * conversion, without a branch per character.
+ */
+static const uint8_t hex_value[256] = {
+    ['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14,
+    ['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17, ['8'] = 0x18, ['9'] = 0x19,
+    ['a'] = 0x1A, ['b'] = 0x1B, ['c'] = 0x1C, ['d'] = 0x1D, ['e'] = 0x1E, ['f'] = 0x1F,
+    ['A'] = 0x1A, ['B'] = 0x1B, ['C'] = 0x1C, ['D'] = 0x1D, ['E'] = 0x1E, ['F'] = 0x1F,
+};
+
+/**
+ * @brief Portable hex decoder, one table lookup per character.
+ * @param hex The first of SIMD_HEX40_LEN characters.
+ * @param out Receives the decoded bytes.
+ * @return 0 on success, -1 on an invalid character.
+ */
+static int hex40_scalar(const char *hex, uint8_t *out) {
+    const unsigned char *s = (const unsigned char *)hex;
+    uint8_t valid = 0x10;
+    for (int i = 0; i < SIMD_HEX40_LEN / 2; i++) {
+        uint8_t hi = hex_value[s[2 * i]], lo = hex_value[s[2 * i + 1]];
+        valid &= hi & lo;
+        out[i] = (uint8_t)((hi << 4) | (lo & 0x0F));
+    }
+    return valid ? 0 : -1;
+}
+
+/**
+ * @brief Converts 8 digits packed little-endian in a word, the first digit in the low byte.
+ *
+ * Pairs, then quads, then the two halves are combined with three multiplies
+ * instead of eight multiply-adds.
+ *
+ * @param word The 8 characters, already checked to be digits.
+ * @return The value of the digits.
+ */
+static inline uint32_t swar_digits8(uint64_t word) {
+    word -= 0x3030303030303030ull;
+    word = word * 10 + (word >> 8);
+    word = (((word & 0x000000FF000000FFull) * 0x000F424000000064ull)
+            + (((word >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32;
+    return (uint32_t)word;
+}
+
+/**
+ * @brief Checks that 8 characters packed in a word are all decimal digits.
+ * @param word The 8 characters.
+ * @return Non-zero if every byte is in '0'..'9'.
+ */
+static inline int swar_all_digits(uint64_t word) {
+    return ((word & 0xF0F0F0F0F0F0F0F0ull)
+            | (((word + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull;
+}
+
+/**
+ * @brief Converts 8 decimal digits.
+ * @param p The first of 8 characters.
+ * @param out Receives the value.
+ * @return 0 on success, -1 on a non-digit.
+ */
+int simd_parse_digits8(const char *p, uint32_t *out) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    if (!swar_all_digits(word)) return -1;
+    *out = swar_digits8(word);
+    return 0;
+#else
+    uint32_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        unsigned d = (unsigned char)p[i] - '0';
+        if (d > 9) return -1;
+        value = value * 10 + d;
+    }
+    *out = value;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Portable 16-digit conversion, as two 8-digit halves.
+ * @param p The first of 16 characters.
+ * @param out Receives the value.
+ * @return 0 on success, -1 on a non-digit.
+ */
+static int digits16_scalar(const char *p, uint64_t *out) {
+    uint32_t hi, lo;
+    if (simd_parse_digits8(p, &hi) != 0 || simd_parse_digits8(p + 8, &lo) != 0) return -1;
+    *out = (uint64_t)hi * 100000000u + lo;
+    return 0;
+}
+
+#ifdef SIMD_PARSE_X86
+
+/**
+ * @brief Validates and decodes 16 hex digits into 8 bytes with SSE4.1.
+ *
+ * Each character is classified as a digit (c - '0' <= 9) or a letter
+ * ((c | 0x20) - 'a' <= 5), mapped to its nibble, and adjacent nibbles are
+ * merged with a single multiply-add (hi * 16 + lo).
+ *
+ * @param hex The first of 16 characters.
+ * @param out Receives 8 bytes.
+ * @return Non-zero if all characters were hex digits.
+ */
+__attribute__((target("sse4.1")))
+static inline int hex16_sse(const char *hex, uint8_t *out) {
+    __m128i c = _mm_loadu_si128((const __m128i *)hex);
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i alpha = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+
+    __m128i nibble = _mm_blendv_epi8(_mm_add_epi8(alpha, _mm_set1_epi8(10)), digit, is_digit);
+    __m128i words = _mm_maddubs_epi16(nibble, _mm_set1_epi16(0x0110));
+    _mm_storel_epi64((__m128i *)out, _mm_packus_epi16(words, words));
+
+    return _mm_movemask_epi8(_mm_or_si128(is_digit, is_alpha)) == 0xFFFF;
+}
+
+/**
+ * @brief SSE4.1 hex decoder: three overlapping 16-character blocks.
+ * @param hex The first of SIMD_HEX40_LEN characters.
+ * @param out Receives the decoded bytes.
+ * @return 0 on success, -1 on an invalid character.
+ */
+__attribute__((target("sse4.1")))
+static int hex40_sse41(const char *hex, uint8_t *out) {
+    // Characters 24..39 overlap the second block; both write the same bytes 12..15.
+    int valid = hex16_sse(hex, out);
+    valid &= hex16_sse(hex + 16, out + 8);
+    valid &= hex16_sse(hex + 24, out + 12);
+    return valid ? 0 : -1;
+}
+
+/**
+ * @brief AVX2 hex decoder: one 32-character block and a 16-character tail.
+ * @param hex The first of SIMD_HEX40_LEN characters.
+ * @param out Receives the decoded bytes.
+ * @return 0 on success, -1 on an invalid character.
+ */
+__attribute__((target("avx2")))
+static int hex40_avx2(const char *hex, uint8_t *out) {
+    __m256i c = _mm256_loadu_si256((const __m256i *)hex);
+    __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+
+    __m256i nibble = _mm256_blendv_epi8(_mm256_add_epi8(alpha, _mm256_set1_epi8(10)), digit, is_digit);
+    __m256i words = _mm256_maddubs_epi16(nibble, _mm256_set1_epi16(0x0110));
+    // packus works per 128-bit lane; gather the low quadword of each lane.
+    __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0x08);
+    _mm_storeu_si128((__m128i *)out, _mm256_castsi256_si128(bytes));
+
+    int valid = _mm256_movemask_epi8(_mm256_or_si256(is_digit, is_alpha)) == -1;
+    valid &= hex16_sse(hex + 24, out + 12);
+    return valid ? 0 : -1;
+}
+
+/**
+ * @brief SSE4.1 16-digit conversion.
+ *
+ * Digits are combined pairwise in three multiply-add steps (x10, x100,
+ * x10000), leaving two 8-digit halves.
+ *
+ * @param p The first of 16 characters.
+ * @param out Receives the value.
+ * @return 0 on success, -1 on a non-digit.
+ */
+__attribute__((target("sse4.1")))
+static int digits16_sse41(const char *p, uint64_t *out) {
+    __m128i digit = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)p), _mm_set1_epi8('0'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    if (_mm_movemask_epi8(is_digit) != 0xFFFF) return -1;
+
+    __m128i pairs = _mm_maddubs_epi16(digit, _mm_set1_epi16(0x010A));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00010064));
+    quads = _mm_packus_epi32(quads, quads);
+    __m128i octets = _mm_madd_epi16(quads, _mm_set1_epi32(0x00012710));
+
+    uint64_t hi = (uint32_t)_mm_cvtsi128_si32(octets);
+    uint64_t lo = (uint32_t)_mm_extract_epi32(octets, 1);
+    *out = hi * 100000000u + lo;
+    return 0;
+}
+
+#endif /* SIMD_PARSE_X86 */
+
+/**
+ * @struct simd_impl_t
+ * @brief The kernels selected for the running CPU.
+ */
+typedef struct {
+    /** @var hex40 The 40-digit hex decoder. */
+    int (*hex40)(const char *, uint8_t *);
+    /** @var digits16 The 16-digit decimal converter. */
+    int (*digits16)(const char *, uint64_t *);
+    /** @var isa The name of the instruction set in use. */
+    const char *isa;
+} simd_impl_t;
+
+/** @brief The active kernels. Scalar until simd_parse_select() has run. */
+static simd_impl_t simd_impl = {hex40_scalar, digits16_scalar, "scalar"};
+
+/**
+ * @brief Picks the best kernels for the running CPU.
+ *
+ * Runs once, before main(), so the hot path is a plain indirect call with no
+ * per-token feature check and no synchronisation between loader threads.
+ */
+__attribute__((constructor))
+static void simd_parse_select(void) {
+#ifdef SIMD_PARSE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        simd_impl = (simd_impl_t){hex40_avx2, digits16_sse41, "avx2"};
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        simd_impl = (simd_impl_t){hex40_sse41, digits16_sse41, "sse4.1"};
+    }
+#endif
+}
+
+/**
+ * @brief Validates and decodes 40 hexadecimal digits into 20 bytes.
+ * @param hex The first of SIMD_HEX40_LEN characters.
+ * @param out Receives the decoded bytes.
+ * @return 0 on success, -1 if any character is not a hex digit.
+ */
+int simd_hex40_decode(const char *hex, uint8_t out[SIMD_HEX40_LEN / 2]) {
+    return simd_impl.hex40(hex, out);
+}
+
+/**
+ * @brief Converts a block of 16 decimal digits.
+ * @param p The first of 16 characters.
+ * @param out Receives the value.
+ * @return 0 on success, -1 on a non-digit.
+ */
+int simd_parse_digits16(const char *p, uint64_t *out) {
+    return simd_impl.digits16(p, out);
+}
+
+/**
+ * @brief Names the instruction set the kernels were dispatched to.
+ * @return "avx2", "sse4.1" or "scalar".
+ */
+const char *simd_parse_isa(void) {
+    return simd_impl.isa;
+}
+
+ /** @} */
@@ -0,0 +1,59 @@
+/**
+ * @file simd_parse.h
+ * @brief Defines the vectorised digit kernels used by the input parsers.
+ *
+ * Nearly all parsing time goes into two token shapes: 40 hex digits of an
+ * address and the long decimal digit runs of a Wei value. These kernels convert
+ * such runs a block at a time instead of a character at a time.
+ *
+ * The implementation is picked once at startup from what the running CPU
+ * supports (AVX2, SSE4.1, or portable scalar code), so a binary built without
+ * -march=native still uses the vector units where they exist. Every
+ * implementation returns exactly the same results.
+ */
+
+#ifndef E81C4B7A_53D2_4F96_A0B8_2D6E9F31C745
+#define E81C4B7A_53D2_4F96_A0B8_2D6E9F31C745
+
+#include <stdint.h>
+
+/**
+ * @def SIMD_HEX40_LEN
+ * @brief The number of hex digits decoded by simd_hex40_decode().
+ */
+#define SIMD_HEX40_LEN 40
+
+/**
+ * @brief Validates and decodes 40 hexadecimal digits into 20 bytes.
+ *
+ * Both cases of 'a'-'f' are accepted.
+ *
+ * @param hex The first of exactly SIMD_HEX40_LEN characters. It does not need to be NUL-terminated.
+ * @param out Receives the 20 decoded bytes, most significant first. Unspecified on failure.
+ * @return 0 on success, -1 if any character is not a hex digit.
+ */
+int simd_hex40_decode(const char *hex, uint8_t out[SIMD_HEX40_LEN / 2]);
+
+/**
+ * @brief Converts a block of 16 decimal digits.
+ * @param p The first of 16 readable characters.
+ * @param out Receives the value of the block, below 10^16.
+ * @return 0 on success, -1 if any character is not a digit.
+ */
+int simd_parse_digits16(const char *p, uint64_t *out);
+
+/**
+ * @brief Converts a block of 8 decimal digits.
+ * @param p The first of 8 readable characters.
+ * @param out Receives the value of the block, below 10^8.
+ * @return 0 on success, -1 if any character is not a digit.
+ */
+int simd_parse_digits8(const char *p, uint32_t *out);
+
+/**
+ * @brief Names the instruction set the kernels were dispatched to.
+ * @return "avx2", "sse4.1" or "scalar".
+ */
+const char *simd_parse_isa(void);
+
+#endif /* E81C4B7A_53D2_4F96_A0B8_2D6E9F31C745 */
@@ -0,0 +1,671 @@
+/**
+ * @file snapshot.c
+ * @brief Implementation of the graph snapshot.
+ * @defgroup snapshot Graph Snapshot
+ * @{
+ */
+
+#include "snapshot.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(size_t) == sizeof(uint64_t), "snapshot offsets are stored as 64-bit size_t");
+
+/**
+ * @def SNAPSHOT_MAGIC
+ * @brief The first bytes of a snapshot file.
+ */
+#define SNAPSHOT_MAGIC "ETHGRAPH"
+
+/**
+ * @def SNAPSHOT_DELTA_MAGIC
+ * @brief The first bytes of a delta segment.
+ */
+#define SNAPSHOT_DELTA_MAGIC "ETHDELTA"
+
+/**
+ * @def SNAPSHOT_BYTE_ORDER
+ * @brief Written in native byte order, to reject a snapshot from a machine with the other one.
+ */
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+/**
+ * @def SNAPSHOT_ALIGNMENT
+ * @brief Alignment of every section in the file, and so in the mapping.
+ */
+#define SNAPSHOT_ALIGNMENT 64
+
+/**
+ * @def SNAPSHOT_HAS_TIMESTAMPS
+ * @brief Header flag: the graph has a timestamp per edge.
+ */
+#define SNAPSHOT_HAS_TIMESTAMPS (1u << 0)
+
+/**
+ * @def SNAPSHOT_HAS_ADDRESSES
+ * @brief Header flag: the id -> address table is stored.
+ */
+#define SNAPSHOT_HAS_ADDRESSES (1u << 1)
+
+/**
+ * @def SNAPSHOT_COLLAPSED
+ * @brief Header flag: parallel edges were collapsed and their aggregates are stored.
+ */
+#define SNAPSHOT_COLLAPSED (1u << 2)
+
+/**
+ * @enum snapshot_section_id_t
+ * @brief The sections of a snapshot, in file order.
+ */
+typedef enum {
+    SECTION_OFFSETS,             /**< offsets, vertices + 1 size_t. */
+    SECTION_DESTINATIONS,        /**< destinations, edges vertex. */
+    SECTION_VALUES,              /**< values, edges uint256_t. */
+    SECTION_TIMESTAMPS,          /**< timestamps, edges uint64_t, with SNAPSHOT_HAS_TIMESTAMPS. */
+    SECTION_ADDRESSES,           /**< addresses, vertices address_t, with SNAPSHOT_HAS_ADDRESSES. */
+    SECTION_EDGE_COUNTS,         /**< edgeCounts, edges uint32_t, with SNAPSHOT_COLLAPSED. */
+    SECTION_VALUE_SUMS,          /**< valueSums, edges uint256_t, with SNAPSHOT_COLLAPSED. */
+    SECTION_VALUE_MINS,          /**< valueMins, edges uint256_t, with SNAPSHOT_COLLAPSED. */
+    SECTION_ADDRESS_INDEX,       /**< address_index_build() of addresses, with SNAPSHOT_HAS_ADDRESSES. */
+    SNAPSHOT_SECTIONS
+} snapshot_section_id_t;
+
+/**
+ * @struct snapshot_section_t
+ * @brief Where a section is in the file; all zero for an absent one.
+ */
+typedef struct {
+    uint64_t offset;             /**< The file offset of the section, a multiple of SNAPSHOT_ALIGNMENT. */
+    uint64_t size;               /**< The size of the section in bytes. */
+    uint64_t checksum;           /**< snapshot_hash() of the section. */
+} snapshot_section_t;
+
+/**
+ * @struct snapshot_header_t
+ * @brief The header at the start of a snapshot file.
+ */
+typedef struct {
+    char magic[8];               /**< SNAPSHOT_MAGIC. */
+    uint32_t version;            /**< SNAPSHOT_VERSION. */
+    uint32_t byte_order;         /**< SNAPSHOT_BYTE_ORDER. */
+    uint32_t flags;              /**< SNAPSHOT_* flags. */
+    uint32_t section_count;      /**< SNAPSHOT_SECTIONS. */
+    uint64_t vertices;           /**< The number of vertices. */
+    uint64_t edges;              /**< The number of edges. */
+    snapshot_section_t sections[SNAPSHOT_SECTIONS]; /**< The sections, by snapshot_section_id_t. */
+    uint64_t delta_offset;       /**< The file offset of the last delta segment, or 0 if there is none. */
+    uint64_t delta_vertices;     /**< The wallets added by all delta segments. */
+    uint64_t delta_edges;        /**< The edges appended by all delta segments. */
+    uint64_t checksum;           /**< snapshot_hash() of the header with this field zero. */
+} snapshot_header_t;
+
+/**
+ * @struct snapshot_delta_t
+ * @brief The header of a delta segment, followed by its payload.
+ *
+ * The payload holds the sources, destinations and values of the edges, their
+ * timestamps with SNAPSHOT_HAS_TIMESTAMPS, then the addresses of the wallets,
+ * packed one after the other. Segments are chained from the last one back.
+ */
+typedef struct {
+    char magic[8];               /**< SNAPSHOT_DELTA_MAGIC. */
+    uint64_t previous;           /**< The file offset of the previous segment, or 0 for the first one. */
+    uint64_t first_vertex;       /**< The wallets added by the segments before this one. */
+    uint64_t vertices;           /**< The wallets added by this segment. */
+    uint64_t first_edge;         /**< The edges appended by the segments before this one. */
+    uint64_t edges;              /**< The edges appended by this segment. */
+    uint64_t checksum;           /**< snapshot_hash() of the payload. */
+} snapshot_delta_t;
+
+/**
+ * @brief Returns a monotonic wall-clock timestamp in seconds.
+ */
+static double wall_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Rotates a word left.
+ */
+static inline uint64_t rotl64(uint64_t x, unsigned n) {
+    return (x << n) | (x >> (64 - n));
+}
+
+/**
+ * @brief Hashes a byte range with four independent multiply-rotate lanes.
+ *
+ * Not cryptographic: it detects truncation, corruption and mismatched files
+ * while running at memory speed.
+ *
+ * @param data The bytes.
+ * @param size The number of bytes.
+ * @return The hash.
+ */
+static uint64_t snapshot_hash(const void *data, size_t size) {
+    const unsigned char *p = data;
+    uint64_t h[4] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full, 0x165667B19E3779F9ull, 0x27D4EB2F165667C5ull};
+    uint64_t w[4];
+    size_t i = 0;
+    for (; i + sizeof(w) <= size; i += sizeof(w)) {
+        memcpy(w, p + i, sizeof(w));
+        for (int l = 0; l < 4; l++) h[l] = rotl64(h[l] ^ w[l], 29) * 0x9FB21C651E98DF25ull;
+    }
+    memset(w, 0, sizeof(w));
+    memcpy(w, p + i, size - i);
+    uint64_t x = size;
+    for (int l = 0; l < 4; l++) {
+        h[l] = rotl64(h[l] ^ w[l], 29) * 0x9FB21C651E98DF25ull;
+        x = (x ^ h[l]) * 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 31;
+    }
+    return x;
+}
+
+/**
+ * @brief Lists the arrays of a graph that go into a snapshot.
+ * @param G The graph.
+ * @param data Receives the array of each section, or NULL if absent.
+ * @param sizes Receives the size in bytes of each section.
+ * @return The SNAPSHOT_* flags of the graph.
+ */
+static uint32_t graph_sections(Graph G, const void *data[SNAPSHOT_SECTIONS], size_t sizes[SNAPSHOT_SECTIONS]) {
+    size_t V = G->vertexAmount, E = G->edgesAmount;
+    data[SECTION_OFFSETS] = G->offsets;
+    sizes[SECTION_OFFSETS] = (V + 1) * sizeof(size_t);
+    data[SECTION_DESTINATIONS] = G->destinations;
+    sizes[SECTION_DESTINATIONS] = E * sizeof(vertex);
+    data[SECTION_VALUES] = G->values;
+    sizes[SECTION_VALUES] = E * sizeof(uint256_t);
+    data[SECTION_TIMESTAMPS] = G->timestamps;
+    sizes[SECTION_TIMESTAMPS] = E * sizeof(uint64_t);
+    data[SECTION_ADDRESSES] = G->addresses;
+    sizes[SECTION_ADDRESSES] = V * sizeof(address_t);
+    data[SECTION_EDGE_COUNTS] = G->edgeCounts;
+    sizes[SECTION_EDGE_COUNTS] = E * sizeof(uint32_t);
+    data[SECTION_VALUE_SUMS] = G->valueSums;
+    sizes[SECTION_VALUE_SUMS] = E * sizeof(uint256_t);
+    data[SECTION_VALUE_MINS] = G->valueMins;
+    sizes[SECTION_VALUE_MINS] = E * sizeof(uint256_t);
+    data[SECTION_ADDRESS_INDEX] = NULL; // Built by snapshot_save(); its size is not fixed by the counts.
+    sizes[SECTION_ADDRESS_INDEX] = 0;
+
+    uint32_t flags = 0;
+    if (G->timestamps) flags |= SNAPSHOT_HAS_TIMESTAMPS;
+    if (G->addresses) flags |= SNAPSHOT_HAS_ADDRESSES;
+    if (G->edgeCounts) flags |= SNAPSHOT_COLLAPSED;
+    return flags;
+}
+
+/**
+ * @brief Rounds a file offset up to SNAPSHOT_ALIGNMENT.
+ */
+static inline uint64_t align_offset(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+/**
+ * @brief Writes a graph to a snapshot file.
+ *
+ * The file is written under a temporary name, synced and renamed over path,
+ * so a crash never leaves a half-written snapshot and a graph still mapped
+ * from path keeps reading the old file.
+ *
+ * @param G The graph. Its CSR must be built.
+ * @param path The file name.
+ * @return 0 on success, -1 on failure (already reported).
+ */
+int snapshot_save(Graph G, const char *path) {
+    if (!G->offsets) {
+        fprintf(stderr, "ERROR: the graph must be built before it is saved\n");
+        return -1;
+    }
+    const void *data[SNAPSHOT_SECTIONS];
+    size_t sizes[SNAPSHOT_SECTIONS];
+
+    snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.flags = graph_sections(G, data, sizes);
+    header.section_count = SNAPSHOT_SECTIONS;
+    header.vertices = G->vertexAmount;
+    header.edges = G->edgesAmount;
+
+    uint32_t *index = NULL;
+    if (G->addresses) {
+        size_t capacity;
+        index = address_index_build(G->addresses, G->vertexAmount, &capacity);
+        if (!index) {
+            fprintf(stderr, "ERROR: bad alloc for the address index\n");
+            return -1;
+        }
+        data[SECTION_ADDRESS_INDEX] = index;
+        sizes[SECTION_ADDRESS_INDEX] = capacity * sizeof(uint32_t);
+    }
+
+    uint64_t offset = sizeof(header);
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++) {
+        if (!data[s]) continue;
+        offset = align_offset(offset);
+        header.sections[s] = (snapshot_section_t){offset, sizes[s], snapshot_hash(data[s], sizes[s])};
+        offset += sizes[s];
+    }
+    header.checksum = snapshot_hash(&header, sizeof(header));
+
+    size_t length = strlen(path);
+    char *temporary = malloc(length + sizeof(".tmp"));
+    if (!temporary) {
+        fprintf(stderr, "ERROR: bad alloc for the snapshot file name\n");
+        free(index);
+        return -1;
+    }
+    memcpy(temporary, path, length);
+    memcpy(temporary + length, ".tmp", sizeof(".tmp"));
+    FILE *file = fopen(temporary, "wb");
+    if (!file) {
+        perror("ERROR: creating snapshot file");
+        free(temporary);
+        free(index);
+        return -1;
+    }
+    static const char padding[SNAPSHOT_ALIGNMENT];
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t written = sizeof(header);
+    for (int s = 0; ok && s < SNAPSHOT_SECTIONS; s++) {
+        if (!data[s]) continue;
+        size_t gap = (size_t)(header.sections[s].offset - written);
+        ok = fwrite(padding, 1, gap, file) == gap && fwrite(data[s], 1, sizes[s], file) == sizes[s];
+        written = header.sections[s].offset + sizes[s];
+    }
+    free(index);
+    if (ok && (fflush(file) != 0 || fsync(fileno(file)) != 0)) ok = false;
+    if (fclose(file) != 0) ok = false;
+    if (ok && rename(temporary, path) != 0) ok = false;
+    if (!ok) {
+        perror("ERROR: writing snapshot file");
+        unlink(temporary);
+    }
+    free(temporary);
+    return ok ? 0 : -1;
+}
+
+/**
+ * @brief Checks the header of a mapped snapshot against the file and the format.
+ * @param header The header.
+ * @param size The size of the file.
+ * @param path The file name, for messages.
+ * @return 0 if it is valid, -1 otherwise (already reported).
+ */
+static int check_header(const snapshot_header_t *header, size_t size, const char *path) {
+    if (size < sizeof(snapshot_header_t) || memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        fprintf(stderr, "ERROR: %s is not a graph snapshot\n", path);
+        return -1;
+    }
+    if (header->version != SNAPSHOT_VERSION) {
+        fprintf(stderr, "ERROR: %s has snapshot version %u, expected %u\n", path, header->version, SNAPSHOT_VERSION);
+        return -1;
+    }
+    if (header->byte_order != SNAPSHOT_BYTE_ORDER) {
+        fprintf(stderr, "ERROR: %s was written on a machine with another byte order\n", path);
+        return -1;
+    }
+    snapshot_header_t copy = *header;
+    copy.checksum = 0;
+    if (snapshot_hash(&copy, sizeof(copy)) != header->checksum || header->section_count != SNAPSHOT_SECTIONS
+        || header->vertices > INT_MAX || header->edges > SIZE_MAX / sizeof(uint256_t)
+        || header->delta_vertices > INT_MAX - header->vertices || header->delta_edges > SIZE_MAX / sizeof(uint256_t)
+        || (header->delta_offset == 0 && (header->delta_vertices != 0 || header->delta_edges != 0))) {
+        fprintf(stderr, "ERROR: %s has a corrupt header\n", path);
+        return -1;
+    }
+
+    // Every present section must have the size the counts imply and lie inside the file.
+    GraphDS shape = {.vertexAmount = header->vertices, .edgesAmount = header->edges};
+    const void *data[SNAPSHOT_SECTIONS];
+    size_t sizes[SNAPSHOT_SECTIONS];
+    graph_sections(&shape, data, sizes);
+    bool present[SNAPSHOT_SECTIONS] = {true, true, true};
+    present[SECTION_TIMESTAMPS] = header->flags & SNAPSHOT_HAS_TIMESTAMPS;
+    present[SECTION_ADDRESSES] = present[SECTION_ADDRESS_INDEX] = header->flags & SNAPSHOT_HAS_ADDRESSES;
+    present[SECTION_EDGE_COUNTS] = present[SECTION_VALUE_SUMS] = present[SECTION_VALUE_MINS] =
+        header->flags & SNAPSHOT_COLLAPSED;
+    if (present[SECTION_ADDRESS_INDEX]) { // Any power of two of at least twice the wallets.
+        size_t slots = header->sections[SECTION_ADDRESS_INDEX].size / sizeof(uint32_t);
+        bool valid = slots > 0 && slots >= 2 * header->vertices && (slots & (slots - 1)) == 0;
+        sizes[SECTION_ADDRESS_INDEX] = valid ? slots * sizeof(uint32_t) : SIZE_MAX;
+    }
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++) {
+        const snapshot_section_t *section = &header->sections[s];
+        if (!present[s] && (section->offset != 0 || section->size != 0)) {
+            fprintf(stderr, "ERROR: %s has a corrupt section table\n", path);
+            return -1;
+        }
+        if (!present[s]) continue;
+        if (section->size != sizes[s] || section->offset % SNAPSHOT_ALIGNMENT != 0
+            || section->offset < sizeof(snapshot_header_t) || section->offset > size
+            || section->size > size - section->offset) {
+            fprintf(stderr, "ERROR: %s is truncated or has a corrupt section table\n", path);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the size of the payload of a delta segment.
+ * @param flags The SNAPSHOT_* flags of the snapshot.
+ * @param vertices The wallets added by the segment.
+ * @param edges The edges appended by the segment.
+ * @return The size in bytes.
+ */
+static uint64_t delta_payload_size(uint32_t flags, uint64_t vertices, uint64_t edges) {
+    uint64_t edge = 2 * sizeof(vertex) + sizeof(uint256_t) + (flags & SNAPSHOT_HAS_TIMESTAMPS ? sizeof(uint64_t) : 0);
+    return edges * edge + vertices * sizeof(address_t);
+}
+
+/**
+ * @brief Copies the delta segments of a mapped snapshot into a delta.
+ *
+ * Segments are walked from the last one back; each must fill the range of
+ * wallets and edges just below the next one, and every checksum is verified,
+ * since the payload is read anyway.
+ *
+ * @param header The header.
+ * @param size The size of the file.
+ * @param path The file name, for messages.
+ * @param delta The delta, with its arrays allocated for the totals of the header.
+ * @return The number of segments, or -1 if one is corrupt (already reported).
+ */
+static long read_delta_segments(const snapshot_header_t *header, size_t size, const char *path, GraphDelta *delta) {
+    const char *base = (const char *)header;
+    bool timed = header->flags & SNAPSHOT_HAS_TIMESTAMPS;
+    uint64_t vertexEnd = header->delta_vertices, edgeEnd = header->delta_edges;
+    uint64_t vertexLimit = header->vertices + header->delta_vertices;
+    uint64_t offset = header->delta_offset, limit = size;
+    long segments = 0;
+    while (offset != 0) {
+        const snapshot_delta_t *segment = (const snapshot_delta_t *)(base + offset);
+        if (offset % SNAPSHOT_ALIGNMENT != 0 || offset < sizeof(snapshot_header_t) || offset > limit
+            || limit - offset < sizeof(snapshot_delta_t)
+            || memcmp(segment->magic, SNAPSHOT_DELTA_MAGIC, sizeof(segment->magic)) != 0
+            || segment->vertices > vertexEnd || segment->first_vertex != vertexEnd - segment->vertices
+            || segment->edges > edgeEnd || segment->first_edge != edgeEnd - segment->edges
+            || delta_payload_size(header->flags, segment->vertices, segment->edges)
+                   > limit - offset - sizeof(snapshot_delta_t)) {
+            fprintf(stderr, "ERROR: %s is truncated or has a corrupt delta segment\n", path);
+            return -1;
+        }
+        const char *p = (const char *)(segment + 1);
+        if (snapshot_hash(p, delta_payload_size(header->flags, segment->vertices, segment->edges))
+            != segment->checksum) {
+            fprintf(stderr, "ERROR: %s is corrupt: a delta segment fails its checksum\n", path);
+            return -1;
+        }
+        size_t first = segment->first_edge, edges = segment->edges;
+        memcpy(delta->sources + first, p, edges * sizeof(vertex));
+        p += edges * sizeof(vertex);
+        memcpy(delta->destinations + first, p, edges * sizeof(vertex));
+        p += edges * sizeof(vertex);
+        memcpy(delta->values + first, p, edges * sizeof(uint256_t));
+        p += edges * sizeof(uint256_t);
+        if (timed) {
+            memcpy(delta->timestamps + first, p, edges * sizeof(uint64_t));
+            p += edges * sizeof(uint64_t);
+        }
+        memcpy(delta->addresses + segment->first_vertex, p, segment->vertices * sizeof(address_t));
+        for (size_t e = first; e < first + edges; e++) {
+            if ((uint64_t)delta->sources[e] >= vertexLimit || (uint64_t)delta->destinations[e] >= vertexLimit) {
+                fprintf(stderr, "ERROR: %s is corrupt: a delta segment has an unknown wallet\n", path);
+                return -1;
+            }
+        }
+        vertexEnd = segment->first_vertex;
+        edgeEnd = segment->first_edge;
+        limit = offset; // Segments only chain backwards, so the walk ends.
+        offset = segment->previous;
+        segments++;
+    }
+    if (vertexEnd != 0 || edgeEnd != 0) {
+        fprintf(stderr, "ERROR: %s is corrupt: its delta segments do not add up\n", path);
+        return -1;
+    }
+    return segments;
+}
+
+/**
+ * @brief Opens a snapshot file, keeping its appended transactions apart.
+ * @param path The file name.
+ * @param verify Also verify the checksum of every section, reading the whole file.
+ * @param delta Receives the transactions appended by snapshot_append(), all saved, and the address index.
+ * @param logger The logging function.
+ * @return The graph, or NULL on failure (already reported).
+ */
+Graph snapshot_open(const char *path, bool verify, GraphDelta *delta, log_function_t logger) {
+    double start = wall_seconds();
+    memset(delta, 0, sizeof(*delta));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("ERROR: opening snapshot file");
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        fprintf(stderr, "ERROR: %s is not a graph snapshot\n", path);
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("ERROR: mapping snapshot file");
+        return NULL;
+    }
+
+    const snapshot_header_t *header = map;
+    if (check_header(header, size, path) != 0) {
+        munmap(map, size);
+        return NULL;
+    }
+    const char *base = map;
+    const void *section[SNAPSHOT_SECTIONS];
+    for (int s = 0; s < SNAPSHOT_SECTIONS; s++) {
+        section[s] = header->sections[s].offset ? base + header->sections[s].offset : NULL;
+        if (verify && section[s] && snapshot_hash(section[s], header->sections[s].size) != header->sections[s].checksum) {
+            fprintf(stderr, "ERROR: %s is corrupt: section %d fails its checksum\n", path, s);
+            munmap(map, size);
+            return NULL;
+        }
+    }
+    const size_t *offsets = section[SECTION_OFFSETS];
+    if (offsets[0] != 0 || offsets[header->vertices] != header->edges) {
+        fprintf(stderr, "ERROR: %s is corrupt: its row offsets do not match the edge count\n", path);
+        munmap(map, size);
+        return NULL;
+    }
+
+    size_t V = header->delta_vertices, E = header->delta_edges;
+    if (V > 0 || E > 0) {
+        delta->addresses = malloc((V ? V : 1) * sizeof(address_t));
+        delta->sources = malloc((E ? E : 1) * sizeof(vertex));
+        delta->destinations = malloc((E ? E : 1) * sizeof(vertex));
+        delta->values = malloc((E ? E : 1) * sizeof(uint256_t));
+        if (header->flags & SNAPSHOT_HAS_TIMESTAMPS) delta->timestamps = malloc((E ? E : 1) * sizeof(uint64_t));
+        if (!delta->addresses || !delta->sources || !delta->destinations || !delta->values
+            || (header->flags & SNAPSHOT_HAS_TIMESTAMPS && !delta->timestamps)) {
+            fprintf(stderr, "ERROR: bad alloc for the appended transactions\n");
+            exit(EXIT_FAILURE);
+        }
+        delta->vertexAmount = delta->vertexCapacity = delta->savedVertices = V;
+        delta->edgesAmount = delta->edgeCapacity = delta->savedEdges = E;
+    }
+    long segments = read_delta_segments(header, size, path, delta);
+    if (segments < 0) {
+        freeGraphDelta(delta);
+        munmap(map, size);
+        return NULL;
+    }
+    delta->index = section[SECTION_ADDRESS_INDEX];
+    delta->indexCapacity = header->sections[SECTION_ADDRESS_INDEX].size / sizeof(uint32_t);
+
+    Graph G = initGraph(header->vertices);
+    free(G->pending); // Born built: no edge buffer.
+    G->pending = NULL;
+    G->pendingCapacity = 0;
+    G->edgesAmount = header->edges;
+    G->offsets = (size_t *)section[SECTION_OFFSETS];
+    G->destinations = (vertex *)section[SECTION_DESTINATIONS];
+    G->values = (uint256_t *)section[SECTION_VALUES];
+    G->timestamps = (uint64_t *)section[SECTION_TIMESTAMPS];
+    G->hasTimestamps = G->timestamps != NULL;
+    G->addresses = (address_t *)section[SECTION_ADDRESSES];
+    G->edgeCounts = (uint32_t *)section[SECTION_EDGE_COUNTS];
+    G->valueSums = (uint256_t *)section[SECTION_VALUE_SUMS];
+    G->valueMins = (uint256_t *)section[SECTION_VALUE_MINS];
+    G->mapping = map;
+    G->mappingSize = size;
+
+    logger("Runtime to load snapshot%s: %lf seconds\n", verify ? " (verified)" : "", wall_seconds() - start);
+    logger("Total unique wallets (vertices): %zu\n", G->vertexAmount + delta->vertexAmount);
+    logger("Total transactions (edges): %zu\n", G->edgesAmount + delta->edgesAmount);
+    if (segments > 0) {
+        logger("Appended since the last compaction: %zu transactions in %ld segments\n", delta->edgesAmount, segments);
+    }
+    return G;
+}
+
+/**
+ * @brief Reopens a graph from a snapshot file.
+ * @param path The file name.
+ * @param verify Also verify the checksum of every section, reading the whole file.
+ * @param logger The logging function.
+ * @return The graph, or NULL on failure (already reported).
+ */
+Graph snapshot_load(const char *path, bool verify, log_function_t logger) {
+    GraphDelta delta;
+    Graph G = snapshot_open(path, verify, &delta, logger);
+    if (G == NULL) return NULL;
+    if (delta.edgesAmount > 0 || delta.vertexAmount > 0) {
+        double start = wall_seconds();
+        mergeGraphDelta(G, &delta);
+        logger("Runtime to merge appended transactions: %lf seconds\n", wall_seconds() - start);
+    }
+    freeGraphDelta(&delta);
+    return G;
+}
+
+/**
+ * @brief Writes the fresh part of a delta as a new segment at the end of a snapshot.
+ * @param G The graph the snapshot holds.
+ * @param delta The delta.
+ * @param path The file name.
+ * @return 0 on success, -1 on failure (already reported).
+ */
+static int append_segment(Graph G, GraphDelta *delta, const char *path) {
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        perror("ERROR: opening snapshot file");
+        return -1;
+    }
+    snapshot_header_t header;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+        || check_header(&header, (size_t)st.st_size, path) != 0 || header.vertices != G->vertexAmount
+        || header.edges != G->edgesAmount || header.delta_vertices != delta->savedVertices
+        || header.delta_edges != delta->savedEdges) {
+        fprintf(stderr, "ERROR: %s changed since it was opened\n", path);
+        close(fd);
+        return -1;
+    }
+
+    bool timed = header.flags & SNAPSHOT_HAS_TIMESTAMPS;
+    size_t edges = delta->edgesAmount - delta->savedEdges;
+    size_t vertices = delta->vertexAmount - delta->savedVertices;
+    size_t payload = (size_t)delta_payload_size(header.flags, vertices, edges);
+    char *segment = malloc(sizeof(snapshot_delta_t) + payload);
+    if (!segment) {
+        fprintf(stderr, "ERROR: bad alloc for the delta segment\n");
+        close(fd);
+        return -1;
+    }
+    char *p = segment + sizeof(snapshot_delta_t);
+    size_t first = delta->savedEdges;
+    memcpy(p, delta->sources + first, edges * sizeof(vertex));
+    p += edges * sizeof(vertex);
+    memcpy(p, delta->destinations + first, edges * sizeof(vertex));
+    p += edges * sizeof(vertex);
+    memcpy(p, delta->values + first, edges * sizeof(uint256_t));
+    p += edges * sizeof(uint256_t);
+    if (timed) {
+        memcpy(p, delta->timestamps + first, edges * sizeof(uint64_t));
+        p += edges * sizeof(uint64_t);
+    }
+    memcpy(p, delta->addresses + delta->savedVertices, vertices * sizeof(address_t));
+
+    snapshot_delta_t info;
+    memset(&info, 0, sizeof(info));
+    memcpy(info.magic, SNAPSHOT_DELTA_MAGIC, sizeof(info.magic));
+    info.previous = header.delta_offset;
+    info.first_vertex = delta->savedVertices;
+    info.vertices = vertices;
+    info.first_edge = delta->savedEdges;
+    info.edges = edges;
+    info.checksum = snapshot_hash(segment + sizeof(snapshot_delta_t), payload);
+    memcpy(segment, &info, sizeof(info));
+
+    // The segment goes past the end of the file first; rewriting the header commits it.
+    uint64_t offset = align_offset((uint64_t)st.st_size);
+    size_t length = sizeof(snapshot_delta_t) + payload;
+    header.delta_offset = offset;
+    header.delta_vertices = delta->vertexAmount;
+    header.delta_edges = delta->edgesAmount;
+    header.checksum = 0;
+    header.checksum = snapshot_hash(&header, sizeof(header));
+    bool ok = pwrite(fd, segment, length, (off_t)offset) == (ssize_t)length && fsync(fd) == 0
+              && pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && fsync(fd) == 0;
+    free(segment);
+    if (close(fd) != 0) ok = false;
+    if (!ok) {
+        perror("ERROR: writing snapshot file");
+        return -1;
+    }
+    delta->savedVertices = delta->vertexAmount;
+    delta->savedEdges = delta->edgesAmount;
+    return 0;
+}
+
+/**
+ * @brief Stores the transactions appended in this run in the snapshot they were appended to.
+ * @param G The graph, as opened by snapshot_open().
+ * @param delta The delta filled by snapshot_open() and loadGraphDelta().
+ * @param path The file name of the snapshot.
+ * @param logger The logging function.
+ * @return 0 on success, -1 on failure (already reported).
+ */
+int snapshot_append(Graph G, GraphDelta *delta, const char *path, log_function_t logger) {
+    if (delta->edgesAmount == delta->savedEdges && delta->vertexAmount == delta->savedVertices) return 0;
+    double start = wall_seconds();
+    if (delta->edgesAmount * SNAPSHOT_COMPACT_RATIO > G->edgesAmount) {
+        mergeGraphDelta(G, delta);
+        if (snapshot_save(G, path) != 0) return -1;
+        logger("Runtime to compact snapshot: %lf seconds\n", wall_seconds() - start);
+        return 0;
+    }
+    if (append_segment(G, delta, path) != 0) return -1;
+    logger("Runtime to append to snapshot: %lf seconds\n", wall_seconds() - start);
+    return 0;
+}
+
+ /** @} */
@@ -0,0 +1,104 @@
+/**
+ * @file snapshot.h
+ * @brief Defines a binary snapshot of a built graph that reopens without parsing.
+ *
+ * Loading a text dump parses every line, interns every address and parses
+ * every Wei string. A snapshot stores the result instead: the CSR arrays, the
+ * fixed-width values, the optional timestamps and parallel-edge aggregates,
+ * and the id -> address table, each in its own 64-byte aligned section laid
+ * out exactly as in memory. Reopening maps the file read-only and points the
+ * graph at the sections, so it costs a few system calls whatever the size,
+ * and pages are read only when the search touches them.
+ *
+ * The header holds a magic, the format version, a byte-order tag, the vertex
+ * and edge counts and a table of sections, each with its offset, size and a
+ * checksum of its bytes. The header carries its own checksum, which is always
+ * verified; the section checksums are verified on request, since that reads
+ * the whole file. A snapshot is only readable on a machine with the same byte
+ * order and 64-bit size_t.
+ *
+ * With the addresses comes a read-only index of them, so that a later run can
+ * append transactions (snapshot_append()) after looking up only their own
+ * wallets. Appended transactions are stored as delta segments at the end of
+ * the file, each chained to the one before; the segment is written and synced
+ * first and rewriting the header commits it, so an interrupted append leaves
+ * the previous snapshot intact. Once the delta grows past a fraction of the
+ * graph, the snapshot is compacted into a plain one instead.
+ */
+
+#ifndef C5E17A93_0D2B_4F6C_A8E4_97B3D1F06C52
+#define C5E17A93_0D2B_4F6C_A8E4_97B3D1F06C52
+
+#include <stdbool.h>
+
+#include "graph.h"
+
+/**
+ * @def SNAPSHOT_VERSION
+ * @brief The version of the snapshot format written.
+ */
+#define SNAPSHOT_VERSION 2
+
+/**
+ * @def SNAPSHOT_COMPACT_RATIO
+ * @brief The snapshot is compacted once its delta has more than 1 / SNAPSHOT_COMPACT_RATIO of the base edges.
+ */
+#define SNAPSHOT_COMPACT_RATIO 8
+
+/**
+ * @brief Writes a graph to a snapshot file.
+ *
+ * The file is replaced atomically: it is written under path.tmp and renamed.
+ *
+ * @param G The graph. Its CSR must be built.
+ * @param path The file name.
+ * @return 0 on success, -1 on failure (already reported).
+ */
+int snapshot_save(Graph G, const char *path);
+
+/**
+ * @brief Reopens a graph from a snapshot file.
+ *
+ * The graph's arrays point into a read-only mapping of the file (see
+ * GraphDS.mapping); freeGraph() unmaps it.
+ *
+ * @param path The file name.
+ * @param verify Also verify the checksum of every section, reading the whole file.
+ * @param logger The logging function.
+ * @return The graph, or NULL on failure (already reported).
+ */
+Graph snapshot_load(const char *path, bool verify, log_function_t logger);
+
+/**
+ * @brief Opens a snapshot file, keeping its appended transactions apart.
+ *
+ * Like snapshot_load(), but the delta segments are not merged: they are
+ * copied into the delta, marked as saved, and the graph is the mapped base.
+ * The checksums of the segments are always verified. The delta also gets the
+ * address index of the snapshot, for loadGraphDelta().
+ *
+ * @param path The file name.
+ * @param verify Also verify the checksum of every section, reading the whole file.
+ * @param delta Receives the appended transactions; freeGraphDelta() releases it.
+ * @param logger The logging function.
+ * @return The graph, or NULL on failure (already reported).
+ */
+Graph snapshot_open(const char *path, bool verify, GraphDelta *delta, log_function_t logger);
+
+/**
+ * @brief Stores the transactions appended in this run in the snapshot they were appended to.
+ *
+ * The part of the delta not saved yet becomes a new delta segment; if the
+ * whole delta would then hold more than 1 / SNAPSHOT_COMPACT_RATIO of the
+ * graph's edges, the delta is merged into the graph (mergeGraphDelta()) and
+ * the snapshot rewritten instead.
+ *
+ * @param G The graph, as opened by snapshot_open().
+ * @param delta The delta filled by snapshot_open() and loadGraphDelta().
+ * @param path The file name of the snapshot.
+ * @param logger The logging function.
+ * @return 0 on success, -1 on failure (already reported).
+ */
+int snapshot_append(Graph G, GraphDelta *delta, const char *path, log_function_t logger);
+
+#endif /* C5E17A93_0D2B_4F6C_A8E4_97B3D1F06C52 */
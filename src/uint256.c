@@ -0,0 +1,100 @@
+/**
+ * @file uint256.c
+ * @brief Implementation of the uint256_t conversions.
+ * @defgroup uint256 256-bit Integers
+ * @{
+ */
+
+#include "uint256.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @def DEC_CHUNK
+ * @brief The largest power of ten that fits in 64 bits, used to print 19 digits at a time.
+ */
+#define DEC_CHUNK 10000000000000000000ull
+
+/**
+ * @brief Converts a GMP integer to a uint256_t.
+ * @param out Receives the value.
+ * @param in The GMP integer.
+ * @return 0 on success, -1 if the value is negative or does not fit in 256 bits.
+ */
+int uint256_from_mpz(uint256_t *out, const mpz_t in) {
+    if (mpz_sgn(in) < 0 || mpz_sizeinbase(in, 2) > 256) return -1;
+
+    size_t count = 0;
+    memset(out, 0, sizeof(*out));
+    mpz_export(out->limb, &count, -1, sizeof(uint64_t), 0, 0, in);
+    return 0;
+}
+
+/**
+ * @brief Converts a uint256_t to a GMP integer.
+ * @param out An initialized GMP integer that receives the value.
+ * @param in The value.
+ */
+void uint256_to_mpz(mpz_t out, const uint256_t *in) {
+    mpz_import(out, UINT256_LIMBS, -1, sizeof(uint64_t), 0, 0, in->limb);
+}
+
+/**
+ * @brief Writes the decimal representation of a little-endian limb array.
+ *
+ * Divides by 10^19 limb by limb with 128-bit arithmetic, so printing needs
+ * neither GMP nor a digit-by-digit loop.
+ *
+ * @param limbs The value; destroyed.
+ * @param count The number of limbs, at most UINT320_LIMBS.
+ * @param buf Receives the digits.
+ * @return buf.
+ */
+static char *limbs_to_dec(uint64_t *limbs, int count, char *buf) {
+    uint64_t chunks[6];
+    int chunk_count = 0;
+    uint64_t nonzero;
+
+    do {
+        unsigned __int128 rem = 0;
+        nonzero = 0;
+        for (int i = count - 1; i >= 0; i--) {
+            unsigned __int128 cur = (rem << 64) | limbs[i];
+            limbs[i] = (uint64_t)(cur / DEC_CHUNK);
+            rem = cur % DEC_CHUNK;
+            nonzero |= limbs[i];
+        }
+        chunks[chunk_count++] = (uint64_t)rem;
+    } while (nonzero);
+
+    int len = sprintf(buf, "%llu", (unsigned long long)chunks[--chunk_count]);
+    while (chunk_count > 0) {
+        len += sprintf(buf + len, "%019llu", (unsigned long long)chunks[--chunk_count]);
+    }
+    return buf;
+}
+
+/**
+ * @brief Writes the decimal representation of a value.
+ * @param in The value.
+ * @param buf A buffer of at least UINT256_DEC_SIZE bytes.
+ * @return buf.
+ */
+char *uint256_to_dec(const uint256_t *in, char *buf) {
+    uint256_t n = *in;
+    return limbs_to_dec(n.limb, UINT256_LIMBS, buf);
+}
+
+/**
+ * @brief Writes the decimal representation of a 320-bit value.
+ * @param in The value.
+ * @param buf A buffer of at least UINT320_DEC_SIZE bytes.
+ * @return buf.
+ */
+char *uint320_to_dec(const uint320_t *in, char *buf) {
+    uint320_t n = *in;
+    return limbs_to_dec(n.limb, UINT320_LIMBS, buf);
+}
+
+ /** @} */
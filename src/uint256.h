@@ -0,0 +1,193 @@
+/**
+ * @file uint256.h
+ * @brief Defines a fixed-width 256-bit unsigned integer for Wei values.
+ *
+ * Ethereum values are bounded by uint256, so they fit inline in four 64-bit
+ * limbs. Unlike mpz_t this needs no heap allocation, no init/clear calls and
+ * can be copied with a plain assignment. Comparisons and arithmetic are small
+ * inline functions; GMP is only used to convert from and to arbitrary precision.
+ */
+
+#ifndef C8E4B1A7_3F29_4D6C_A0B5_7E91D2F36C08
+#define C8E4B1A7_3F29_4D6C_A0B5_7E91D2F36C08
+
+#include <gmp.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @def UINT256_LIMBS
+ * @brief Number of 64-bit limbs in a uint256_t.
+ */
+#define UINT256_LIMBS 4
+
+/**
+ * @def UINT256_DEC_SIZE
+ * @brief Buffer size needed by uint256_to_dec: 78 digits plus the terminator.
+ */
+#define UINT256_DEC_SIZE 80
+
+/**
+ * @def UINT320_LIMBS
+ * @brief Number of 64-bit limbs in a uint320_t.
+ */
+#define UINT320_LIMBS 5
+
+/**
+ * @def UINT320_DEC_SIZE
+ * @brief Buffer size needed by uint320_to_dec: 97 digits plus the terminator.
+ */
+#define UINT320_DEC_SIZE 100
+
+/**
+ * @struct uint256_t
+ * @brief A 256-bit unsigned integer.
+ */
+typedef struct {
+    uint64_t limb[UINT256_LIMBS]; /**< The limbs, least significant first. */
+} uint256_t;
+
+/**
+ * @struct uint320_t
+ * @brief A 320-bit unsigned integer, for sums of uint256_t values.
+ *
+ * The extra limb holds the carries of up to 2^64 additions, so a sum of Wei
+ * values can never overflow.
+ */
+typedef struct {
+    uint64_t limb[UINT320_LIMBS]; /**< The limbs, least significant first. */
+} uint320_t;
+
+/**
+ * @brief Returns a uint256_t holding a 64-bit value.
+ */
+static inline uint256_t uint256_from_u64(uint64_t x) {
+    uint256_t r = {{x, 0, 0, 0}};
+    return r;
+}
+
+/**
+ * @brief Returns a uint256_t holding a 128-bit value.
+ */
+static inline uint256_t uint256_from_u128(unsigned __int128 x) {
+    uint256_t r = {{(uint64_t)x, (uint64_t)(x >> 64), 0, 0}};
+    return r;
+}
+
+/**
+ * @brief Compares two values.
+ * @return A negative value if a < b, 0 if a == b, a positive value if a > b.
+ */
+static inline int uint256_cmp(const uint256_t *a, const uint256_t *b) {
+    for (int i = UINT256_LIMBS - 1; i >= 0; i--) {
+        if (a->limb[i] != b->limb[i]) return a->limb[i] < b->limb[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Tells whether a value is zero.
+ */
+static inline int uint256_is_zero(const uint256_t *a) {
+    return (a->limb[0] | a->limb[1] | a->limb[2] | a->limb[3]) == 0;
+}
+
+/**
+ * @brief Computes out = a + b modulo 2^256.
+ * @return The carry out of the most significant limb (0 or 1).
+ */
+static inline unsigned uint256_add(uint256_t *out, const uint256_t *a, const uint256_t *b) {
+    unsigned __int128 acc = 0;
+    for (int i = 0; i < UINT256_LIMBS; i++) {
+        acc += (unsigned __int128)a->limb[i] + b->limb[i];
+        out->limb[i] = (uint64_t)acc;
+        acc >>= 64;
+    }
+    return (unsigned)acc;
+}
+
+/**
+ * @brief Computes out = a * m modulo 2^256.
+ * @return The part of the product above 2^256; non-zero means the result overflowed.
+ */
+static inline uint64_t uint256_mul_u64(uint256_t *out, const uint256_t *a, uint64_t m) {
+    unsigned __int128 acc = 0;
+    for (int i = 0; i < UINT256_LIMBS; i++) {
+        acc += (unsigned __int128)a->limb[i] * m;
+        out->limb[i] = (uint64_t)acc;
+        acc >>= 64;
+    }
+    return (uint64_t)acc;
+}
+
+/**
+ * @brief Returns a pointer to the larger of two values.
+ */
+static inline const uint256_t *uint256_max(const uint256_t *a, const uint256_t *b) {
+    return uint256_cmp(a, b) < 0 ? b : a;
+}
+
+/**
+ * @brief Returns a pointer to the smaller of two values.
+ */
+static inline const uint256_t *uint256_min(const uint256_t *a, const uint256_t *b) {
+    return uint256_cmp(a, b) > 0 ? b : a;
+}
+
+/**
+ * @brief Computes out = a + b.
+ */
+static inline void uint320_add_u256(uint320_t *out, const uint320_t *a, const uint256_t *b) {
+    unsigned __int128 acc = 0;
+    for (int i = 0; i < UINT256_LIMBS; i++) {
+        acc += (unsigned __int128)a->limb[i] + b->limb[i];
+        out->limb[i] = (uint64_t)acc;
+        acc >>= 64;
+    }
+    out->limb[UINT256_LIMBS] = a->limb[UINT256_LIMBS] + (uint64_t)acc;
+}
+
+/**
+ * @brief Computes out = a - b modulo 2^320; a must not be smaller than b.
+ */
+static inline void uint320_sub(uint320_t *out, const uint320_t *a, const uint320_t *b) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < UINT320_LIMBS; i++) {
+        uint64_t x = a->limb[i], y = b->limb[i];
+        out->limb[i] = x - y - borrow;
+        borrow = (x < y) | ((x == y) & borrow);
+    }
+}
+
+/**
+ * @brief Converts a GMP integer to a uint256_t.
+ * @param out Receives the value.
+ * @param in The GMP integer.
+ * @return 0 on success, -1 if the value is negative or does not fit in 256 bits.
+ */
+int uint256_from_mpz(uint256_t *out, const mpz_t in);
+
+/**
+ * @brief Converts a uint256_t to a GMP integer.
+ * @param out An initialized GMP integer that receives the value.
+ * @param in The value.
+ */
+void uint256_to_mpz(mpz_t out, const uint256_t *in);
+
+/**
+ * @brief Writes the decimal representation of a value.
+ * @param in The value.
+ * @param buf A buffer of at least UINT256_DEC_SIZE bytes.
+ * @return buf.
+ */
+char *uint256_to_dec(const uint256_t *in, char *buf);
+
+/**
+ * @brief Writes the decimal representation of a 320-bit value.
+ * @param in The value.
+ * @param buf A buffer of at least UINT320_DEC_SIZE bytes.
+ * @return buf.
+ */
+char *uint320_to_dec(const uint320_t *in, char *buf);
+
+#endif /* C8E4B1A7_3F29_4D6C_A0B5_7E91D2F36C08 */
@@ -7,6 +7,7 @@
  */  
 
 #include "wei_parser.h"
+#include "simd_parse.h"
 #include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
@@ -26,8 +27,23 @@ struct parse_wei_ctx_t {
     mpz_t remainder;
     /** @var pow10_cache An array caching pre-calculated powers of 10. */
     mpz_t pow10_cache[POW10_CACHE_SIZE];
+    /** @var slow_result Receives GMP results that must be narrowed to uint256_t. */
+    mpz_t slow_result;
+    /** @var pow10_u128 Powers of 10 that fit in 128 bits, for the fast path. */
+    unsigned __int128 pow10_u128[WEI_FAST_DIGITS + 1];
 };
 
+/**
+ * @struct wei_scan_t
+ * @brief A number decomposed by the fast path as mantissa * 10^power.
+ */
+typedef struct {
+    /** @var mantissa The significant digits, with zeros that only scale the value left out. */
+    unsigned __int128 mantissa;
+    /** @var power The decimal exponent applied to the mantissa. */
+    long power;
+} wei_scan_t;
+
 /**
  * @brief Allocates and initializes the context required for the parser.
  * @return A pointer to the allocated context, or NULL on allocation failure.
@@ -41,6 +57,12 @@ parse_wei_ctx_t* parse_wei_ctx_create() {
     mpz_init(ctx->mantissa_int);
     mpz_init(ctx->power_of_10);
     mpz_init(ctx->remainder);
+    mpz_init(ctx->slow_result);
+
+    ctx->pow10_u128[0] = 1;
+    for (int i = 1; i <= WEI_FAST_DIGITS; ++i) {
+        ctx->pow10_u128[i] = ctx->pow10_u128[i - 1] * 10;
+    }
 
     // Pre-compute powers of 10 and store them in the cache
     mpz_init_set_ui(ctx->pow10_cache[0], 1);
@@ -61,6 +83,7 @@ void parse_wei_ctx_free(parse_wei_ctx_t *ctx) {
     mpz_clear(ctx->mantissa_int);
     mpz_clear(ctx->power_of_10);
     mpz_clear(ctx->remainder);
+    mpz_clear(ctx->slow_result);
     for (int i = 0; i < POW10_CACHE_SIZE; ++i) {
         mpz_clear(ctx->pow10_cache[i]);
     }
@@ -68,6 +91,9 @@ void parse_wei_ctx_free(parse_wei_ctx_t *ctx) {
     free(ctx);
 }
 
+// Forward declaration for the GMP slow path
+static int parse_wei_gmp(parse_wei_ctx_t *ctx, const char *s, size_t len, mpz_t out);
+
 /**
  * @brief Converts a numeric string to a Wei integer value.
  * @param ctx The parser context.
@@ -76,11 +102,222 @@ void parse_wei_ctx_free(parse_wei_ctx_t *ctx) {
  * @return 0 on success, or a negative error code.
  */
 int parse_wei_optimized(parse_wei_ctx_t *ctx, const char *s, mpz_t out) {
+    return parse_wei_n(ctx, s, strlen(s), out);
+}
+
+/**
+ * @brief Parses the exponent that follows an 'e'/'E', like strtol but bounded.
+ * @param p The first character after the 'e'.
+ * @param end One past the last character of the number.
+ * @return The exponent value. Parsing stops at the first non-digit.
+ */
+static long parse_exponent(const char *p, const char *end) {
+    int negative = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = (*p == '-');
+        p++;
+    }
+
+    long value = 0;
+    for (; p < end && isdigit((unsigned char)*p); ++p) {
+        if (value < 100000000) value = value * 10 + (*p - '0');
+    }
+    return negative ? -value : value;
+}
+
+/**
+ * @brief Decomposes a number into a 128-bit mantissa and a power of ten.
+ *
+ * Zeros are not multiplied in as they are read: they are counted, and only
+ * applied once a non-zero digit follows. Trailing zeros of the integer part go
+ * into the power, and trailing zeros of the fraction (the ".0" of the input
+ * pipeline) are dropped. So "1500000000000000000.0" becomes 15 * 10^17 without
+ * any multiplication by zero digits.
+ *
+ * @param ctx The parser context.
+ * @param s The first character of the number.
+ * @param len The number of characters in the number.
+ * @param out Receives the decomposition.
+ * @return 0 on success, -1 for an invalid number, 1 if the mantissa needs more
+ *         than WEI_FAST_DIGITS digits and the GMP path must be used.
+ */
+static int scan_wei(const parse_wei_ctx_t *ctx, const char *s, size_t len, wei_scan_t *out) {
+    const char *p = s;
+    const char *end = s + len;
+    if (p < end && (*p == '+' || *p == '-')) p++;
+
+    unsigned __int128 mantissa = 0;
+    long int_zeros = 0, frac_zeros = 0, decimal_places = 0, exponent_val = 0;
+    int dot_found = 0;
+    int has_digits = 0;
+    int try_blocks = 1; // cleared once a block hits a non-digit, set again after the '.'
+
+    for (; p < end; ++p) {
+        // Whole runs of 16 digits are converted by the SIMD kernel and applied at once.
+        uint64_t block;
+        if (try_blocks && end - p >= 16) {
+            if (simd_parse_digits16(p, &block) == 0) {
+                has_digits = 1;
+                if (block == 0) {
+                    if (dot_found) frac_zeros += 16;
+                    else int_zeros += 16;
+                } else {
+                    long shift = int_zeros + frac_zeros + 16;
+                    if (shift > WEI_FAST_DIGITS || mantissa >= ctx->pow10_u128[WEI_FAST_DIGITS - shift]) {
+                        return 1;
+                    }
+                    mantissa = mantissa * ctx->pow10_u128[shift] + block;
+                    if (dot_found) decimal_places += frac_zeros + 16;
+                    int_zeros = 0;
+                    frac_zeros = 0;
+                }
+                p += 15;
+                continue;
+            }
+            try_blocks = 0;
+        }
+
+        unsigned d = (unsigned char)*p - '0';
+        if (d <= 9) {
+            has_digits = 1;
+            if (d == 0) {
+                if (dot_found) frac_zeros++;
+                else int_zeros++;
+                continue;
+            }
+            // Apply the pending zeros and the digit: mantissa * 10^(zeros + 1) + d.
+            long shift = int_zeros + frac_zeros + 1;
+            if (shift > WEI_FAST_DIGITS || mantissa >= ctx->pow10_u128[WEI_FAST_DIGITS - shift]) {
+                return 1;
+            }
+            mantissa = mantissa * ctx->pow10_u128[shift] + d;
+            if (dot_found) decimal_places += frac_zeros + 1;
+            int_zeros = 0;
+            frac_zeros = 0;
+        } else if (*p == '.' && !dot_found) {
+            dot_found = 1;
+            try_blocks = 1;
+        } else if (*p == 'e' || *p == 'E') {
+            exponent_val = parse_exponent(p + 1, end);
+            break;
+        } else {
+            return -1; // Invalid character
+        }
+    }
+
+    if (!has_digits) return -1; // No digits found
+
+    out->mantissa = mantissa;
+    out->power = exponent_val + int_zeros - decimal_places;
+    return 0;
+}
+
+/**
+ * @brief Applies a negative power of ten to a scanned mantissa.
+ * @param ctx The parser context.
+ * @param scan The scanned number, with scan->power < 0. Its mantissa is divided in place.
+ * @return 0 on success, -2 if the result is not a whole number.
+ */
+static int scale_down(const parse_wei_ctx_t *ctx, wei_scan_t *scan) {
+    if (scan->mantissa == 0) return 0;
+    long divisor_exp = -scan->power;
+    if (divisor_exp > WEI_FAST_DIGITS) return -2; // mantissa < 10^38 cannot be a multiple
+    if (scan->mantissa % ctx->pow10_u128[divisor_exp] != 0) return -2;
+    scan->mantissa /= ctx->pow10_u128[divisor_exp];
+    scan->power = 0;
+    return 0;
+}
+
+/**
+ * @brief Converts a numeric string slice to a Wei integer value.
+ * @param ctx The parser context.
+ * @param s The first character of the number.
+ * @param len The number of characters in the number.
+ * @param out A pointer to the mpz_t variable that will receive the result.
+ * @return 0 on success, or a negative error code.
+ */
+int parse_wei_n(parse_wei_ctx_t *ctx, const char *s, size_t len, mpz_t out) {
+    wei_scan_t scan;
+    int status = scan_wei(ctx, s, len, &scan);
+    if (status < 0) return status;
+    if (status > 0) return parse_wei_gmp(ctx, s, len, out);
+
+    if (scan.power < 0 && scale_down(ctx, &scan) != 0) return -2;
+
+    if (scan.power > 0 && scan.power <= WEI_FAST_DIGITS
+        && scan.mantissa <= (~(unsigned __int128)0) / ctx->pow10_u128[scan.power]) {
+        scan.mantissa *= ctx->pow10_u128[scan.power];
+        scan.power = 0;
+    }
+
+    uint64_t limbs[2] = {(uint64_t)scan.mantissa, (uint64_t)(scan.mantissa >> 64)};
+    mpz_import(out, 2, -1, sizeof(uint64_t), 0, 0, limbs);
+    if (scan.power > 0) {
+        if (scan.power < POW10_CACHE_SIZE) {
+            mpz_mul(out, out, ctx->pow10_cache[scan.power]);
+        } else {
+            mpz_ui_pow_ui(ctx->power_of_10, 10, scan.power);
+            mpz_mul(out, out, ctx->power_of_10);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Converts a numeric string slice to a uint256_t Wei value.
+ * @param ctx The parser context.
+ * @param s The first character of the number.
+ * @param len The number of characters in the number.
+ * @param out Receives the result.
+ * @return 0 on success, or a negative error code.
+ */
+int parse_wei_u256(parse_wei_ctx_t *ctx, const char *s, size_t len, uint256_t *out) {
+    wei_scan_t scan;
+    int status = scan_wei(ctx, s, len, &scan);
+    if (status < 0) return status;
+    if (status > 0) {
+        status = parse_wei_gmp(ctx, s, len, ctx->slow_result);
+        if (status != 0) return status;
+        return uint256_from_mpz(out, ctx->slow_result) == 0 ? 0 : -3;
+    }
+
+    if (scan.power < 0 && scale_down(ctx, &scan) != 0) return -2;
+
+    *out = uint256_from_u128(scan.mantissa);
+    if (scan.mantissa == 0) return 0;
+
+    // Scale by 10^power, at most 10^19 (the largest power in a limb) at a time.
+    for (long power = scan.power; power > 0; power -= 19) {
+        long step = power < 19 ? power : 19;
+        if (uint256_mul_u64(out, out, (uint64_t)ctx->pow10_u128[step]) != 0) return -3;
+    }
+    return 0;
+}
+
+/**
+ * @brief Converts a numeric string slice to a Wei integer value using GMP only.
+ *
+ * Slow path for mantissas too long for the 128-bit fast path.
+ *
+ * @param ctx The parser context.
+ * @param s The first character of the number.
+ * @param len The number of characters in the number.
+ * @param out A pointer to the mpz_t variable that will receive the result.
+ * @return 0 on success, or a negative error code.
+ */
+static int parse_wei_gmp(parse_wei_ctx_t *ctx, const char *s, size_t len, mpz_t out) {
     // Reset mantissa to zero for the new operation
     mpz_set_ui(ctx->mantissa_int, 0);
 
-    const char *e_ptr = strpbrk(s, "eE");
-    const char *mantissa_end = e_ptr ? e_ptr : s + strlen(s);
+    const char *end = s + len;
+    const char *e_ptr = NULL;
+    for (const char *p = s; p < end; ++p) {
+        if (*p == 'e' || *p == 'E') {
+            e_ptr = p;
+            break;
+        }
+    }
+    const char *mantissa_end = e_ptr ? e_ptr : end;
 
     long decimal_places = 0;
     int dot_found = 0;
@@ -88,7 +325,16 @@ int parse_wei_optimized(parse_wei_ctx_t *ctx, const char *s, mpz_t out) {
 
     // Build the mantissa mathematically
     for (const char *p = s; p < mantissa_end; ++p) {
-        if (isdigit((unsigned char)*p)) {
+        uint64_t block;
+        if (mantissa_end - p >= 16 && simd_parse_digits16(p, &block) == 0) {
+            has_digits = 1;
+            mpz_mul_ui(ctx->mantissa_int, ctx->mantissa_int, 10000000000000000ul);
+            mpz_add_ui(ctx->mantissa_int, ctx->mantissa_int, block);
+            if (dot_found) {
+                decimal_places += 16;
+            }
+            p += 15;
+        } else if (isdigit((unsigned char)*p)) {
             has_digits = 1;
             mpz_mul_ui(ctx->mantissa_int, ctx->mantissa_int, 10);
             mpz_add_ui(ctx->mantissa_int, ctx->mantissa_int, *p - '0');
@@ -108,7 +354,7 @@ int parse_wei_optimized(parse_wei_ctx_t *ctx, const char *s, mpz_t out) {
 
     long exponent_val = 0;
     if (e_ptr) {
-        exponent_val = strtol(e_ptr + 1, NULL, 10);
+        exponent_val = parse_exponent(e_ptr + 1, end);
     }
 
     long final_power_of_10 = exponent_val - decimal_places;
@@ -3,17 +3,22 @@
  * @brief Defines the interface for an optimized Wei value parser.
  *
  * This parser is designed to efficiently convert string representations of numbers
- * (including decimal and scientific notation) into large integer values (mpz_t),
- * which represent the smallest unit of Ether (Wei). It uses a pre-allocated
- * context to improve performance by reusing GMP variables.
+ * (including decimal and scientific notation) into large integer values (mpz_t or
+ * uint256_t), which represent the smallest unit of Ether (Wei). Mantissas of up to
+ * 38 significant digits are accumulated in a native 128-bit integer and scaled
+ * arithmetically; only longer ones fall back to GMP, using a pre-allocated
+ * context to reuse GMP variables.
  */
 
 #ifndef E22E35BD_50BC_4CBE_9F63_17EA72FB8D1B
 #define E22E35BD_50BC_4CBE_9F63_17EA72FB8D1B
 
 #include <gmp.h>
+#include <stddef.h>
 #include <stdio.h>
 
+#include "uint256.h"
+
 /**
  * @def POW10_CACHE_SIZE
  * @brief The size of the pre-calculated powers-of-10 cache.
@@ -23,6 +28,14 @@
  */
 #define POW10_CACHE_SIZE 60
 
+/**
+ * @def WEI_FAST_DIGITS
+ * @brief The longest mantissa, in significant digits, handled without GMP.
+ *
+ * 10^38 < 2^128, so any 38-digit mantissa fits in an unsigned __int128.
+ */
+#define WEI_FAST_DIGITS 38
+
 /**
  * @struct parse_wei_ctx_t
  * @brief An opaque type for the Wei parser context.
@@ -64,4 +77,31 @@ void parse_wei_ctx_free(parse_wei_ctx_t *ctx);
  */
 int parse_wei_optimized(parse_wei_ctx_t *ctx, const char *s, mpz_t out);
 
+/**
+ * @brief Same as parse_wei_optimized, but for a string slice of known length.
+ *
+ * The slice does not need to be NUL-terminated, which lets the loader parse
+ * tokens directly from the input buffer.
+ *
+ * @param ctx The parser context.
+ * @param s The first character of the number.
+ * @param len The number of characters in the number.
+ * @param out A pointer to the mpz_t variable that will receive the result.
+ * @return The same codes as parse_wei_optimized.
+ */
+int parse_wei_n(parse_wei_ctx_t *ctx, const char *s, size_t len, mpz_t out);
+
+/**
+ * @brief Same as parse_wei_n, but produces a fixed-width uint256_t.
+ *
+ * Common inputs (integers, "123.0", "15e17") never touch GMP.
+ *
+ * @param ctx The parser context.
+ * @param s The first character of the number.
+ * @param len The number of characters in the number.
+ * @param out Receives the result.
+ * @return The same codes as parse_wei_optimized, plus -3 if the value does not fit in 256 bits.
+ */
+int parse_wei_u256(parse_wei_ctx_t *ctx, const char *s, size_t len, uint256_t *out);
+
 #endif /* E22E35BD_50BC_4CBE_9F63_17EA72FB8D1B */
\ No newline at end of file
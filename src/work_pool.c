@@ -0,0 +1,226 @@
+/**
+ * @file work_pool.c
+ * @brief Implementation of the work-stealing thread pool.
+ * @defgroup work_pool Work Pool
+ * @{
+ */
+
+#include "work_pool.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @struct work_deque_t
+ * @brief The queue of one worker; the live items are items[head .. tail).
+ */
+typedef struct {
+    pthread_mutex_t lock;        /**< Serializes the owner and the thieves. */
+    work_item_t *items;          /**< The queued items. */
+    size_t head;                 /**< Index of the oldest item, taken by thieves. */
+    size_t tail;                 /**< One past the newest item, taken by the owner. */
+    size_t capacity;             /**< The allocated size of items. */
+} work_deque_t;
+
+/**
+ * @struct work_pool_t
+ * @brief The internal structure of the pool.
+ */
+struct work_pool_t {
+    size_t workers;              /**< The number of workers. */
+    work_deque_t *deques;        /**< One queue per worker. */
+    size_t pending;              /**< Items pushed and not finished yet; accessed atomically. */
+    work_fn_t fn;                /**< The task function of the current run. */
+    void *ctx;                   /**< The context of the current run. */
+};
+
+/**
+ * @struct work_thread_t
+ * @brief The argument of a worker thread.
+ */
+typedef struct {
+    work_pool_t *pool;           /**< The pool. */
+    size_t worker;               /**< The index of the worker. */
+} work_thread_t;
+
+/**
+ * @brief Creates a pool with the given number of workers.
+ * @param workers The number of workers, at least 1.
+ * @return The pool, or NULL on allocation failure.
+ */
+work_pool_t *work_pool_create(size_t workers) {
+    if (workers == 0) workers = 1;
+    work_pool_t *pool = calloc(1, sizeof(work_pool_t));
+    if (!pool) return NULL;
+    pool->deques = calloc(workers, sizeof(work_deque_t));
+    if (!pool->deques) {
+        free(pool);
+        return NULL;
+    }
+    pool->workers = workers;
+    for (size_t i = 0; i < workers; i++) pthread_mutex_init(&pool->deques[i].lock, NULL);
+    return pool;
+}
+
+/**
+ * @brief Returns the number of workers of a pool.
+ * @param pool The pool.
+ * @return The number of workers.
+ */
+size_t work_pool_workers(const work_pool_t *pool) {
+    return pool->workers;
+}
+
+/**
+ * @brief Queues an item on a worker.
+ * @param pool The pool.
+ * @param worker The worker whose queue receives the item.
+ * @param item The item.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int work_pool_push(work_pool_t *pool, size_t worker, work_item_t item) {
+    work_deque_t *dq = &pool->deques[worker];
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail == dq->capacity) {
+        if (dq->head > 0) { // Reuse the room left by thieves first.
+            memmove(dq->items, dq->items + dq->head, (dq->tail - dq->head) * sizeof(work_item_t));
+            dq->tail -= dq->head;
+            dq->head = 0;
+        } else {
+            size_t capacity = dq->capacity ? dq->capacity * 2 : 64;
+            work_item_t *items = realloc(dq->items, capacity * sizeof(work_item_t));
+            if (!items) {
+                pthread_mutex_unlock(&dq->lock);
+                return -1;
+            }
+            dq->items = items;
+            dq->capacity = capacity;
+        }
+    }
+    dq->items[dq->tail++] = item;
+    __atomic_add_fetch(&pool->pending, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&dq->lock);
+    return 0;
+}
+
+/**
+ * @brief Takes the newest item of a worker's own queue.
+ * @param dq The queue.
+ * @param item Receives the item.
+ * @return 1 if an item was taken, 0 if the queue was empty.
+ */
+static int pop_own(work_deque_t *dq, work_item_t *item) {
+    int taken = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail > dq->head) {
+        *item = dq->items[--dq->tail];
+        taken = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return taken;
+}
+
+/**
+ * @brief Takes the oldest item of another worker's queue.
+ * @param dq The queue.
+ * @param item Receives the item.
+ * @return 1 if an item was taken, 0 if the queue was empty.
+ */
+static int steal(work_deque_t *dq, work_item_t *item) {
+    int taken = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->tail > dq->head) {
+        *item = dq->items[dq->head++];
+        taken = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return taken;
+}
+
+/**
+ * @brief The loop of one worker: run own items, steal when out of them, stop once nothing is pending.
+ * @param pool The pool.
+ * @param worker The index of the worker.
+ */
+static void work_loop(work_pool_t *pool, size_t worker) {
+    work_item_t item;
+    for (;;) {
+        int found = pop_own(&pool->deques[worker], &item);
+        for (size_t i = 1; !found && i < pool->workers; i++) {
+            found = steal(&pool->deques[(worker + i) % pool->workers], &item);
+        }
+        if (found) {
+            pool->fn(pool, worker, item, pool->ctx);
+            __atomic_sub_fetch(&pool->pending, 1, __ATOMIC_ACQ_REL);
+        } else if (__atomic_load_n(&pool->pending, __ATOMIC_ACQUIRE) == 0) {
+            return;
+        } else {
+            sched_yield(); // The running items may still push more work.
+        }
+    }
+}
+
+/**
+ * @brief The entry point of a worker thread.
+ * @param arg A work_thread_t.
+ * @return NULL.
+ */
+static void *work_thread(void *arg) {
+    work_thread_t *self = arg;
+    work_loop(self->pool, self->worker);
+    return NULL;
+}
+
+/**
+ * @brief Runs every queued item, and the items they push, to completion.
+ * @param pool The pool.
+ * @param fn The task function.
+ * @param ctx Passed to every call of fn.
+ * @return 0 on success, -1 if a thread could not be started.
+ */
+int work_pool_run(work_pool_t *pool, work_fn_t fn, void *ctx) {
+    pool->fn = fn;
+    pool->ctx = ctx;
+
+    size_t extra = pool->workers - 1;
+    pthread_t *threads = malloc((extra ? extra : 1) * sizeof(pthread_t));
+    work_thread_t *args = malloc((extra ? extra : 1) * sizeof(work_thread_t));
+    size_t started = 0;
+    int status = 0;
+    if (!threads || !args) {
+        status = -1;
+        extra = 0;
+    }
+    for (size_t i = 0; i < extra; i++) {
+        args[i] = (work_thread_t){pool, i + 1};
+        if (pthread_create(&threads[started], NULL, work_thread, &args[i]) != 0) {
+            status = -1; // Worker 0 steals whatever the missing workers were given.
+            break;
+        }
+        started++;
+    }
+
+    work_loop(pool, 0);
+    for (size_t i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    free(threads);
+    free(args);
+    return status;
+}
+
+/**
+ * @brief Frees a pool and any items left in it.
+ * @param pool The pool to be freed.
+ */
+void work_pool_free(work_pool_t *pool) {
+    if (!pool) return;
+    for (size_t i = 0; i < pool->workers; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].items);
+    }
+    free(pool->deques);
+    free(pool);
+}
+
+ /** @} */
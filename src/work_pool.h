@@ -0,0 +1,91 @@
+/**
+ * @file work_pool.h
+ * @brief Defines a small work-stealing thread pool for the cycle searches.
+ *
+ * Every worker owns a double-ended queue of work items. A worker pushes and
+ * pops at the back of its own queue (newest first, which keeps the data of a
+ * task that just split itself hot in cache), and an idle worker steals from the
+ * front of another worker's queue (oldest first, which tends to be the largest
+ * remaining piece of work). Items are coarse (an SCC, a start vertex), so each
+ * queue is guarded by a plain mutex rather than a lock-free protocol.
+ */
+
+#ifndef C7D40A96_1E3B_4F85_A2C9_6B0E8D5F31A7
+#define C7D40A96_1E3B_4F85_A2C9_6B0E8D5F31A7
+
+#include <stddef.h>
+
+/**
+ * @struct work_item_t
+ * @brief A unit of work; its meaning is up to the task function.
+ */
+typedef struct {
+    size_t first;                /**< First argument, e.g. an index or an offset. */
+    size_t count;                /**< Second argument, e.g. a length. */
+} work_item_t;
+
+/**
+ * @struct work_pool_t
+ * @brief An opaque type for the pool.
+ */
+typedef struct work_pool_t work_pool_t;
+
+/**
+ * @typedef work_fn_t
+ * @brief Runs one work item on a worker.
+ *
+ * The function may push new items with work_pool_push(pool, worker, ...).
+ *
+ * @param pool The pool.
+ * @param worker The index of the calling worker, in [0, workers).
+ * @param item The item to run.
+ * @param ctx The context passed to work_pool_run().
+ */
+typedef void (*work_fn_t)(work_pool_t *pool, size_t worker, work_item_t item, void *ctx);
+
+/**
+ * @brief Creates a pool with the given number of workers.
+ * @param workers The number of workers, at least 1. Worker 0 is the thread that calls work_pool_run().
+ * @return The pool, or NULL on allocation failure.
+ */
+work_pool_t *work_pool_create(size_t workers);
+
+/**
+ * @brief Returns the number of workers of a pool.
+ * @param pool The pool.
+ * @return The number of workers.
+ */
+size_t work_pool_workers(const work_pool_t *pool);
+
+/**
+ * @brief Queues an item on a worker.
+ *
+ * Before work_pool_run(), any worker index may be used to spread the initial
+ * items; during the run, a task may only push to its own worker.
+ *
+ * @param pool The pool.
+ * @param worker The worker whose queue receives the item.
+ * @param item The item.
+ * @return 0 on success, -1 on allocation failure.
+ */
+int work_pool_push(work_pool_t *pool, size_t worker, work_item_t item);
+
+/**
+ * @brief Runs every queued item, and the items they push, to completion.
+ *
+ * Starts workers - 1 threads and joins them before returning.
+ *
+ * @param pool The pool.
+ * @param fn The task function.
+ * @param ctx Passed to every call of fn.
+ * @return 0 on success, -1 if a thread could not be started (the items still all run, on the threads that did start).
+ */
+int work_pool_run(work_pool_t *pool, work_fn_t fn, void *ctx);
+
+/**
+ * @brief Frees a pool and any items left in it.
+ * @param pool The pool to be freed.
+ */
+void work_pool_free(work_pool_t *pool);
+
+#endif /* C7D40A96_1E3B_4F85_A2C9_6B0E8D5F31A7 */